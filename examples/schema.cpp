@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2011 - 2011, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trades.hpp"
+#include <fudge-cpp/codec.hpp>
+#include <fudge-cpp/fudge.hpp>
+#include <iostream>
+#include <stdexcept>
+
+// An example of using the structs generated from a schema (trades.fsd) by
+// scripts/fudgeschema.py. Each message in the schema becomes a struct that
+// can encode itself in to a fudge::message or a fudge::message_builder, and
+// decode itself from a fudge::message, without any hand written field code.
+// The generated decoder matches the fields by ordinal, so the field names
+// are only there for other readers of the message.
+
+int main ( int argc, char * argv [ ] )
+{
+    try
+    {
+        // The fudge library must be constructed before it's used
+        fudge::fudge::init ( );
+
+        //////////////////////////////////////////////////////////////////////
+        // Populate and encode a trade
+
+        example::Trade trade;
+        trade.id = 20110304;
+        trade.symbol = fudge::string ( "VOD.L" );
+        trade.price = 142.35;
+        trade.buy = true;
+        trade.fills.push_back ( 5000 );
+        trade.fills.push_back ( 2500 );
+        trade.counterparty.name = fudge::string ( "Some Bank" );
+        trade.counterparty.lei = fudge::string ( "5493001KJTIIGC8Y1R12" );
+
+        // The builder writes the fields straight in to wire format
+        fudge::message_builder builder;
+        trade.encode ( builder );
+        std::vector<fudge_byte> bytes;
+        builder.encode ( bytes );
+        std::cout << "Trade encoded as a " << bytes.size ( )
+                  << " byte Fudge message" << std::endl;
+
+        //////////////////////////////////////////////////////////////////////
+        // Decode it again
+
+        fudge::codec codec;
+        fudge::envelope envelope ( codec.decode ( &bytes [ 0 ], bytes.size ( ) ) );
+
+        example::Trade decoded;
+        decoded.decode ( envelope.payload ( ) );
+        std::cout << "Trade " << decoded.id << ": "
+                  << ( decoded.buy ? "bought " : "sold " )
+                  << decoded.fills.size ( ) << " fills of "
+                  << decoded.symbol.convertToStdString ( ) << " at "
+                  << decoded.price << " from "
+                  << decoded.counterparty.name.convertToStdString ( )
+                  << ( decoded.broker ? " with a broker" : " with no broker" )
+                  << std::endl;
+    }
+    catch ( const std::exception & exception )
+    {
+        std::cerr << "FATAL ERROR: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
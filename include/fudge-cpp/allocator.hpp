@@ -0,0 +1,117 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_ALLOCATOR_HPP
+#define INC_FUDGE_CPP_ALLOCATOR_HPP
+
+#include <stddef.h>
+
+namespace fudge {
+
+// The interface through which Fudge-C++ allocates the buffers it owns
+// itself. Fudge-C allocates its messages, fields and strings with malloc and
+// has no way of changing that, so these are only used for Fudge-C++'s own
+// storage (see fudge::init) and by codec::decode when given an arena.
+class allocator
+{
+    public:
+        virtual ~allocator ( );
+
+        // Returns numbytes of memory aligned for any type, throwing a
+        // fudge::exception if there is none left
+        virtual void * allocate ( size_t numbytes ) = 0;
+
+        // Releases memory returned by allocate; numbytes must be the size it
+        // was allocated with
+        virtual void deallocate ( void * memory, size_t numbytes ) = 0;
+
+        // Allocates with malloc and releases with free
+        static allocator & standard ( );
+};
+
+// A bump allocator: allocations are carved one after another out of large
+// chunks and are never released individually. Instead the whole arena is
+// reset in one step, after which its chunks are reused, so an arena reset
+// after every batch of work stops allocating once it has grown large enough.
+// An arena is not thread safe; give each thread its own.
+class arena : public allocator
+{
+    public:
+        static const size_t DefaultChunkSize = 65536;
+
+        explicit arena ( size_t chunksize = DefaultChunkSize );
+        ~arena ( );
+
+        void * allocate ( size_t numbytes );
+
+        // Does nothing; the memory is released by reset
+        void deallocate ( void * memory, size_t numbytes );
+
+        // Releases every allocation at once. Chunks of the standard size are
+        // kept for reuse, those allocated for oversized requests are freed.
+        void reset ( );
+
+        // The number of bytes allocated since the last reset, and the number
+        // held in chunks
+        inline size_t used ( ) const        { return m_used; }
+        inline size_t capacity ( ) const    { return m_capacity; }
+
+    private:
+        arena ( const arena & );
+        arena & operator= ( const arena & );
+
+        struct chunk;
+
+        size_t m_chunksize;
+        chunk * m_chunks;
+        chunk * m_current;
+        chunk * m_large;
+        char * m_position;
+        char * m_end;
+        size_t m_used;
+        size_t m_capacity;
+
+        void nextChunk ( );
+};
+
+// A thread safe allocator that rounds requests up to a power of two size
+// class and recycles released blocks through a free list for each class.
+// Blocks are carved from large slabs, so objects of similar sizes share
+// memory rather than being scattered about the heap. Requests larger than
+// MaxPooledSize go straight to malloc. The slabs are only freed when the
+// pool is destroyed.
+class pool : public allocator
+{
+    public:
+        static const size_t MaxPooledSize = 4096;
+
+        pool ( );
+        ~pool ( );
+
+        void * allocate ( size_t numbytes );
+        void deallocate ( void * memory, size_t numbytes );
+
+    private:
+        pool ( const pool & );
+        pool & operator= ( const pool & );
+
+        struct state;
+        state * m_state;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_ARRAYVIEW_HPP
+#define INC_FUDGE_CPP_ARRAYVIEW_HPP
+
+#include "fudge/types.h"
+#include <stddef.h>
+
+namespace fudge {
+
+// A pointer and element count referring to an array owned by something else
+// (usually the message a field belongs to). As with a slice, an array_view
+// is only valid for as long as the underlying array is.
+template<class Type> class array_view
+{
+    public:
+        typedef const Type * const_iterator;
+
+        array_view ( )
+            : m_data ( 0 )
+            , m_size ( 0 )
+        {
+        }
+
+        array_view ( const Type * data, size_t size )
+            : m_data ( data )
+            , m_size ( size )
+        {
+        }
+
+        inline const Type * data ( ) const                  { return m_data; }
+        inline size_t size ( ) const                        { return m_size; }
+        inline bool empty ( ) const                         { return m_size == 0; }
+
+        inline const Type & operator[] ( size_t index ) const { return m_data [ index ]; }
+
+        inline const_iterator begin ( ) const               { return m_data; }
+        inline const_iterator end ( ) const                 { return m_data + m_size; }
+
+    private:
+        const Type * m_data;
+        size_t m_size;
+};
+
+// The Fudge array type holding elements of Type; only the element types
+// Fudge supports are defined
+template<class Type> struct array_type;
+
+template<> struct array_type<fudge_byte> { static const fudge_type_id id = FUDGE_TYPE_BYTE_ARRAY; };
+template<> struct array_type<fudge_i16>  { static const fudge_type_id id = FUDGE_TYPE_SHORT_ARRAY; };
+template<> struct array_type<fudge_i32>  { static const fudge_type_id id = FUDGE_TYPE_INT_ARRAY; };
+template<> struct array_type<fudge_i64>  { static const fudge_type_id id = FUDGE_TYPE_LONG_ARRAY; };
+template<> struct array_type<fudge_f32>  { static const fudge_type_id id = FUDGE_TYPE_FLOAT_ARRAY; };
+template<> struct array_type<fudge_f64>  { static const fudge_type_id id = FUDGE_TYPE_DOUBLE_ARRAY; };
+
+}
+
+#endif
+
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_BATCHDECODER_HPP
+#define INC_FUDGE_CPP_BATCHDECODER_HPP
+
+#include "fudge-cpp/codec.hpp"
+#include <vector>
+
+namespace fudge {
+
+// Decodes a buffer of envelopes stored back to back (such as one written by
+// codec::encodeBatch or a captured session) across a pool of worker
+// threads. The buffer is first split in to frames using the size in each
+// envelope header; the frames are then shared out between the workers, with
+// workers that run out stealing from those that still have frames left.
+// The decoded envelopes are returned in the order they appear in the buffer.
+//
+// Fudge must have been initialised (see fudge::init) before decoding. The
+// pool's threads are started by the constructor and live as long as the
+// decoder; a decoder must only be used by one thread at a time. Without
+// POSIX thread support all decoding takes place on the calling thread.
+class batch_decoder
+{
+    public:
+        // A zero thread count uses one thread per online processor. The
+        // calling thread counts as one of the pool's threads.
+        explicit batch_decoder ( size_t numthreads = 0 );
+        ~batch_decoder ( );
+
+        size_t numthreads ( ) const;
+
+        // Decodes every envelope in the buffer, appending them to target,
+        // and returns the number decoded. If the buffer does not hold a whole
+        // number of envelopes nothing is decoded and an exception is thrown;
+        // if an envelope cannot be decoded, the exception for it is thrown
+        // once the workers have stopped and target is left unchanged.
+        // Exceptions other than fudge::exception (such as those thrown by a
+        // user type's decoder) are raised by decoding the failed envelope
+        // again on the calling thread.
+        size_t decode ( const fudge_byte * bytes, size_t numbytes, std::vector<envelope> & target );
+
+        // Splits the buffer in to frames, appending the offset of each to
+        // offsets and returning the number found
+        static size_t scan ( const fudge_byte * bytes, size_t numbytes, std::vector<size_t> & offsets );
+
+    private:
+        struct pool;
+        pool * m_pool;
+
+        batch_decoder ( const batch_decoder & );
+        batch_decoder & operator= ( const batch_decoder & );
+};
+
+}
+
+#endif
+
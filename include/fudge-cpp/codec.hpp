@@ -17,15 +17,133 @@
 #define INC_FUDGE_CPP_CODEC_HPP
 
 #include "fudge-cpp/envelope.hpp"
+#include "fudge-cpp/fieldselector.hpp"
+#include "fudge-cpp/gatherlist.hpp"
+#include "fudge-cpp/messageview.hpp"
+#include "fudge/status.h"
+#include <vector>
 
 namespace fudge {
 
+class arena;
+
+// The result of codec::validate: either valid, or the status describing the
+// first problem found and its offset from the start of the encoded bytes
+class validation
+{
+    public:
+        validation ( )
+            : m_status ( FUDGE_OK )
+            , m_offset ( 0 )
+        {
+        }
+
+        validation ( FudgeStatus status, fudge_i32 offset )
+            : m_status ( status )
+            , m_offset ( offset )
+        {
+        }
+
+        inline bool valid ( ) const             { return m_status == FUDGE_OK; }
+        inline FudgeStatus status ( ) const     { return m_status; }
+        inline fudge_i32 offset ( ) const       { return m_offset; }
+
+    private:
+        FudgeStatus m_status;
+        fudge_i32 m_offset;
+};
+
 class codec
 {
     public:
+        // The deepest nesting of submessages that validate accepts by default
+        static const size_t DefaultMaxDepth = 64;
+
+        // The smallest payload that encode will add to a gather_list by
+        // reference rather than by copying
+        static const size_t DefaultGatherThreshold = 1024;
+
         envelope decode ( const fudge_byte * bytes, fudge_i32 numbytes ) const;
 
+        // Reads the header of an encoded envelope; only the header's bytes
+        // need be present. Throws if there are too few bytes or the size is
+        // smaller than the header.
+        envelope_header peekHeader ( const fudge_byte * bytes, fudge_i32 numbytes ) const;
+
+        // Decodes only the fields picked out by the selector. The remaining
+        // fields are skipped using their headers, without their contents
+        // (or those of unselected submessages) being examined.
+        envelope decode ( const fudge_byte * bytes, fudge_i32 numbytes, const field_selector & selector ) const;
+
+        // Decodes in to an arena: the envelope is validated, copied in to
+        // the arena and a view of its message there returned. Nothing is
+        // allocated by Fudge-C or outside the arena, and the whole message
+        // is released in one step when the arena is reset, after which the
+        // view must not be used. Throws if the envelope fails validation.
+        message_view decode ( const fudge_byte * bytes, fudge_i32 numbytes, arena & target ) const;
+
+        // Returns a read-only view of the encoded envelope's message without
+        // decoding it. Only the envelope header is checked; the bytes must
+        // remain valid (and unchanged) for the lifetime of the view.
+        message_view view ( const fudge_byte * bytes, fudge_i32 numbytes ) const;
+
+        // Checks the structure of an encoded envelope without decoding it or
+        // allocating any memory: the envelope size, every field header and
+        // width, and that submessages lie within their parents and are
+        // nested no more than maxdepth deep (reported as FUDGE_OUT_OF_MEMORY,
+        // as decoding them could exhaust the stack). Field contents are not
+        // examined. Envelopes that pass can still be rejected by decode, for
+        // example because of a bad date or an unregistered user type.
+        validation validate ( const fudge_byte * bytes, fudge_i32 numbytes, size_t maxdepth = DefaultMaxDepth ) const;
+
+        // Versions of decode, peekHeader and view that return a status
+        // instead of throwing, for input that is expected to be bad now and
+        // then. Target is only changed when FUDGE_OK is returned.
+        FudgeStatus tryDecode ( envelope & target, const fudge_byte * bytes, fudge_i32 numbytes ) const;
+        FudgeStatus tryPeekHeader ( envelope_header & target, const fudge_byte * bytes, fudge_i32 numbytes ) const;
+        FudgeStatus tryView ( message_view & target, const fudge_byte * bytes, fudge_i32 numbytes ) const;
+
+        // Encodes the envelope in to a newly allocated buffer. It is the job
+        // of the calling code to free this buffer.
         void encode ( const envelope & source, fudge_byte * & bytes, fudge_i32 & numbytes ) const;
+
+        // Encodes the envelope in to a caller supplied buffer of capacity
+        // bytes. If the buffer is large enough the envelope is written,
+        // numbytes is set to the number of bytes written and true is
+        // returned. Otherwise nothing is written, numbytes is set to the
+        // number of bytes required and false is returned.
+        bool encode ( const envelope & source, fudge_byte * bytes, fudge_i32 capacity, fudge_i32 & numbytes ) const;
+
+        // Appends the encoded envelope to the end of buffer, growing it as
+        // required, and returns the number of bytes appended. Reusing the same
+        // buffer (after clearing it) avoids any allocation once its capacity
+        // is large enough.
+        fudge_i32 encode ( const envelope & source, std::vector<fudge_byte> & buffer ) const;
+
+        // Appends the encoded envelope to a gather_list, ready to be written
+        // out with writev, and returns its size. Payloads of at least
+        // threshold bytes that are already held in wire order (strings, byte
+        // arrays and, on big-endian hosts, numeric arrays) are referenced
+        // where they are instead of being copied, so the envelope must not
+        // be changed or released until the list has been written.
+        fudge_i32 encode ( const envelope & source, gather_list & target, size_t threshold = DefaultGatherThreshold ) const;
+
+        // Appends the encoded envelopes to the end of buffer back to back,
+        // so that they can be sent with a single write, and appends the
+        // offset of each within buffer to offsets. The buffer is grown at
+        // most once. Returns the number of bytes appended. Each envelope can
+        // be decoded individually from its offset, or the whole buffer can
+        // be fed to a stream_decoder.
+        size_t encodeBatch ( const envelope * envelopes,
+                             size_t count,
+                             std::vector<fudge_byte> & buffer,
+                             std::vector<size_t> & offsets ) const;
+        size_t encodeBatch ( const std::vector<envelope> & envelopes,
+                             std::vector<fudge_byte> & buffer,
+                             std::vector<size_t> & offsets ) const;
+
+        // Returns the exact number of bytes the envelope will encode to
+        fudge_i32 encodedSize ( const envelope & source ) const;
 };
 
 }
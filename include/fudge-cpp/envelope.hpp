@@ -31,8 +31,29 @@ class envelope
         envelope ( FudgeMsgEnvelope source, bool takeReference = true );
         envelope ( const envelope & source );
         envelope & operator= ( const envelope & source );
+
+#ifdef FUDGE_CPP_HAS_MOVE
+        // Moving takes over the source's reference, leaving it empty
+        envelope ( envelope && source ) noexcept
+            : m_envelope ( source.m_envelope )
+        {
+            source.m_envelope = 0;
+        }
+
+        envelope & operator= ( envelope && source ) noexcept
+        {
+            swap ( source );
+            return *this;
+        }
+#endif
+
         ~envelope ( );
 
+        inline void swap ( envelope & other ) FUDGE_CPP_NOEXCEPT
+        {
+            std::swap ( m_envelope, other.m_envelope );
+        }
+
         fudge_byte directives ( ) const;
         fudge_byte schemaversion ( ) const;
         fudge_i16 taxonomy ( ) const;
@@ -44,6 +65,45 @@ class envelope
         FudgeMsgEnvelope m_envelope;
 };
 
+inline void swap ( envelope & left, envelope & right ) FUDGE_CPP_NOEXCEPT
+{
+    left.swap ( right );
+}
+
+// The fixed size header found at the start of every encoded envelope, as
+// returned by codec::peekHeader. The size is that of the whole encoded
+// envelope, including the header.
+class envelope_header
+{
+    public:
+        envelope_header ( )
+            : m_directives ( 0 )
+            , m_schemaversion ( 0 )
+            , m_taxonomy ( 0 )
+            , m_size ( 0 )
+        {
+        }
+
+        envelope_header ( fudge_byte directives, fudge_byte schemaversion, fudge_i16 taxonomy, fudge_i32 size )
+            : m_directives ( directives )
+            , m_schemaversion ( schemaversion )
+            , m_taxonomy ( taxonomy )
+            , m_size ( size )
+        {
+        }
+
+        inline fudge_byte directives ( ) const      { return m_directives; }
+        inline fudge_byte schemaversion ( ) const   { return m_schemaversion; }
+        inline fudge_i16 taxonomy ( ) const         { return m_taxonomy; }
+        inline fudge_i32 size ( ) const             { return m_size; }
+
+    private:
+        fudge_byte m_directives;
+        fudge_byte m_schemaversion;
+        fudge_i16 m_taxonomy;
+        fudge_i32 m_size;
+};
+
 }
 
 #endif
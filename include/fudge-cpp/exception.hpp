@@ -17,6 +17,7 @@
 #define INC_FUDGE_CPP_EXCEPTION_HPP
 
 #include "fudge-cpp/config.h"
+#include "fudge-cpp/language.hpp"
 #include "fudge/status.h"
 #include <stdexcept>
 
@@ -32,7 +33,15 @@ class exception : public std::runtime_error
 
         FudgeStatus status ( ) const;
 
-        static void throwOnError ( FudgeStatus status );
+        // The check is inline and the throw is not, so checking a status
+        // costs no more than a comparison unless it is an error
+        static inline void throwOnError ( FudgeStatus status )
+        {
+            if ( status != FUDGE_OK )
+                throwError ( status );
+        }
+
+        static void throwError ( FudgeStatus status ) FUDGE_CPP_COLD;
 
     private:
         FudgeStatus m_status;
@@ -16,9 +16,14 @@
 #ifndef INC_FUDGE_CPP_FIELD_HPP
 #define INC_FUDGE_CPP_FIELD_HPP
 
+#include "fudge-cpp/arrayview.hpp"
 #include "fudge-cpp/datetime.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fieldtraits.hpp"
 #include "fudge-cpp/optional.hpp"
+#include "fudge-cpp/slice.hpp"
 #include "fudge-cpp/string.hpp"
+#include "fudge/status.h"
 #include <vector>
 
 namespace fudge {
@@ -59,6 +64,17 @@ class field
         size_t getArray ( std::vector<fudge_f64> & target ) const;
         size_t numelements ( ) const;
 
+        // Return the string's UTF8 bytes or the array's elements in place,
+        // valid for as long as the message holding the field. The array type
+        // must match Type, except that any byte array can be viewed as
+        // fudge_byte elements.
+        slice stringView ( ) const;
+        template<class Type> inline array_view<Type> arrayView ( ) const
+        {
+            return array_view<Type> ( reinterpret_cast<const Type *> ( arrayBytes ( array_type<Type>::id ) ),
+                                      m_field.numbytes / sizeof ( Type ) );
+        }
+
         bool getAsBoolean ( ) const;
         fudge_byte getAsByte ( ) const;
         fudge_i16 getAsInt16 ( ) const;
@@ -69,12 +85,88 @@ class field
 
         string getAsString ( ) const;
 
+        // Versions of the accessors above that return a status instead of
+        // throwing, for code that expects some accesses to fail. On success
+        // they set target and return FUDGE_OK; otherwise they return the
+        // status the accessor would have thrown and leave target alone.
+        FudgeStatus tryGetBoolean ( bool & target ) const;
+        FudgeStatus tryGetByte ( fudge_byte & target ) const;
+        FudgeStatus tryGetInt16 ( fudge_i16 & target ) const;
+        FudgeStatus tryGetInt32 ( fudge_i32 & target ) const;
+        FudgeStatus tryGetInt64 ( fudge_i64 & target ) const;
+        FudgeStatus tryGetFloat32 ( fudge_f32 & target ) const;
+        FudgeStatus tryGetFloat64 ( fudge_f64 & target ) const;
+
+        FudgeStatus tryGetString ( string & target ) const;
+
+        FudgeStatus tryGetMessage ( FudgeMsg & target ) const;
+
+        FudgeStatus tryGetDate ( date & target ) const;
+        FudgeStatus tryGetTime ( time & target ) const;
+        FudgeStatus tryGetDateTime ( datetime & target ) const;
+
+        FudgeStatus tryGetArray ( std::vector<fudge_byte> & target ) const;
+        FudgeStatus tryGetArray ( std::vector<fudge_i16> & target ) const;
+        FudgeStatus tryGetArray ( std::vector<fudge_i32> & target ) const;
+        FudgeStatus tryGetArray ( std::vector<fudge_i64> & target ) const;
+        FudgeStatus tryGetArray ( std::vector<fudge_f32> & target ) const;
+        FudgeStatus tryGetArray ( std::vector<fudge_f64> & target ) const;
+
+        FudgeStatus tryGetAsBoolean ( bool & target ) const;
+        FudgeStatus tryGetAsByte ( fudge_byte & target ) const;
+        FudgeStatus tryGetAsInt16 ( fudge_i16 & target ) const;
+        FudgeStatus tryGetAsInt32 ( fudge_i32 & target ) const;
+        FudgeStatus tryGetAsInt64 ( fudge_i64 & target ) const;
+        FudgeStatus tryGetAsFloat32 ( fudge_f32 & target ) const;
+        FudgeStatus tryGetAsFloat64 ( fudge_f64 & target ) const;
+
+        FudgeStatus tryGetAsString ( string & target ) const;
+
+        // The accessors above for any type with field_traits, chosen at
+        // compile time: get<fudge_i32> is getInt32, getAs<fudge_f64> is
+        // getAsFloat64 and so on. get< std::vector<Type> > and getArray<Type>
+        // copy out the elements of an array of Type.
+        template<class Type> inline Type get ( ) const
+        {
+            if ( m_field.type != field_traits<Type>::id )
+                exception::throwError ( FUDGE_INVALID_TYPE_ACCESSOR );
+            return field_traits<Type>::value ( m_field );
+        }
+
+        template<class Type> inline FudgeStatus tryGet ( Type & target ) const
+        {
+            if ( m_field.type != field_traits<Type>::id )
+                return FUDGE_INVALID_TYPE_ACCESSOR;
+            target = field_traits<Type>::value ( m_field );
+            return FUDGE_OK;
+        }
+
+        template<class Type> inline Type getAs ( ) const
+        {
+            Type value;
+            exception::throwOnError ( field_traits<Type>::coerce ( m_field, value ) );
+            return value;
+        }
+
+        template<class Type> inline FudgeStatus tryGetAs ( Type & target ) const
+        {
+            return field_traits<Type>::coerce ( m_field, target );
+        }
+
+        template<class Type> inline std::vector<Type> getArray ( ) const
+        {
+            return get< std::vector<Type> > ( );
+        }
+
         inline const fudge_byte * bytes ( ) const { return m_field.data.bytes; }
 
         inline const FudgeField & raw ( ) const { return m_field; }
 
     private:
         FudgeField m_field;
+
+        // Throws unless the field is an array of the given type
+        const fudge_byte * arrayBytes ( fudge_type_id type ) const;
 };
 
 }
@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_FIELDBUFFER_HPP
+#define INC_FUDGE_CPP_FIELDBUFFER_HPP
+
+#include "fudge/types.h"
+#include <stddef.h>
+
+namespace fudge {
+
+// Storage for the payload of an array or opaque field, allocated in the way
+// Fudge-C expects to release field data. Filling a buffer in place and then
+// adding it with message::addFieldBuffer hands the storage to the message
+// rather than copying it; the buffer is left empty. Numeric arrays are held
+// in host byte order, as for the other array fields.
+class field_buffer
+{
+    public:
+        field_buffer ( );
+        explicit field_buffer ( size_t numbytes );
+        ~field_buffer ( );
+
+        // Replaces any existing storage with numbytes of uninitialised memory
+        void allocate ( size_t numbytes );
+        void clear ( );
+
+        inline fudge_byte * data ( )                { return m_data; }
+        inline const fudge_byte * data ( ) const    { return m_data; }
+        inline size_t size ( ) const                { return m_numbytes; }
+        inline bool empty ( ) const                 { return ! m_numbytes; }
+
+        // The storage viewed as an array of Type
+        template<class Type> inline Type * elements ( )     { return reinterpret_cast<Type *> ( m_data ); }
+        template<class Type> inline size_t count ( ) const  { return m_numbytes / sizeof ( Type ); }
+
+        // Gives up the storage, which the caller must release with free
+        fudge_byte * release ( );
+
+    private:
+        field_buffer ( const field_buffer & );
+        field_buffer & operator= ( const field_buffer & );
+
+        fudge_byte * m_data;
+        size_t m_numbytes;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_FIELDINDEX_HPP
+#define INC_FUDGE_CPP_FIELDINDEX_HPP
+
+#include "fudge-cpp/message.hpp"
+#include <vector>
+
+namespace fudge {
+
+// Hash tables mapping the names and ordinals of a message's fields to their
+// positions, for constant time lookups on wide messages. Where several
+// fields share a name or ordinal the first is found, as with the message's
+// own accessors. Messages can only grow, so an index becomes invalid as
+// soon as fields are added to the message; refresh then indexes just the
+// new fields. The index keeps the message alive.
+//
+// Messages never build an index themselves: message::getField always goes
+// through Fudge-C. Code making many lookups on a wide message builds one
+// explicitly and checks valid (or calls refresh) after adding fields.
+class field_index
+{
+    public:
+        explicit field_index ( const message & source );
+
+        // False once fields have been added to the message since the index
+        // was built or refreshed
+        bool valid ( ) const;
+        void refresh ( );
+
+        // The number of fields indexed
+        inline size_t size ( ) const    { return m_fields.size ( ); }
+
+        // These throw FUDGE_INVALID_INDEX if the index is no longer valid.
+        // Keys with an ordinal are looked up by it, as with message::getField.
+        bool find ( field & target, const string & name ) const;
+        bool find ( field & target, fudge_i16 ordinal ) const;
+        bool find ( field & target, const field_key & key ) const;
+
+    private:
+        // Table slots hold a field position plus one; zero marks a free slot
+        struct slot
+        {
+            size_t hash;
+            size_t position;
+        };
+
+        message m_message;
+        std::vector<FudgeField> m_fields;
+        std::vector<slot> m_names;
+        std::vector<slot> m_ordinals;
+        size_t m_numnames;
+        size_t m_numordinals;
+
+        static void grow ( std::vector<slot> & table, size_t required );
+
+        void insertName ( size_t position );
+        void insertOrdinal ( size_t position );
+
+        bool findName ( field & target, const fudge_byte * bytes, size_t numbytes, size_t hash, FudgeString interned ) const;
+        void checkValid ( ) const;
+
+        field_index ( const field_index & );
+        field_index & operator= ( const field_index & );
+};
+
+}
+
+#endif
+
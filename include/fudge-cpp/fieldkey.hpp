@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_FIELDKEY_HPP
+#define INC_FUDGE_CPP_FIELDKEY_HPP
+
+#include "fudge-cpp/optional.hpp"
+#include "fudge-cpp/string.hpp"
+
+namespace fudge {
+
+// A field name and/or ordinal prepared once for repeated use with
+// message::addField and message::getField. Names are interned in a process
+// wide table: every key for a given name shares one FudgeString, so keys
+// compare by pointer, and fields added with a key can be found again
+// without comparing their names byte by byte. Making a key for a name that
+// has already been interned does not allocate.
+//
+// Interned names are immortal: the table holds a reference to each for the
+// life of the process and never releases it. Keys refer to the table's
+// entry rather than holding references of their own, so creating, copying
+// and destroying keys never touches a reference count, and keys can be
+// shared between threads.
+//
+// FudgeString reference counts are not atomic, so an interned name must
+// never be retained by two threads at once. Nothing in the library retains
+// one: message::addField gives each field a copy of the name (Fudge-C
+// retains the names of the fields it holds), while message_builder and the
+// lookups only read the name's bytes. Code using name directly should do
+// the same, taking a copyName rather than copying the reference.
+class field_key
+{
+    public:
+        explicit field_key ( const char * name );
+        explicit field_key ( const string & name );
+        explicit field_key ( fudge_i16 ordinal );
+        field_key ( const char * name, fudge_i16 ordinal );
+        field_key ( const string & name, fudge_i16 ordinal );
+
+        inline const optional<string> & name ( ) const      { return *m_name; }
+
+        // A new string holding the name, not shared with any other, or an
+        // empty optional for an ordinal only key
+        optional<string> copyName ( ) const;
+        inline const optional<fudge_i16> & ordinal ( ) const { return m_ordinal; }
+
+        // The interned name as passed to Fudge-C, or null for an ordinal
+        // only key. Not retained; valid for the life of the process.
+        inline FudgeString rawName ( ) const                { return *m_name ? m_name->get ( ).raw ( ) : 0; }
+
+        // A hash of the name's bytes, or zero for an ordinal only key
+        inline size_t hash ( ) const                        { return m_hash; }
+
+        // Returns the interned copy of a name; equal names always give the
+        // same FudgeString. The string belongs to the table and lives for
+        // the life of the process. Can be called from any thread.
+        static const string & intern ( const fudge_byte * bytes, size_t numbytes );
+        static const string & intern ( const string & name );
+
+        // The hash used for names
+        static size_t hashName ( const fudge_byte * bytes, size_t numbytes );
+
+    private:
+        const optional<string> * m_name;
+        optional<fudge_i16> m_ordinal;
+        size_t m_hash;
+
+        void setName ( const fudge_byte * bytes, size_t numbytes );
+};
+
+bool operator== ( const field_key & left, const field_key & right );
+bool operator!= ( const field_key & left, const field_key & right );
+
+}
+
+#endif
+
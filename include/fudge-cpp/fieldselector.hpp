@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_FIELDSELECTOR_HPP
+#define INC_FUDGE_CPP_FIELDSELECTOR_HPP
+
+#include "fudge-cpp/slice.hpp"
+#include "fudge-cpp/string.hpp"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fudge {
+
+// A set of field ordinals and names used to decode only part of a message
+// (see codec::decode). A field is selected if either its ordinal or its name
+// has been added. Submessage fields can be selected whole, or through a
+// nested selector that in turn picks out the submessage's fields; for
+// example, to select field "price" of submessage "quote":
+//
+//     field_selector selector;
+//     selector.select ( string ( "quote" ) ).add ( string ( "price" ) );
+//
+// If the same ordinal or name is both added and selected, whichever was
+// done last applies.
+class field_selector
+{
+    public:
+        field_selector ( );
+        field_selector ( const field_selector & source );
+        field_selector & operator= ( const field_selector & source );
+        ~field_selector ( );
+
+        // Select the whole field; these return the selector so calls can be
+        // chained
+        field_selector & add ( fudge_i16 ordinal );
+        field_selector & add ( const string & name );
+
+        // Select only part of a submessage field, returning the selector
+        // for the submessage's fields. Fields of other types are selected
+        // whole.
+        field_selector & select ( fudge_i16 ordinal );
+        field_selector & select ( const string & name );
+
+        bool empty ( ) const;
+        void clear ( );
+
+        // Returns true if a field with the given ordinal (if hasordinal) and
+        // name (if name's data is not null) is selected. If it is, nested is
+        // set to the selector for its fields, or to null if it is selected
+        // whole. Allocates nothing.
+        bool selects ( bool hasordinal, fudge_i16 ordinal, const slice & name, const field_selector * & nested ) const;
+
+    private:
+        // Selections map to the index of a nested selector plus one, or to
+        // zero for a whole field. Names are held sorted, so that they can be
+        // searched without copying the encoded name.
+        typedef std::pair<std::string, size_t> namedselection;
+
+        std::map<fudge_i16, size_t> m_ordinals;
+        std::vector<namedselection> m_names;
+        std::vector<field_selector *> m_nested;
+
+        size_t & namedSlot ( const string & name );
+        field_selector & nestedSelector ( size_t & slot );
+        const size_t * findName ( const slice & name ) const;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_FIELDTRAITS_HPP
+#define INC_FUDGE_CPP_FIELDTRAITS_HPP
+
+#include "fudge-cpp/arrayview.hpp"
+#include "fudge-cpp/datetime.hpp"
+#include "fudge-cpp/string.hpp"
+#include "fudge/status.h"
+#include <vector>
+
+namespace fudge {
+
+// Maps the C++ type of a field's value to its Fudge type at compile time,
+// so that generic code can use field::get<Type>, field::getAs<Type> and
+// message::addField<Type> without switching on the type at runtime. Each
+// specialisation provides:
+//
+//   value_type  the C++ type itself
+//   id          the Fudge type of fields holding the value
+//   width       the encoded size of the value, or zero if that varies
+//   value       reads the value from a field known to be of type id
+//   coerce      converts a field of any type to the value, in the same way
+//               as the field::getAs methods, returning the status
+//
+// Only the types Fudge itself supports are defined (fudge::message's traits
+// are in message.hpp).
+template<class Type> struct field_traits;
+
+template<> struct field_traits<bool>
+{
+    typedef bool value_type;
+    static const fudge_type_id id = FUDGE_TYPE_BOOLEAN;
+    static const fudge_i32 width = 1;
+    static inline bool value ( const FudgeField & source )          { return source.data.boolean == FUDGE_TRUE; }
+    static FudgeStatus coerce ( const FudgeField & source, bool & target );
+};
+
+template<> struct field_traits<fudge_byte>
+{
+    typedef fudge_byte value_type;
+    static const fudge_type_id id = FUDGE_TYPE_BYTE;
+    static const fudge_i32 width = 1;
+    static inline fudge_byte value ( const FudgeField & source )    { return source.data.byte; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_byte & target );
+};
+
+template<> struct field_traits<fudge_i16>
+{
+    typedef fudge_i16 value_type;
+    static const fudge_type_id id = FUDGE_TYPE_SHORT;
+    static const fudge_i32 width = 2;
+    static inline fudge_i16 value ( const FudgeField & source )     { return source.data.i16; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_i16 & target );
+};
+
+template<> struct field_traits<fudge_i32>
+{
+    typedef fudge_i32 value_type;
+    static const fudge_type_id id = FUDGE_TYPE_INT;
+    static const fudge_i32 width = 4;
+    static inline fudge_i32 value ( const FudgeField & source )     { return source.data.i32; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_i32 & target );
+};
+
+template<> struct field_traits<fudge_i64>
+{
+    typedef fudge_i64 value_type;
+    static const fudge_type_id id = FUDGE_TYPE_LONG;
+    static const fudge_i32 width = 8;
+    static inline fudge_i64 value ( const FudgeField & source )     { return source.data.i64; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_i64 & target );
+};
+
+template<> struct field_traits<fudge_f32>
+{
+    typedef fudge_f32 value_type;
+    static const fudge_type_id id = FUDGE_TYPE_FLOAT;
+    static const fudge_i32 width = 4;
+    static inline fudge_f32 value ( const FudgeField & source )     { return source.data.f32; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_f32 & target );
+};
+
+template<> struct field_traits<fudge_f64>
+{
+    typedef fudge_f64 value_type;
+    static const fudge_type_id id = FUDGE_TYPE_DOUBLE;
+    static const fudge_i32 width = 8;
+    static inline fudge_f64 value ( const FudgeField & source )     { return source.data.f64; }
+    static FudgeStatus coerce ( const FudgeField & source, fudge_f64 & target );
+};
+
+template<> struct field_traits<string>
+{
+    typedef string value_type;
+    static const fudge_type_id id = FUDGE_TYPE_STRING;
+    static const fudge_i32 width = 0;
+    static inline string value ( const FudgeField & source )        { return string ( source.data.string ); }
+    static FudgeStatus coerce ( const FudgeField & source, string & target );
+};
+
+// Dates and times are never coerced from other types
+template<> struct field_traits<date>
+{
+    typedef date value_type;
+    static const fudge_type_id id = FUDGE_TYPE_DATE;
+    static const fudge_i32 width = 4;
+    static inline date value ( const FudgeField & source )          { return date ( source.data.datetime.date ); }
+    static FudgeStatus coerce ( const FudgeField & source, date & target );
+};
+
+template<> struct field_traits<time>
+{
+    typedef time value_type;
+    static const fudge_type_id id = FUDGE_TYPE_TIME;
+    static const fudge_i32 width = 8;
+    static inline time value ( const FudgeField & source )          { return time ( source.data.datetime.time ); }
+    static FudgeStatus coerce ( const FudgeField & source, time & target );
+};
+
+template<> struct field_traits<datetime>
+{
+    typedef datetime value_type;
+    static const fudge_type_id id = FUDGE_TYPE_DATETIME;
+    static const fudge_i32 width = 12;
+    static inline datetime value ( const FudgeField & source )      { return datetime ( source.data.datetime ); }
+    static FudgeStatus coerce ( const FudgeField & source, datetime & target );
+};
+
+// Arrays are copied out of the field, and are only ever read from an array
+// of the same element type
+template<class Element> struct field_traits< std::vector<Element> >
+{
+    typedef std::vector<Element> value_type;
+    static const fudge_type_id id = array_type<Element>::id;
+    static const fudge_i32 width = 0;
+
+    static inline std::vector<Element> value ( const FudgeField & source )
+    {
+        const Element * elements ( reinterpret_cast<const Element *> ( source.data.bytes ) );
+        return std::vector<Element> ( elements, elements + source.numbytes / sizeof ( Element ) );
+    }
+
+    static inline FudgeStatus coerce ( const FudgeField & source, std::vector<Element> & target )
+    {
+        if ( source.type != id )
+            return FUDGE_INVALID_TYPE_COERCION;
+        target = value ( source );
+        return FUDGE_OK;
+    }
+};
+
+template<class Element> const fudge_type_id field_traits< std::vector<Element> >::id;
+template<class Element> const fudge_i32 field_traits< std::vector<Element> >::width;
+
+}
+
+#endif
+
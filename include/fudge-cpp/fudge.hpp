@@ -18,10 +18,23 @@
 
 namespace fudge {
 
+class allocator;
+
 class fudge
 {
     public:
         static void init ( );
+
+        // As init, also making target the allocator for the buffers that
+        // Fudge-C++ allocates itself, such as those of shared_message.
+        // Fudge-C's own allocations always use malloc. The allocator must
+        // be thread safe if the library is used from more than one thread
+        // and must outlive everything allocated from it; it should be set
+        // before any other thread is using the library.
+        static void init ( allocator & target );
+
+        // The allocator given to init, or allocator::standard
+        static allocator & defaultAllocator ( );
 };
 
 }
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_GATHERLIST_HPP
+#define INC_FUDGE_CPP_GATHERLIST_HPP
+
+#include "fudge-cpp/config.h"
+#include "fudge/types.h"
+#include <vector>
+
+#ifdef FUDGE_HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+namespace fudge {
+
+#ifdef FUDGE_HAVE_SYS_UIO_H
+typedef ::iovec iovec;
+#else
+// Layout compatible with the POSIX structure, for platforms without it
+struct iovec
+{
+    void * iov_base;
+    size_t iov_len;
+};
+#endif
+
+// Encoded output held as a list of segments, suitable for passing straight
+// to writev. Some segments are held by the list itself; others refer to
+// memory owned by something else (such as the payload of a large array in
+// a message), which must remain unchanged until the list has been written
+// out or cleared. Clearing a list keeps its storage, so a list that is
+// reused stops allocating once it has grown large enough.
+class gather_list
+{
+    public:
+        gather_list ( );
+
+        // The segments, in the order they should be written. The pointer is
+        // invalidated by any change to the list.
+        const iovec * segments ( ) const;
+        size_t count ( ) const;
+
+        // The total number of bytes in all of the segments
+        inline size_t numbytes ( ) const    { return m_numbytes; }
+
+        void clear ( );
+
+        // Returns space for numbytes bytes at the end of the list, to be
+        // filled in by the caller before the list is next changed
+        fudge_byte * append ( size_t numbytes );
+
+        // Adds a segment referring to bytes held elsewhere
+        void appendBorrowed ( const void * bytes, size_t numbytes );
+
+        // Copies the contents of every segment to the end of target
+        void flatten ( std::vector<fudge_byte> & target ) const;
+
+    private:
+        // Held segments are recorded by their offset in m_storage, which
+        // may move as it grows; the iovecs are built once they're needed.
+        struct segment
+        {
+            const void * borrowed;
+            size_t offset;
+            size_t numbytes;
+        };
+
+        std::vector<segment> m_segments;
+        std::vector<fudge_byte> m_storage;
+        size_t m_used;
+        size_t m_numbytes;
+
+        mutable std::vector<iovec> m_iovecs;
+        mutable bool m_dirty;
+};
+
+}
+
+#endif
+
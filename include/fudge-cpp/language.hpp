@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_LANGUAGE_HPP
+#define INC_FUDGE_CPP_LANGUAGE_HPP
+
+// Language features used by the headers when the compiler offers them. The
+// library itself builds as C++98, so anything depending on these must be
+// defined inline.
+#if __cplusplus >= 201103L || ( defined ( _MSC_VER ) && _MSC_VER >= 1900 )
+#define FUDGE_CPP_HAS_MOVE 1
+#define FUDGE_CPP_NOEXCEPT noexcept
+#else
+#define FUDGE_CPP_NOEXCEPT throw ( )
+#endif
+
+// Marks functions that are rarely called and never return, such as those
+// that only throw, so that the compiler keeps them off the hot path
+#if defined ( __GNUC__ )
+#define FUDGE_CPP_COLD __attribute__ ( ( cold, noinline, noreturn ) )
+#else
+#define FUDGE_CPP_COLD
+#endif
+
+#endif
+
@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_LAYOUT_HPP
+#define INC_FUDGE_CPP_LAYOUT_HPP
+
+#include "fudge-cpp/fieldkey.hpp"
+#include "fudge-cpp/message.hpp"
+#include "fudge-cpp/messagebuilder.hpp"
+
+namespace fudge {
+
+// Layouts map the members of a struct on to the fields of a message, so
+// that the struct can be encoded and decoded without a code generator. Each
+// member is declared once, with FUDGE_CPP_LAYOUT_FIELD, and the declarations
+// are listed in a fudge::layout:
+//
+//     struct quote
+//     {
+//         fudge_i64 id;
+//         fudge_f64 bid;
+//         fudge::string symbol;
+//     };
+//
+//     struct quote_fields
+//     {
+//         FUDGE_CPP_LAYOUT_FIELD( quote, fudge_i64, id, 1 );
+//         FUDGE_CPP_LAYOUT_FIELD( quote, fudge_f64, bid, 2 );
+//         FUDGE_CPP_LAYOUT_FIELD( quote, fudge::string, symbol, 3 );
+//     };
+//
+//     typedef fudge::layout<quote_fields::id,
+//                           quote_fields::bid,
+//                           quote_fields::symbol> quote_layout;
+//
+//     quote_layout::encode ( value, builder );
+//     quote_layout::decode ( message, value );
+//
+// Everything is resolved at compile time: the member pointers and ordinals
+// are template arguments, so encode is a straight run of addField calls and
+// decode matches each field's ordinal against constants, never comparing
+// names. Member types are any with field_traits. Each entry makes a
+// field_key on first use, so its name is interned once and shared, and
+// layout::FixedSize bounds the encoded size of the fixed width members,
+// names included.
+//
+// Encoding never retains the shared name: a message_builder copies its
+// bytes and a fudge::message is given a copy of its own (see field_key), so
+// any number of threads can encode with the same layout.
+//
+// A layout takes up to 16 entries; as a layout can itself be an entry,
+// larger structs are described by nesting layouts.
+
+// Declares an entry named member, for Struct::member of type Type, encoded
+// as a field with the member's name and the ordinal given. Use at namespace
+// or class scope.
+#define FUDGE_CPP_LAYOUT_FIELD( Struct, Type, member, ordinal ) \
+    struct member : ::fudge::layout_field<Struct, Type, &Struct::member, ordinal, member> \
+    { \
+        enum { FixedSize = ::fudge::layout_size<Type, sizeof ( #member ) - 1>::value }; \
+        static inline const char * fieldName ( ) { return #member; } \
+    }
+
+// The most bytes a field of Type with a name of NameSize bytes encodes to,
+// or zero if Type isn't of fixed width. The header is a prefix and type
+// byte, an ordinal and the length of the name.
+template<class Type, size_t NameSize> struct layout_size
+{
+    enum { value = field_traits<Type>::width ? 5 + NameSize + field_traits<Type>::width : 0 };
+};
+
+// The end of a layout: has no fields
+struct layout_end
+{
+    enum { FixedSize = 0 };
+
+    template<class Struct, class Target> static inline void encodeFields ( const Struct &, Target & )
+    {
+    }
+
+    template<class Struct> static inline bool decodeField ( Struct &, const field &, fudge_i16 )
+    {
+        return false;
+    }
+};
+
+// The base of the entries declared by FUDGE_CPP_LAYOUT_FIELD, which supplies
+// Entry::fieldName
+template<class Struct, class Type, Type Struct::*Member, fudge_i16 Ordinal, class Entry> struct layout_field
+{
+    typedef Struct struct_type;
+    typedef Type value_type;
+
+    // The key's name is the interned copy, which is never released
+    static inline const field_key & key ( )
+    {
+        static const field_key value ( Entry::fieldName ( ), Ordinal );
+        return value;
+    }
+
+    static inline const optional<string> & name ( )
+    {
+        return key ( ).name ( );
+    }
+
+    template<class Target> static inline void encodeFields ( const Struct & source, Target & target )
+    {
+        target.addField ( source.*Member, key ( ) );
+    }
+
+    // Integers are coerced, as they are stored in the smallest type that
+    // holds them
+    static inline bool decodeField ( Struct & target, const field & source, fudge_i16 ordinal )
+    {
+        if ( ordinal != Ordinal )
+            return false;
+        target.*Member = source.getAs<Type> ( );
+        return true;
+    }
+};
+
+template<class F1,
+         class F2 = layout_end,
+         class F3 = layout_end,
+         class F4 = layout_end,
+         class F5 = layout_end,
+         class F6 = layout_end,
+         class F7 = layout_end,
+         class F8 = layout_end,
+         class F9 = layout_end,
+         class F10 = layout_end,
+         class F11 = layout_end,
+         class F12 = layout_end,
+         class F13 = layout_end,
+         class F14 = layout_end,
+         class F15 = layout_end,
+         class F16 = layout_end>
+class layout
+{
+    private:
+        typedef layout<F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12, F13, F14, F15, F16> rest;
+
+    public:
+        typedef typename F1::struct_type struct_type;
+
+        enum { FixedSize = F1::FixedSize + rest::FixedSize };
+
+        // Adds the members as fields, in the order they were listed
+        static inline void encode ( const struct_type & source, message & target )
+        {
+            encodeFields ( source, target );
+        }
+
+        static inline void encode ( const struct_type & source, message_builder & target )
+        {
+            encodeFields ( source, target );
+        }
+
+        // Sets the members from the fields with matching ordinals; members
+        // without a field are left as they were
+        static inline void decode ( const message & source, struct_type & target )
+        {
+            source.forEachField ( decoder ( target ) );
+        }
+
+        // The entry interface, used when this layout is listed in another
+        template<class Target> static inline void encodeFields ( const struct_type & source, Target & target )
+        {
+            F1::encodeFields ( source, target );
+            rest::encodeFields ( source, target );
+        }
+
+        static inline bool decodeField ( struct_type & target, const field & source, fudge_i16 ordinal )
+        {
+            return F1::decodeField ( target, source, ordinal ) || rest::decodeField ( target, source, ordinal );
+        }
+
+    private:
+        class decoder
+        {
+            public:
+                explicit decoder ( struct_type & target )
+                    : m_target ( target )
+                {
+                }
+
+                inline void operator() ( const field & source )
+                {
+                    const optional<fudge_i16> ordinal ( source.ordinal ( ) );
+                    if ( ordinal )
+                        decodeField ( m_target, source, *ordinal );
+                }
+
+            private:
+                struct_type & m_target;
+        };
+};
+
+template<> class layout<layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end, layout_end> : public layout_end
+{
+};
+
+}
+
+#endif
+
@@ -17,10 +17,18 @@
 #define INC_FUDGE_CPP_MESSAGE_HPP
 
 #include "fudge-cpp/field.hpp"
+#include "fudge-cpp/fieldbuffer.hpp"
+#include "fudge-cpp/fieldkey.hpp"
+#include "fudge-cpp/language.hpp"
+#include "fudge/status.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <vector>
 
 namespace fudge {
 
+
 class message
 {
     public:
@@ -32,8 +40,29 @@ class message
         message ( const message & source );
         message & operator= ( const message & source );
 
+#ifdef FUDGE_CPP_HAS_MOVE
+        // Moving takes over the source's reference, leaving the source fit
+        // only to be assigned to or destroyed
+        message ( message && source ) noexcept
+            : m_message ( source.m_message )
+        {
+            source.m_message = 0;
+        }
+
+        message & operator= ( message && source ) noexcept
+        {
+            swap ( source );
+            return *this;
+        }
+#endif
+
         ~message ( );
 
+        inline void swap ( message & other ) FUDGE_CPP_NOEXCEPT
+        {
+            std::swap ( m_message, other.m_message );
+        }
+
         size_t size ( ) const;
 
         field getFieldAt ( size_t index ) const;
@@ -43,8 +72,129 @@ class message
         bool getField ( field & target, const string & name ) const;
         bool getField ( field & target, fudge_i16 ordinal ) const;
 
+        // Keys with an ordinal are looked up by it; otherwise fields added
+        // with a key are matched by their interned name without comparing
+        // bytes
+        field getField ( const field_key & key ) const;
+        bool getField ( field & target, const field_key & key ) const;
+
+        // Lookups that return a status rather than throwing: FUDGE_OK having
+        // set target, FUDGE_INVALID_INDEX, FUDGE_INVALID_NAME or
+        // FUDGE_INVALID_ORDINAL if there is no such field, or any other
+        // status Fudge-C reports
+        FudgeStatus tryGetFieldAt ( field & target, size_t index ) const;
+        FudgeStatus tryGetField ( field & target, const string & name ) const;
+        FudgeStatus tryGetField ( field & target, fudge_i16 ordinal ) const;
+        FudgeStatus tryGetField ( field & target, const field_key & key ) const;
+
         void getFields ( std::vector<field> & fields ) const;
 
+        // Iterates over the fields in order by position. begin copies the
+        // fields out of Fudge-C in one go, to a snapshot that copies of the
+        // iterator share, so a full pass costs time in proportion to the
+        // number of fields. Adding fields to the message does not
+        // invalidate iterators: an end iterator marks the number of fields
+        // when it was taken, and positions past the snapshot are fetched
+        // from Fudge-C one at a time as they are reached.
+        class const_iterator
+        {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef field value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const field * pointer;
+                typedef const field & reference;
+
+                const_iterator ( )
+                    : m_message ( 0 )
+                    , m_index ( 0 )
+                    , m_snapshot ( 0 )
+                    , m_fetched ( false )
+                {
+                }
+
+                const_iterator ( const const_iterator & source );
+                const_iterator & operator= ( const const_iterator & source );
+                ~const_iterator ( );
+
+                inline reference operator* ( ) const    { fetch ( ); return m_field; }
+                inline pointer operator-> ( ) const     { fetch ( ); return &m_field; }
+
+                inline const_iterator & operator++ ( )
+                {
+                    ++m_index;
+                    m_fetched = false;
+                    return *this;
+                }
+
+                inline const_iterator operator++ ( int )
+                {
+                    const const_iterator previous ( *this );
+                    ++*this;
+                    return previous;
+                }
+
+                inline bool operator== ( const const_iterator & other ) const
+                {
+                    return m_index == other.m_index && m_message == other.m_message;
+                }
+
+                inline bool operator!= ( const const_iterator & other ) const
+                {
+                    return ! ( *this == other );
+                }
+
+            private:
+                friend class message;
+                struct snapshot;
+
+                // Takes ownership of fields, which may be null
+                const_iterator ( FudgeMsg message, size_t index, snapshot * fields );
+
+                void fetch ( ) const;
+                void release ( );
+
+                FudgeMsg m_message;
+                size_t m_index;
+                snapshot * m_snapshot;
+                mutable field m_field;
+                mutable bool m_fetched;
+        };
+
+        const_iterator begin ( ) const;
+        const_iterator end ( ) const;
+
+        // Calls visitor with each field in order and returns it, as
+        // std::for_each does. Messages of up to LocalFields fields are
+        // visited without allocating; wider ones are copied out of Fudge-C
+        // in one go, to a vector that lasts for the call.
+        template<class Visitor> Visitor forEachField ( Visitor visitor ) const
+        {
+            FudgeField local [ LocalFields ];
+            const size_t count ( localFields ( local ) );
+            if ( count <= LocalFields )
+            {
+                for ( size_t index ( 0 ); index < count; ++index )
+                    visitor ( field ( local [ index ] ) );
+            }
+            else
+            {
+                std::vector<FudgeField> all;
+                allFields ( all );
+                for ( std::vector<FudgeField>::const_iterator it ( all.begin ( ) ); it != all.end ( ); ++it )
+                    visitor ( field ( *it ) );
+            }
+            return visitor;
+        }
+
+        static const size_t LocalFields = 32;
+
+        // Returns the number of bytes the message's fields will occupy when
+        // encoded (not including an envelope header). Nothing is cached, as
+        // a submessage can grow after being added; every call walks the
+        // whole field tree.
+        fudge_i32 encodedSize ( ) const;
+
         void addField ( const optional<string> & name = noname, const optional<fudge_i16> ordinal = noordinal );
 
         void addField ( bool value,       const optional<string> & name = noname, const optional<fudge_i16> ordinal = noordinal );
@@ -91,9 +241,62 @@ class message
                             const optional<string> name = noname,
                             const optional<fudge_i16> ordinal = noordinal );
 
+        // Adds an array or opaque field that takes over the storage held by
+        // buffer instead of copying it, leaving buffer empty. The buffer's
+        // size must be a whole number of elements for a numeric array and
+        // must match the width of a fixed size byte array.
+        void addFieldBuffer ( fudge_type_id type,
+                              field_buffer & buffer,
+                              const optional<string> name = noname,
+                              const optional<fudge_i16> ordinal = noordinal );
+
+        // Adds any of the values accepted by the addField overloads above,
+        // named and/or numbered by key. The field is given its own copy of
+        // the name, as the interned one is shared between threads.
+        template<class Type> inline void addField ( const Type & value, const field_key & key )
+        {
+            addField ( value, key.copyName ( ), key.ordinal ( ) );
+        }
+
+        // Adds a value of any type with field_traits, named explicitly as in
+        // addField<fudge_f64> ( value ), for generic code. As the type can't
+        // be deduced this is never picked in place of the overloads above.
+        template<class Type> inline void addField ( const typename field_traits<Type>::value_type & value,
+                                                    const optional<string> & name = noname,
+                                                    const optional<fudge_i16> ordinal = noordinal )
+        {
+            addField ( value, name, ordinal );
+        }
+
         FudgeMsg raw ( ) const;
     private:
         FudgeMsg m_message;
+
+        // Copies the fields in to target if there are no more than
+        // LocalFields of them; returns the number of fields regardless
+        size_t localFields ( FudgeField * target ) const;
+
+        // Copies every field in to target, for messages too wide for a
+        // local array
+        void allFields ( std::vector<FudgeField> & target ) const;
+
+        FudgeStatus findField ( FudgeField & target, const string & name ) const;
+        FudgeStatus findField ( FudgeField & target, fudge_i16 ordinal ) const;
+        FudgeStatus findField ( FudgeField & target, const field_key & key ) const;
+};
+
+inline void swap ( message & left, message & right ) FUDGE_CPP_NOEXCEPT
+{
+    left.swap ( right );
+}
+
+template<> struct field_traits<message>
+{
+    typedef message value_type;
+    static const fudge_type_id id = FUDGE_TYPE_FUDGE_MSG;
+    static const fudge_i32 width = 0;
+    static inline message value ( const FudgeField & source )       { return message ( source.data.message ); }
+    static FudgeStatus coerce ( const FudgeField & source, message & target );
 };
 
 }
@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_MESSAGEBUILDER_HPP
+#define INC_FUDGE_CPP_MESSAGEBUILDER_HPP
+
+#include "fudge-cpp/message.hpp"
+#include "fudge-cpp/messageview.hpp"
+#include <vector>
+
+namespace fudge {
+
+// Builds messages of the same shape over and over again. Fields are encoded
+// as they are added in to storage owned by the builder, rather than being
+// allocated one by one inside Fudge-C. Resetting the builder empties it but
+// keeps that storage, so once a builder has held a message of a given shape
+// building another of the same shape allocates nothing. The result is
+// encoded with encode, read in place through view or, where a
+// fudge::message is needed, decoded with build.
+//
+// Integers are stored in the smallest type that holds them, as they are by
+// message::addField, so a builder encodes to the same bytes as a message
+// with the same fields.
+class message_builder
+{
+    public:
+        // Estimated bytes per field used by reserve when not given a size
+        static const size_t EstimatedFieldSize = 16;
+
+        message_builder ( );
+        explicit message_builder ( size_t numfields );
+
+        // Removes every field, keeping the storage for the next message
+        void reset ( );
+
+        // Sizes the storage for numfields fields holding numbytes of encoded
+        // fields between them (headers and names included); if numbytes is
+        // zero it is estimated from the number of fields
+        void reserve ( size_t numfields, size_t numbytes = 0 );
+
+        inline size_t size ( ) const        { return m_numfields; }
+        inline bool empty ( ) const         { return ! m_numfields; }
+
+        // The number of bytes the fields will occupy when encoded (without
+        // an envelope header), and the number the storage can hold
+        fudge_i32 encodedSize ( ) const;
+        size_t capacity ( ) const;
+
+        void addField ( const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+
+        void addField ( bool value,       const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_byte value, const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_i16 value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_i32 value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_i64 value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_f32 value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( fudge_f64 value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+
+        void addField ( const message & value,         const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const message_builder & value, const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+
+        void addField ( const std::vector<fudge_byte> & value, const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const std::vector<fudge_i16> & value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const std::vector<fudge_i32> & value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const std::vector<fudge_i64> & value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const std::vector<fudge_f32> & value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const std::vector<fudge_f64> & value,  const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+
+        void addField ( const string & value,   const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const date & value,     const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const time & value,     const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+        void addField ( const datetime & value, const optional<string> & name = message::noname, const optional<fudge_i16> ordinal = message::noordinal );
+
+        // Adds a byte array field of any of the byte array types; the fixed
+        // size types must be given exactly their width
+        void addField ( fudge_type_id type,
+                        const fudge_byte * bytes,
+                        fudge_i32 numbytes,
+                        const optional<string> name = message::noname,
+                        const optional<fudge_i16> ordinal = message::noordinal );
+
+        template<class Type> inline void addField ( const Type & value, const field_key & key )
+        {
+            addField ( value, key.name ( ), key.ordinal ( ) );
+        }
+
+        // The fields built so far, read in place. Valid until the builder is
+        // next changed.
+        message_view view ( ) const;
+
+        // Appends the fields as an envelope to the end of buffer and returns
+        // the number of bytes appended
+        fudge_i32 encode ( std::vector<fudge_byte> & buffer,
+                           fudge_byte directives = 0,
+                           fudge_byte schemaversion = 0,
+                           fudge_i16 taxonomy = 0 ) const;
+
+        // Writes the fields as an envelope in to a caller supplied buffer, in
+        // the same way as codec::encode: returns false, having set numbytes
+        // to the size needed, if the buffer is too small
+        bool encode ( fudge_byte * bytes,
+                      fudge_i32 capacity,
+                      fudge_i32 & numbytes,
+                      fudge_byte directives = 0,
+                      fudge_byte schemaversion = 0,
+                      fudge_i16 taxonomy = 0 ) const;
+
+        // Decodes the fields in to a new fudge::message
+        message build ( ) const;
+
+    private:
+        // The encoded fields, preceded by space for an envelope header
+        std::vector<fudge_byte> m_bytes;
+        size_t m_numfields;
+
+        // Appends the header of a field with numbytes of data and returns
+        // where the data is to be written
+        fudge_byte * appendField ( fudge_type_id type,
+                                   fudge_i32 numbytes,
+                                   const optional<string> & name,
+                                   const optional<fudge_i16> & ordinal );
+
+        void appendInteger ( fudge_i64 value, const optional<string> & name, const optional<fudge_i16> & ordinal );
+        void writeEnvelopeHeader ( fudge_byte * target, fudge_byte directives, fudge_byte schemaversion, fudge_i16 taxonomy ) const;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_MESSAGETEMPLATE_HPP
+#define INC_FUDGE_CPP_MESSAGETEMPLATE_HPP
+
+#include "fudge-cpp/datetime.hpp"
+#include "fudge-cpp/fieldkey.hpp"
+#include "fudge-cpp/message.hpp"
+#include <vector>
+
+namespace fudge {
+
+// An encoded envelope whose fixed width fields can be changed in place. The
+// prototype message is encoded once; fields picked out with addSlot can
+// then be given new values with set, which writes straight over the
+// encoded value, so sending a message that differs from the last in only
+// those fields needs no encoding at all. Fields that aren't slots keep the
+// prototype's values.
+//
+// Integers are stored in the smallest type that holds them when added to a
+// message, so addSlot re-encodes the field at the full width of the slot's
+// type, and any value of that type can be set afterwards.
+class message_template
+{
+    public:
+        message_template ( );
+        explicit message_template ( const message & prototype,
+                                    fudge_byte directives = 0,
+                                    fudge_byte schemaversion = 0,
+                                    fudge_i16 taxonomy = 0 );
+
+        // Makes the first top level field matching the key (by ordinal if
+        // it has one, otherwise by name) a slot of the given type, which
+        // must be FUDGE_TYPE_INT, FUDGE_TYPE_LONG, FUDGE_TYPE_DOUBLE or
+        // FUDGE_TYPE_DATETIME, and returns its index. The field keeps its
+        // prototype value, which must be coercible to the slot's type.
+        // Adding the same field again returns the existing slot.
+        size_t addSlot ( const field_key & key, fudge_type_id type );
+
+        // Overwrites the value of a slot; the value must be of the slot's
+        // type
+        void set ( size_t slot, fudge_i32 value );
+        void set ( size_t slot, fudge_i64 value );
+        void set ( size_t slot, fudge_f64 value );
+        void set ( size_t slot, const datetime & value );
+
+        inline size_t slots ( ) const                       { return m_slots.size ( ); }
+        fudge_type_id slotType ( size_t slot ) const;
+
+        // The encoded envelope, with the values set so far
+        inline const fudge_byte * bytes ( ) const           { return m_bytes.empty ( ) ? 0 : &( m_bytes [ 0 ] ); }
+        inline fudge_i32 numbytes ( ) const                 { return static_cast<fudge_i32> ( m_bytes.size ( ) ); }
+
+    private:
+        struct slot
+        {
+            size_t offset;
+            fudge_type_id type;
+        };
+
+        std::vector<fudge_byte> m_bytes;
+        std::vector<slot> m_slots;
+
+        // Where a slot's value is encoded, having checked the index and type
+        fudge_byte * slotValue ( size_t slot, fudge_type_id type );
+};
+
+}
+
+#endif
+
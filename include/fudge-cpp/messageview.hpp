@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_MESSAGEVIEW_HPP
+#define INC_FUDGE_CPP_MESSAGEVIEW_HPP
+
+#include "fudge-cpp/datetime.hpp"
+#include "fudge-cpp/optional.hpp"
+#include "fudge-cpp/slice.hpp"
+#include "fudge-cpp/string.hpp"
+#include <vector>
+
+namespace fudge {
+
+class message_view;
+
+// A read-only field within an encoded message. Names, strings and arrays
+// are left in the encoded bytes and returned as slices; the accessors
+// otherwise behave exactly as those on fudge::field. Fields of user defined
+// types are presented as their encoded bytes.
+class field_view
+{
+    public:
+        field_view ( );
+
+        optional<string> name ( ) const;
+        optional<fudge_i16> ordinal ( ) const;
+
+        inline bool hasName ( ) const               { return m_hasname; }
+        inline slice nameBytes ( ) const            { return slice ( m_name, m_namelength ); }
+
+        inline fudge_type_id type ( ) const         { return m_type; }
+        inline fudge_i32 numbytes ( ) const         { return m_numbytes; }
+
+        bool getBoolean ( ) const;
+        fudge_byte getByte ( ) const;
+        fudge_i16 getInt16 ( ) const;
+        fudge_i32 getInt32 ( ) const;
+        fudge_i64 getInt64 ( ) const;
+        fudge_f32 getFloat32 ( ) const;
+        fudge_f64 getFloat64 ( ) const;
+
+        // Copies the string in to a fudge::string; getStringBytes returns
+        // the UTF8 bytes in place
+        string getString ( ) const;
+        slice getStringBytes ( ) const;
+
+        message_view getMessage ( ) const;
+
+        date getDate ( ) const;
+        time getTime ( ) const;
+        datetime getDateTime ( ) const;
+
+        // Array elements are big-endian on the wire, so these convert them
+        // in to the target vector
+        size_t getArray ( std::vector<fudge_byte> & target ) const;
+        size_t getArray ( std::vector<fudge_i16> & target ) const;
+        size_t getArray ( std::vector<fudge_i32> & target ) const;
+        size_t getArray ( std::vector<fudge_i64> & target ) const;
+        size_t getArray ( std::vector<fudge_f32> & target ) const;
+        size_t getArray ( std::vector<fudge_f64> & target ) const;
+        size_t numelements ( ) const;
+
+        bool getAsBoolean ( ) const;
+        fudge_byte getAsByte ( ) const;
+        fudge_i16 getAsInt16 ( ) const;
+        fudge_i32 getAsInt32 ( ) const;
+        fudge_i64 getAsInt64 ( ) const;
+        fudge_f32 getAsFloat32 ( ) const;
+        fudge_f64 getAsFloat64 ( ) const;
+
+        string getAsString ( ) const;
+
+        // The encoded field data
+        inline const fudge_byte * bytes ( ) const   { return m_data; }
+
+    private:
+        fudge_type_id m_type;
+        bool m_hasordinal;
+        fudge_i16 m_ordinal;
+        bool m_hasname;
+        const fudge_byte * m_name;
+        size_t m_namelength;
+        const fudge_byte * m_data;
+        fudge_i32 m_numbytes;
+
+        // Returns the field as a Fudge-C field, for use with the Fudge-C
+        // coercion functions. Only valid for non-string and non-message types.
+        // Arrays of multi-byte elements are copied in to storage, converted
+        // to host order.
+        FudgeField raw ( std::vector<fudge_byte> & storage ) const;
+
+        friend class message_view;
+};
+
+// A read-only view of an encoded message (the fields alone, without an
+// envelope header). Nothing is copied: fields are parsed from the encoded
+// bytes as they are accessed, so the bytes must outlive the view and any
+// field_view or slice obtained from it. Malformed bytes cause the accessors
+// to throw a fudge::exception.
+class message_view
+{
+    public:
+        message_view ( );
+        message_view ( const fudge_byte * bytes, fudge_i32 numbytes );
+
+        // The number of fields; counted (once) by walking the field headers
+        size_t size ( ) const;
+
+        field_view getFieldAt ( size_t index ) const;
+        field_view getField ( const string & name ) const;
+        field_view getField ( fudge_i16 ordinal ) const;
+
+        bool getField ( field_view & target, const string & name ) const;
+        bool getField ( field_view & target, fudge_i16 ordinal ) const;
+
+        void getFields ( std::vector<field_view> & fields ) const;
+
+        inline const fudge_byte * bytes ( ) const   { return m_bytes; }
+        inline fudge_i32 numbytes ( ) const         { return m_numbytes; }
+
+    private:
+        const fudge_byte * m_bytes;
+        fudge_i32 m_numbytes;
+        mutable fudge_i32 m_size;
+
+        // Parses the field at offset, returning the offset of the next field
+        fudge_i32 parseField ( fudge_i32 offset, field_view & target ) const;
+};
+
+}
+
+#endif
+
@@ -16,87 +16,169 @@
 #ifndef INC_FUDGE_CPP_OPTIONAL_HPP
 #define INC_FUDGE_CPP_OPTIONAL_HPP
 
+#include "fudge-cpp/language.hpp"
+#include <new>
 #include <stdexcept>
 
 namespace fudge {
 
-template<class T> class optional
+// Types whose copies are plain copies of their bytes. Optionals of these
+// types declare no copy, assignment or destructor of their own, so they
+// are trivially copyable themselves.
+template<class T> struct optional_trivial               { static const bool value = false; };
+template<class T> struct optional_trivial<T *>          { static const bool value = true; };
+template<> struct optional_trivial<bool>                { static const bool value = true; };
+template<> struct optional_trivial<char>                { static const bool value = true; };
+template<> struct optional_trivial<signed char>         { static const bool value = true; };
+template<> struct optional_trivial<unsigned char>       { static const bool value = true; };
+template<> struct optional_trivial<short>               { static const bool value = true; };
+template<> struct optional_trivial<unsigned short>      { static const bool value = true; };
+template<> struct optional_trivial<int>                 { static const bool value = true; };
+template<> struct optional_trivial<unsigned int>        { static const bool value = true; };
+template<> struct optional_trivial<long>                { static const bool value = true; };
+template<> struct optional_trivial<unsigned long>       { static const bool value = true; };
+template<> struct optional_trivial<float>               { static const bool value = true; };
+template<> struct optional_trivial<double>              { static const bool value = true; };
+template<> struct optional_trivial<long double>         { static const bool value = true; };
+#ifdef FUDGE_CPP_HAS_MOVE
+template<> struct optional_trivial<long long>           { static const bool value = true; };
+template<> struct optional_trivial<unsigned long long>  { static const bool value = true; };
+#endif
+
+// Storage for an optional's value. Trivial types are held as a plain
+// member, value initialised while unset, leaving the compiler generated
+// copy and destructor in place.
+template<class T, bool Trivial = optional_trivial<T>::value> class optional_storage
 {
-    public:
-        optional ( )
-            : m_payload ( 0 )
+    protected:
+        optional_storage ( )
+            : m_value ( )
+            , m_set ( false )
         {
         }
 
-        optional ( const T & value )
-            : m_payload ( new Payload )
+        explicit optional_storage ( const T & value )
+            : m_value ( value )
+            , m_set ( true )
         {
-            m_payload->count = 1;
-            m_payload->value = value;
         }
 
-        optional ( const optional & source )
-            : m_payload ( source.m_payload )
+        inline bool isSet ( ) const     { return m_set; }
+        inline T & value ( ) const      { return m_value; }
+
+    private:
+        mutable T m_value;
+        bool m_set;
+};
+
+// Other types are constructed in aligned storage with placement new, so an
+// unset optional never constructs a T
+template<class T> class optional_storage<T, false>
+{
+    protected:
+        optional_storage ( )
+            : m_set ( false )
         {
-            if ( m_payload )
-                ++( m_payload->count );
         }
 
-        optional & operator= ( const optional & source )
+        explicit optional_storage ( const T & value )
+            : m_set ( true )
+        {
+            new ( m_storage.bytes ) T ( value );
+        }
+
+        optional_storage ( const optional_storage & source )
+            : m_set ( source.m_set )
+        {
+            if ( m_set )
+                new ( m_storage.bytes ) T ( source.value ( ) );
+        }
+
+        optional_storage & operator= ( const optional_storage & source )
         {
             if ( this != &source )
             {
-                release ( );
-                m_payload = source.m_payload;
-                retain ( );
+                if ( m_set && source.m_set )
+                    value ( ) = source.value ( );
+                else
+                {
+                    reset ( );
+                    if ( source.m_set )
+                    {
+                        new ( m_storage.bytes ) T ( source.value ( ) );
+                        m_set = true;
+                    }
+                }
             }
             return *this;
         }
 
-        ~optional ( )
+        ~optional_storage ( )
         {
-            release ( );
+            reset ( );
         }
 
-        T & get ( ) const
+        inline bool isSet ( ) const     { return m_set; }
+
+        inline T & value ( ) const
         {
-            if ( ! m_payload )
-                throw std::runtime_error ( "Deferenced NULL fudge::optional" );
-            return m_payload->value;
+            return *reinterpret_cast<T *> ( m_storage.bytes );
         }
 
-        T & operator* ( ) const
+    private:
+        // Space for the value, aligned as strictly as any built in type
+        union storage
         {
-            return get ( );
+            char bytes [ sizeof ( T ) ];
+            long double aligndouble;
+            long alignlong;
+            void * alignpointer;
+            void ( *alignfunction ) ( );
+        };
+
+        mutable storage m_storage;
+        bool m_set;
+
+        void reset ( )
+        {
+            if ( m_set )
+            {
+                value ( ).~T ( );
+                m_set = false;
+            }
         }
+};
 
-        operator bool ( ) const
+// An optional value, held inline: constructing or copying an optional never
+// allocates, and copies hold their own copy of the value. Optionals of
+// built in types and pointers are trivially copyable.
+template<class T> class optional : private optional_storage<T>
+{
+    public:
+        optional ( )
         {
-            return m_payload != 0;
         }
 
-    private:
-        struct Payload
+        optional ( const T & value )
+            : optional_storage<T> ( value )
         {
-            T value;
-            int count;
-        };
+        }
 
-        Payload * m_payload;
+        T & get ( ) const
+        {
+            if ( ! this->isSet ( ) )
+                throw std::runtime_error ( "Deferenced NULL fudge::optional" );
+            return this->value ( );
+        }
 
-        void retain ( )
+        T & operator* ( ) const
         {
-            if ( m_payload )
-                ++( m_payload->count );
+            return get ( );
         }
 
-        void release ( )
+        operator bool ( ) const
         {
-            if ( m_payload )
-            {
-                if ( --( m_payload->count ) < 1 )
-                    delete m_payload;
-            }
+            return this->isSet ( );
         }
 };
 
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_SHAREDMESSAGE_HPP
+#define INC_FUDGE_CPP_SHAREDMESSAGE_HPP
+
+#include "fudge-cpp/message.hpp"
+#include "fudge-cpp/messageview.hpp"
+
+namespace fudge {
+
+// An immutable message that can be handed to any number of threads. Freezing
+// a message encodes the whole tree once in to a buffer that is never changed
+// again. Copies of a shared_message share that buffer through an atomic
+// reference count, and reading it through the message_view touches neither
+// Fudge-C reference counts nor any lazily filled cache, so threads can read
+// and copy the same shared_message without locking. A thread that needs a
+// fudge::message of its own can thaw one.
+class shared_message
+{
+    public:
+        // An empty message
+        shared_message ( );
+        explicit shared_message ( const message & source );
+
+        shared_message ( const shared_message & source );
+        shared_message & operator= ( const shared_message & source );
+        ~shared_message ( );
+
+        inline void swap ( shared_message & other ) FUDGE_CPP_NOEXCEPT
+        {
+            block * temp ( m_block );
+            m_block = other.m_block;
+            other.m_block = temp;
+        }
+
+        // The frozen fields; valid for as long as this shared_message
+        const message_view & view ( ) const;
+
+        // Decodes a new, mutable copy of the message
+        message thaw ( ) const;
+
+        // The frozen message as an encoded envelope
+        const fudge_byte * bytes ( ) const;
+        fudge_i32 numbytes ( ) const;
+
+        // The number of shared_message objects sharing the buffer (zero for
+        // an empty message). Only a snapshot while other threads hold copies.
+        long useCount ( ) const;
+
+    private:
+        struct block;
+        block * m_block;
+
+        void release ( );
+};
+
+inline void swap ( shared_message & left, shared_message & right ) FUDGE_CPP_NOEXCEPT
+{
+    left.swap ( right );
+}
+
+}
+
+#endif
+
@@ -0,0 +1,82 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_SLICE_HPP
+#define INC_FUDGE_CPP_SLICE_HPP
+
+#include "fudge/types.h"
+#include <string>
+#include <string.h>
+
+namespace fudge {
+
+// A pointer and length referring to bytes owned by something else (usually
+// an encoded message buffer). A slice is only valid for as long as the
+// underlying bytes are.
+class slice
+{
+    public:
+        slice ( )
+            : m_data ( 0 )
+            , m_size ( 0 )
+        {
+        }
+
+        slice ( const fudge_byte * data, size_t size )
+            : m_data ( data )
+            , m_size ( size )
+        {
+        }
+
+        inline const fudge_byte * data ( ) const    { return m_data; }
+        inline size_t size ( ) const                { return m_size; }
+        inline bool empty ( ) const                 { return m_size == 0; }
+
+        // Copies the bytes in to a std::string
+        std::string str ( ) const
+        {
+            return m_size ? std::string ( reinterpret_cast<const char *> ( m_data ), m_size ) : std::string ( );
+        }
+
+    private:
+        const fudge_byte * m_data;
+        size_t m_size;
+};
+
+inline bool operator== ( const slice & left, const slice & right )
+{
+    return left.size ( ) == right.size ( ) && ( left.empty ( ) || memcmp ( left.data ( ), right.data ( ), left.size ( ) ) == 0 );
+}
+
+inline bool operator!= ( const slice & left, const slice & right )
+{
+    return ! ( left == right );
+}
+
+// Compares the slice's bytes with a NUL terminated C string
+inline bool operator== ( const slice & left, const char * right )
+{
+    return right && left == slice ( reinterpret_cast<const fudge_byte *> ( right ), strlen ( right ) );
+}
+
+inline bool operator!= ( const slice & left, const char * right )
+{
+    return ! ( left == right );
+}
+
+}
+
+#endif
+
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_STREAMDECODER_HPP
+#define INC_FUDGE_CPP_STREAMDECODER_HPP
+
+#include "fudge-cpp/codec.hpp"
+#include <vector>
+
+namespace fudge {
+
+// Frames and decodes envelopes from a stream of arbitrarily sized chunks,
+// using the size held in each envelope header. Chunks are decoded in place
+// where possible: only the bytes of an envelope that straddles a chunk
+// boundary are copied (in to an internal buffer).
+//
+// A chunk passed to push must remain valid until the next call to push or
+// until next returns false, whichever comes first.
+class stream_decoder
+{
+    public:
+        stream_decoder ( );
+
+        // Makes a chunk of bytes available for decoding. Any unconsumed bytes
+        // from the previous chunk are copied before the new chunk is used.
+        void push ( const fudge_byte * bytes, size_t numbytes );
+
+        // Decodes the next complete envelope in the stream. Returns false if
+        // the stream does not yet hold a complete envelope. If the envelope
+        // cannot be decoded the exception is thrown and the stream remains
+        // positioned at the start of that envelope.
+        bool next ( envelope & target );
+
+        // The number of bytes received but not yet decoded
+        size_t pending ( ) const;
+
+        // Discards all pending bytes, including any partial envelope
+        void reset ( );
+
+    private:
+        codec m_codec;
+
+        const fudge_byte * m_chunk;
+        size_t m_chunksize;
+        size_t m_chunkoffset;
+
+        std::vector<fudge_byte> m_partial;
+
+        void fillPartial ( size_t target );
+        void storeRemainder ( );
+};
+
+}
+
+#endif
+
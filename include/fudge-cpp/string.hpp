@@ -16,7 +16,10 @@
 #ifndef INC_FUDGE_CPP_STRING_HPP
 #define INC_FUDGE_CPP_STRING_HPP
 
+#include "fudge-cpp/language.hpp"
+#include "fudge/status.h"
 #include "fudge/types.h"
+#include <algorithm>
 #include <string>
 
 namespace fudge {
@@ -47,8 +50,28 @@ class string
         string ( const string & source );
         string & operator= ( const string & source );
 
+#ifdef FUDGE_CPP_HAS_MOVE
+        // Moving takes over the source's reference, leaving it a NULL string
+        string ( string && source ) noexcept
+            : m_string ( source.m_string )
+        {
+            source.m_string = 0;
+        }
+
+        string & operator= ( string && source ) noexcept
+        {
+            swap ( source );
+            return *this;
+        }
+#endif
+
         ~string ( );
 
+        inline void swap ( string & other ) FUDGE_CPP_NOEXCEPT
+        {
+            std::swap ( m_string, other.m_string );
+        }
+
         size_t size ( ) const;
         const fudge_byte * data ( ) const;
 
@@ -65,12 +88,25 @@ class string
         // is returned.
         std::string convertToStdString ( ) const;
 
+        // Versions of the Unicode constructor and the conversion methods
+        // that return a status instead of throwing, for converting text that
+        // may well be invalid. tryCreate only changes target on success.
+        static FudgeStatus tryCreate ( string & target, const fudge_byte * bytes, size_t numbytes, UnicodeType type );
+        FudgeStatus tryConvertToASCIIZ ( char * & string ) const;
+        FudgeStatus tryConvertToUTF16 ( fudge_byte * & bytes, size_t & numbytes ) const;
+        FudgeStatus tryConvertToUTF32 ( fudge_byte * & bytes, size_t & numbytes ) const;
+
         const FudgeString raw ( ) const;
 
     private:
         FudgeString m_string;
 };
 
+inline void swap ( string & left, string & right ) FUDGE_CPP_NOEXCEPT
+{
+    left.swap ( right );
+}
+
 bool operator< ( const string & left, const string & right );
 bool operator> ( const string & left, const string & right );
 bool operator== ( const string & left, const string & right );
@@ -0,0 +1,423 @@
+#!/usr/bin/python -t
+
+# Copyright (C) 2010 - 2010, Vrai Stacey.
+#
+# Part of the Fudge-Cpp distribution.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generates C++ structs, and the code to encode and decode them, from a
+# schema describing a set of Fudge messages. A schema looks like:
+#
+#     # Comments run to the end of the line
+#     namespace example::trades
+#
+#     message Party
+#     {
+#         string name = 1;
+#         optional string lei;
+#     }
+#
+#     message Trade
+#     {
+#         i64 id = 1;
+#         f64 price;
+#         i32[] fills;
+#         Party counterparty = 10;
+#         optional datetime settled;
+#     }
+#
+# Field types are bool, byte, i16, i32, i64, f32, f64, string, date, time,
+# datetime, arrays of byte to f64 (written type[]) and any message defined
+# earlier in the schema. Fields without an ordinal take the one after the
+# previous field's. Running
+#
+#     fudgeschema.py [-o directory] trades.fsd
+#
+# writes trades.hpp and trades.cpp. Each message becomes a struct with:
+#
+#     encode ( fudge::message & )          adds the fields by name and ordinal
+#     encode ( fudge::message_builder & )  the same, straight to wire bytes
+#     decode ( const fudge::message & )    reads the fields back
+#
+# The decoder matches fields by ordinal alone, through a switch fixed when
+# the code is generated, so it never compares field names. Fields with
+# ordinals it doesn't know are skipped; a missing required field throws a
+# fudge::exception (FUDGE_INVALID_ORDINAL).
+
+import optparse, os, re, sys
+
+_tokenReEx = re.compile ( r'\s*(?:(#[^\n]*)|([A-Za-z_][A-Za-z0-9_]*(?:::[A-Za-z_][A-Za-z0-9_]*)*)|(-?\d+)|(\[\])|([{}=;])|(\S))' )
+_identifierReEx = re.compile ( r'^[A-Za-z_][A-Za-z0-9_]*$' )
+
+# Schema type -> C++ type, for types held by value. Scalars are read with
+# getAs, as Fudge-C stores integers in the smallest type that fits them.
+_scalarTypes = { 'bool'     : 'bool',
+                 'byte'     : 'fudge_byte',
+                 'i16'      : 'fudge_i16',
+                 'i32'      : 'fudge_i32',
+                 'i64'      : 'fudge_i64',
+                 'f32'      : 'fudge_f32',
+                 'f64'      : 'fudge_f64' }
+_objectTypes = { 'string'   : 'fudge::string',
+                 'date'     : 'fudge::date',
+                 'time'     : 'fudge::time',
+                 'datetime' : 'fudge::datetime' }
+_arrayTypes = [ 'byte', 'i16', 'i32', 'i64', 'f32', 'f64' ]
+
+# Names the generated code uses itself, and so can't be used for fields
+_reservedNames = set ( [ 'target', 'source', 'field', 'ordinal', 'last', 'found', 'value', 'submessage',
+                         'encode', 'decode', 'fudge', 'std' ] )
+_keywords = set ( '''and and_eq asm auto bitand bitor bool break case catch char class compl const
+                     const_cast continue default delete do double dynamic_cast else enum explicit
+                     export extern false float for friend goto if inline int long mutable namespace
+                     new not not_eq operator or or_eq private protected public register
+                     reinterpret_cast return short signed sizeof static static_cast struct switch
+                     template this throw true try typedef typeid typename union unsigned using
+                     virtual void volatile wchar_t while xor xor_eq'''.split ( ) )
+
+class SchemaError ( Exception ):
+    def __init__ ( self, filename, line, message ):
+        Exception.__init__ ( self, '%s:%d: %s' % ( filename, line, message ) )
+
+class Field:
+    def __init__ ( self, name, type, isarray, optional, ordinal ):
+        self.name = name
+        self.type = type
+        self.isarray = isarray
+        self.optional = optional
+        self.ordinal = ordinal
+        self.message = None
+
+    def valueType ( self ):
+        if self.isarray:
+            return 'std::vector<%s>' % _scalarTypes [ self.type ]
+        if self.message:
+            return self.message.name
+        return _scalarTypes.get ( self.type ) or _objectTypes [ self.type ]
+
+    def memberType ( self ):
+        if self.optional:
+            return 'fudge::optional<%s>' % self.valueType ( )
+        return self.valueType ( )
+
+    def initialiser ( self ):
+        if self.optional or self.isarray or not self.type in _scalarTypes:
+            return None
+        if self.type == 'bool':
+            return 'false'
+        return '0'
+
+    def reader ( self ):
+        if self.type in _scalarTypes and not self.isarray:
+            return 'it->getAs<%s> ( )' % self.valueType ( )
+        if self.isarray:
+            return 'it->get< %s > ( )' % self.valueType ( )
+        return 'it->get<%s> ( )' % self.valueType ( )
+
+class Message:
+    def __init__ ( self, name ):
+        self.name = name
+        self.fields = [ ]
+
+    def required ( self ):
+        return [ field for field in self.fields if not field.optional ]
+
+    def nameConstant ( self, field ):
+        return '%s_%s' % ( self.name, field.name )
+
+class Schema:
+    def __init__ ( self, filename ):
+        self.filename = filename
+        self.namespace = [ ]
+        self.messages = [ ]
+
+    def findMessage ( self, name ):
+        for message in self.messages:
+            if message.name == name:
+                return message
+        return None
+
+def Tokenise ( filename, text ):
+    tokens = [ ]
+    line = 1
+    counted = 0
+    for match in _tokenReEx.finditer ( text ):
+        # Skip comments, counting lines up to the start of each token
+        if match.group ( 1 ):
+            continue
+        start = match.start ( match.lastindex )
+        line += text.count ( '\n', counted, start )
+        counted = start
+        if match.group ( 6 ):
+            raise SchemaError ( filename, line, 'unexpected character "%s"' % match.group ( 6 ) )
+        tokens.append ( ( match.group ( match.lastindex ), line ) )
+    return tokens
+
+class Parser:
+    def __init__ ( self, filename, tokens ):
+        self.filename = filename
+        self.tokens = tokens
+        self.index = 0
+
+    def error ( self, message ):
+        if self.index < len ( self.tokens ):
+            line = self.tokens [ self.index ] [ 1 ]
+        elif self.tokens:
+            line = self.tokens [ -1 ] [ 1 ]
+        else:
+            line = 1
+        raise SchemaError ( self.filename, line, message )
+
+    def peek ( self ):
+        if self.index < len ( self.tokens ):
+            return self.tokens [ self.index ] [ 0 ]
+        return None
+
+    def next ( self, expected = None ):
+        token = self.peek ( )
+        if token is None:
+            self.error ( 'unexpected end of schema' )
+        if expected and token != expected:
+            self.error ( 'expected "%s", found "%s"' % ( expected, token ) )
+        self.index += 1
+        return token
+
+    def identifier ( self, what ):
+        token = self.next ( )
+        if not _identifierReEx.match ( token ) or token in _keywords:
+            self.index -= 1
+            self.error ( 'invalid %s "%s"' % ( what, token ) )
+        return token
+
+    def parse ( self ):
+        schema = Schema ( self.filename )
+        if self.peek ( ) == 'namespace':
+            self.next ( )
+            schema.namespace = self.next ( ).split ( '::' )
+            for part in schema.namespace:
+                if part in _keywords:
+                    self.index -= 1
+                    self.error ( 'invalid namespace "%s"' % part )
+        while self.peek ( ) is not None:
+            self.next ( 'message' )
+            name = self.identifier ( 'message name' )
+            if schema.findMessage ( name ) or name in _scalarTypes or name in _objectTypes:
+                self.index -= 1
+                self.error ( 'message "%s" is already defined' % name )
+            message = Message ( name )
+            self.next ( '{' )
+            while self.peek ( ) != '}':
+                self.parseField ( schema, message )
+            self.next ( '}' )
+            schema.messages.append ( message )
+        return schema
+
+    def parseField ( self, schema, message ):
+        optional = self.peek ( ) == 'optional'
+        if optional:
+            self.next ( )
+
+        type = self.next ( )
+        isarray = self.peek ( ) == '[]'
+        if isarray:
+            self.next ( )
+            if not type in _arrayTypes:
+                self.index -= 2
+                self.error ( 'no array type for "%s"' % type )
+        submessage = None
+        if not type in _scalarTypes and not type in _objectTypes:
+            submessage = schema.findMessage ( type )
+            if not submessage:
+                self.index -= 1
+                self.error ( 'unknown type "%s"' % type )
+
+        name = self.identifier ( 'field name' )
+        if name in _reservedNames or name == message.name:
+            self.index -= 1
+            self.error ( 'field name "%s" is reserved' % name )
+        if [ field for field in message.fields if field.name == name ]:
+            self.index -= 1
+            self.error ( 'duplicate field "%s"' % name )
+
+        if self.peek ( ) == '=':
+            self.next ( )
+            token = self.next ( )
+            if not re.match ( r'^-?\d+$', token ) or not -32768 <= int ( token ) <= 32767:
+                self.index -= 1
+                self.error ( 'invalid ordinal "%s"' % token )
+            ordinal = int ( token )
+        elif message.fields:
+            ordinal = message.fields [ -1 ].ordinal + 1
+        else:
+            ordinal = 1
+        if [ field for field in message.fields if field.ordinal == ordinal ]:
+            self.index -= 1
+            self.error ( 'duplicate ordinal %d for field "%s"' % ( ordinal, name ) )
+        self.next ( ';' )
+
+        field = Field ( name, type, isarray, optional, ordinal )
+        field.message = submessage
+        message.fields.append ( field )
+
+def WriteHeader ( schema, base, output ):
+    guard = 'INC_%s_HPP' % re.sub ( '[^A-Za-z0-9]', '_', base ).upper ( )
+    output.write ( '// Generated by fudgeschema.py from %s - do not edit\n\n' % os.path.basename ( schema.filename ) )
+    output.write ( '#ifndef %s\n#define %s\n\n' % ( guard, guard ) )
+    output.write ( '#include <fudge-cpp/message.hpp>\n' )
+    output.write ( '#include <fudge-cpp/messagebuilder.hpp>\n' )
+    output.write ( '#include <fudge-cpp/optional.hpp>\n' )
+    output.write ( '#include <vector>\n\n' )
+    for part in schema.namespace:
+        output.write ( 'namespace %s {\n' % part )
+    if schema.namespace:
+        output.write ( '\n' )
+
+    for message in schema.messages:
+        output.write ( 'struct %s\n{\n' % message.name )
+        for field in message.fields:
+            output.write ( '    %s %s;\n' % ( field.memberType ( ), field.name ) )
+        output.write ( '\n    %s ( );\n\n' % message.name )
+        output.write ( '    void encode ( fudge::message & target ) const;\n' )
+        output.write ( '    void encode ( fudge::message_builder & target ) const;\n' )
+        output.write ( '    void decode ( const fudge::message & source );\n' )
+        output.write ( '};\n\n' )
+
+    for part in schema.namespace:
+        output.write ( '}\n' )
+    if schema.namespace:
+        output.write ( '\n' )
+    output.write ( '#endif\n\n' )
+
+def WriteEncoder ( message, targettype, output ):
+    output.write ( 'void %s::encode ( %s & target ) const\n{\n' % ( message.name, targettype ) )
+    for field in message.fields:
+        key = message.nameConstant ( field )
+        if field.message:
+            value = field.name
+            if field.optional:
+                output.write ( '    if ( %s )\n' % field.name )
+                value += '.get ( )'
+            output.write ( '    {\n' )
+            output.write ( '        %s submessage;\n' % targettype )
+            output.write ( '        %s.encode ( submessage );\n' % value )
+            output.write ( '        target.addField ( submessage, %s );\n' % key )
+            output.write ( '    }\n' )
+        elif field.optional:
+            output.write ( '    if ( %s )\n' % field.name )
+            output.write ( '        target.addField ( *%s, %s );\n' % ( field.name, key ) )
+        else:
+            output.write ( '    target.addField ( %s, %s );\n' % ( field.name, key ) )
+    output.write ( '}\n\n' )
+
+def WriteDecoder ( message, output ):
+    required = message.required ( )
+    output.write ( 'void %s::decode ( const fudge::message & source )\n{\n' % message.name )
+    for field in message.fields:
+        if field.optional:
+            output.write ( '    %s = %s ( );\n' % ( field.name, field.memberType ( ) ) )
+    if required:
+        output.write ( '    bool found [ %d ] = { false };\n' % len ( required ) )
+    if message.fields:
+        output.write ( '\n    for ( fudge::message::const_iterator it ( source.begin ( ) ), last ( source.end ( ) ); it != last; ++it )\n' )
+        output.write ( '    {\n' )
+        output.write ( '        const fudge::optional<fudge_i16> ordinal ( it->ordinal ( ) );\n' )
+        output.write ( '        if ( ! ordinal )\n            continue;\n\n' )
+        output.write ( '        switch ( *ordinal )\n        {\n' )
+        for field in message.fields:
+            output.write ( '            case %d:\n' % field.ordinal )
+            if field.message and field.optional:
+                output.write ( '            {\n' )
+                output.write ( '                %s value;\n' % field.valueType ( ) )
+                output.write ( '                value.decode ( it->get<fudge::message> ( ) );\n' )
+                output.write ( '                %s = value;\n' % field.name )
+                output.write ( '                break;\n' )
+                output.write ( '            }\n' )
+                continue
+            if field.message:
+                output.write ( '                %s.decode ( it->get<fudge::message> ( ) );\n' % field.name )
+            else:
+                output.write ( '                %s = %s;\n' % ( field.name, field.reader ( ) ) )
+            if not field.optional:
+                output.write ( '                found [ %d ] = true;\n' % required.index ( field ) )
+            output.write ( '                break;\n' )
+        output.write ( '        }\n    }\n' )
+    if required:
+        output.write ( '\n    for ( size_t index ( 0 ); index < %d; ++index )\n' % len ( required ) )
+        output.write ( '        if ( ! found [ index ] )\n' )
+        output.write ( '            throw fudge::exception ( FUDGE_INVALID_ORDINAL );\n' )
+    output.write ( '}\n\n' )
+
+def WriteSource ( schema, base, output ):
+    output.write ( '// Generated by fudgeschema.py from %s - do not edit\n\n' % os.path.basename ( schema.filename ) )
+    output.write ( '#include "%s.hpp"\n' % base )
+    output.write ( '#include <fudge-cpp/exception.hpp>\n' )
+    output.write ( '#include <fudge-cpp/fieldkey.hpp>\n\n' )
+
+    # Field keys are made once rather than on every encode. Their names are
+    # interned, so builders copy only the bytes; messages take a copy each.
+    output.write ( 'namespace\n{\n' )
+    for message in schema.messages:
+        for field in message.fields:
+            output.write ( '    const fudge::field_key %s ( "%s", %d );\n' % ( message.nameConstant ( field ), field.name, field.ordinal ) )
+    output.write ( '}\n\n' )
+
+    for part in schema.namespace:
+        output.write ( 'namespace %s {\n' % part )
+    if schema.namespace:
+        output.write ( '\n' )
+
+    for message in schema.messages:
+        initialisers = [ '%s ( %s )' % ( field.name, field.initialiser ( ) ) for field in message.fields
+                         if field.initialiser ( ) ]
+        output.write ( '%s::%s ( )\n' % ( message.name, message.name ) )
+        if initialisers:
+            output.write ( '    : %s\n' % ',\n      '.join ( initialisers ) )
+        output.write ( '{\n}\n\n' )
+        WriteEncoder ( message, 'fudge::message', output )
+        WriteEncoder ( message, 'fudge::message_builder', output )
+        WriteDecoder ( message, output )
+
+    for part in schema.namespace:
+        output.write ( '}\n' )
+    if schema.namespace:
+        output.write ( '\n' )
+
+def CompileSchema ( filename, directory ):
+    input = open ( filename, 'r' )
+    try:
+        schema = Parser ( filename, Tokenise ( filename, input.read ( ) ) ).parse ( )
+    finally:
+        input.close ( )
+
+    base = os.path.splitext ( os.path.basename ( filename ) ) [ 0 ]
+    for extension, writer in ( ( '.hpp', WriteHeader ), ( '.cpp', WriteSource ) ):
+        output = open ( os.path.join ( directory, base + extension ), 'w' )
+        try:
+            writer ( schema, base, output )
+        finally:
+            output.close ( )
+
+if __name__ == '__main__':
+    parser = optparse.OptionParser ( usage = '%prog [-o directory] schema...' )
+    parser.add_option ( '-o', dest = 'directory', default = '.',
+                        help = 'write the generated files to DIRECTORY' )
+    options, filenames = parser.parse_args ( )
+    if not filenames:
+        parser.error ( 'no schema given' )
+    try:
+        for filename in filenames:
+            CompileSchema ( filename, options.directory )
+    except ( SchemaError, IOError ):
+        sys.stderr.write ( '%s\n' % sys.exc_info ( ) [ 1 ] )
+        sys.exit ( 1 )
@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/allocator.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "mutex.hpp"
+#include "fudge/types.h"
+#include <vector>
+#include <stdlib.h>
+
+namespace
+{
+    // Allocations are rounded up to a multiple of the alignment of the most
+    // strictly aligned types
+    union aligned
+    {
+        long double longdouble;
+        fudge_i64 integer;
+        void * pointer;
+    };
+
+    // A type's alignment divides its size, so the largest power of two
+    // dividing the union's size is enough. The size itself need not be a
+    // power of two: it is 12 bytes on i386, where the alignment is 4.
+    const size_t Alignment = sizeof ( aligned ) & ( ~sizeof ( aligned ) + 1 );
+
+    // roundUp only works for powers of two; this fails to compile otherwise
+    typedef char AlignmentIsPowerOfTwo [ ( Alignment & ( Alignment - 1 ) ) == 0 ? 1 : -1 ];
+
+    inline size_t roundUp ( size_t numbytes )
+    {
+        return ( numbytes + Alignment - 1 ) & ~( Alignment - 1 );
+    }
+
+    void * allocateOrThrow ( size_t numbytes )
+    {
+        void * memory ( malloc ( numbytes ) );
+        if ( ! memory )
+            throw fudge::exception ( FUDGE_OUT_OF_MEMORY );
+        return memory;
+    }
+
+    class mallocallocator : public fudge::allocator
+    {
+        public:
+            void * allocate ( size_t numbytes )
+            {
+                return allocateOrThrow ( numbytes ? numbytes : 1 );
+            }
+
+            void deallocate ( void * memory, size_t )
+            {
+                free ( memory );
+            }
+    };
+
+    // Pool size classes run from MinPooledSize to pool::MaxPooledSize in
+    // powers of two; a free block holds the pointer to the next one
+    const size_t MinPooledSize = 16;
+    const size_t NumSizeClasses = 9;
+    const size_t SlabSize = 65536;
+
+    inline size_t sizeClass ( size_t numbytes )
+    {
+        size_t index ( 0 ), size ( MinPooledSize );
+        while ( size < numbytes )
+        {
+            size <<= 1;
+            ++index;
+        }
+        return index;
+    }
+}
+
+namespace fudge {
+
+allocator::~allocator ( )
+{
+}
+
+allocator & allocator::standard ( )
+{
+    static mallocallocator instance;
+    return instance;
+}
+
+const size_t arena::DefaultChunkSize;
+
+// Chunk headers are followed by their memory
+struct arena::chunk
+{
+    chunk * next;
+    size_t numbytes;
+
+    static chunk * create ( size_t numbytes )
+    {
+        chunk * target ( static_cast<chunk *> ( allocateOrThrow ( roundUp ( sizeof ( chunk ) ) + numbytes ) ) );
+        target->next = 0;
+        target->numbytes = numbytes;
+        return target;
+    }
+
+    inline char * begin ( )     { return reinterpret_cast<char *> ( this ) + roundUp ( sizeof ( chunk ) ); }
+    inline char * end ( )       { return begin ( ) + numbytes; }
+};
+
+arena::arena ( size_t chunksize )
+    : m_chunksize ( roundUp ( chunksize ? chunksize : DefaultChunkSize ) )
+    , m_chunks ( 0 )
+    , m_current ( 0 )
+    , m_large ( 0 )
+    , m_position ( 0 )
+    , m_end ( 0 )
+    , m_used ( 0 )
+    , m_capacity ( 0 )
+{
+}
+
+arena::~arena ( )
+{
+    reset ( );
+    while ( m_chunks )
+    {
+        chunk * next ( m_chunks->next );
+        free ( m_chunks );
+        m_chunks = next;
+    }
+}
+
+void * arena::allocate ( size_t numbytes )
+{
+    numbytes = roundUp ( numbytes ? numbytes : 1 );
+
+    // Requests that won't fit in a standard chunk get one of their own
+    if ( numbytes > m_chunksize )
+    {
+        chunk * large ( chunk::create ( numbytes ) );
+        large->next = m_large;
+        m_large = large;
+        m_used += numbytes;
+        m_capacity += numbytes;
+        return large->begin ( );
+    }
+
+    if ( static_cast<size_t> ( m_end - m_position ) < numbytes )
+        nextChunk ( );
+
+    void * memory ( m_position );
+    m_position += numbytes;
+    m_used += numbytes;
+    return memory;
+}
+
+void arena::deallocate ( void *, size_t )
+{
+}
+
+void arena::reset ( )
+{
+    while ( m_large )
+    {
+        chunk * next ( m_large->next );
+        m_capacity -= m_large->numbytes;
+        free ( m_large );
+        m_large = next;
+    }
+
+    m_current = m_chunks;
+    m_position = m_current ? m_current->begin ( ) : 0;
+    m_end = m_current ? m_current->end ( ) : 0;
+    m_used = 0;
+}
+
+void arena::nextChunk ( )
+{
+    // Reuse the chunks kept by reset before allocating any more
+    if ( m_current && m_current->next )
+        m_current = m_current->next;
+    else
+    {
+        chunk * created ( chunk::create ( m_chunksize ) );
+        if ( m_current )
+            m_current->next = created;
+        else
+            m_chunks = created;
+        m_current = created;
+        m_capacity += m_chunksize;
+    }
+
+    m_position = m_current->begin ( );
+    m_end = m_current->end ( );
+}
+
+const size_t pool::MaxPooledSize;
+
+struct pool::state
+{
+    state ( )
+    {
+        for ( size_t index ( 0 ); index < NumSizeClasses; ++index )
+            freelists [ index ] = 0;
+    }
+
+    // Splits a new slab in to blocks for the size class
+    void refill ( size_t index )
+    {
+        const size_t blocksize ( MinPooledSize << index );
+        char * slab ( static_cast<char *> ( allocateOrThrow ( SlabSize ) ) );
+        slabs.push_back ( slab );
+
+        for ( size_t offset ( 0 ); offset + blocksize <= SlabSize; offset += blocksize )
+        {
+            void ** block ( reinterpret_cast<void **> ( slab + offset ) );
+            *block = freelists [ index ];
+            freelists [ index ] = block;
+        }
+    }
+
+    threading::mutex mutex;
+    void * freelists [ NumSizeClasses ];
+    std::vector<char *> slabs;
+};
+
+pool::pool ( )
+    : m_state ( new state )
+{
+}
+
+pool::~pool ( )
+{
+    for ( size_t index ( 0 ); index < m_state->slabs.size ( ); ++index )
+        free ( m_state->slabs [ index ] );
+    delete m_state;
+}
+
+void * pool::allocate ( size_t numbytes )
+{
+    if ( numbytes > MaxPooledSize )
+        return allocateOrThrow ( numbytes );
+
+    const size_t index ( sizeClass ( numbytes ) );
+    threading::scopedlock lock ( m_state->mutex );
+    if ( ! m_state->freelists [ index ] )
+        m_state->refill ( index );
+
+    void ** block ( static_cast<void **> ( m_state->freelists [ index ] ) );
+    m_state->freelists [ index ] = *block;
+    return block;
+}
+
+void pool::deallocate ( void * memory, size_t numbytes )
+{
+    if ( ! memory )
+        return;
+    if ( numbytes > MaxPooledSize )
+    {
+        free ( memory );
+        return;
+    }
+
+    const size_t index ( sizeClass ( numbytes ) );
+    threading::scopedlock lock ( m_state->mutex );
+    *static_cast<void **> ( memory ) = m_state->freelists [ index ];
+    m_state->freelists [ index ] = memory;
+}
+
+}
+
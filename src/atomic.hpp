@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_ATOMIC_HPP
+#define INC_FUDGE_CPP_ATOMIC_HPP
+
+#include "mutex.hpp"
+
+#if defined ( _WIN32 ) && ! defined ( __GNUC__ )
+#include <windows.h>
+#endif
+
+namespace fudge {
+namespace threading {
+
+// A reference count that any number of threads can change at once. Uses the
+// compiler's atomic operations where they're known, otherwise a mutex.
+class atomiccount
+{
+    public:
+        explicit atomiccount ( long value )
+            : m_value ( value )
+        {
+        }
+
+        inline void increment ( )
+        {
+#if defined ( __GNUC__ )
+            __sync_add_and_fetch ( &m_value, 1 );
+#elif defined ( _WIN32 )
+            InterlockedIncrement ( &m_value );
+#else
+            scopedlock lock ( m_lock );
+            ++m_value;
+#endif
+        }
+
+        // Returns the count after decrementing it
+        inline long decrement ( )
+        {
+#if defined ( __GNUC__ )
+            return __sync_sub_and_fetch ( &m_value, 1 );
+#elif defined ( _WIN32 )
+            return InterlockedDecrement ( &m_value );
+#else
+            scopedlock lock ( m_lock );
+            return --m_value;
+#endif
+        }
+
+        // Only a snapshot when other threads hold references
+        inline long value ( ) const
+        {
+#if defined ( __GNUC__ )
+            return __sync_add_and_fetch ( const_cast<volatile long *> ( &m_value ), 0 );
+#elif defined ( _WIN32 )
+            return InterlockedCompareExchange ( const_cast<volatile long *> ( &m_value ), 0, 0 );
+#else
+            scopedlock lock ( m_lock );
+            return m_value;
+#endif
+        }
+
+    private:
+        volatile long m_value;
+#if ! defined ( __GNUC__ ) && ! defined ( _WIN32 )
+        mutable mutex m_lock;
+#endif
+
+        atomiccount ( const atomiccount & );
+        atomiccount & operator= ( const atomiccount & );
+};
+
+}
+}
+
+#endif
+
@@ -0,0 +1,440 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/batchdecoder.hpp"
+#include "fudge-cpp/config.h"
+#include "fudge-cpp/exception.hpp"
+#include "mutex.hpp"
+#include "wire.hpp"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The number of frames a worker takes from its queue at a time
+    static const size_t ChunkSize = 16;
+
+    using fudge::threading::mutex;
+    using fudge::threading::scopedlock;
+
+    // The frames a worker has left to decode. The owner takes frames from
+    // the front while other workers steal from the back.
+    struct workqueue
+    {
+        workqueue ( )
+            : begin ( 0 )
+            , end ( 0 )
+        {
+        }
+
+        mutex lock;
+        size_t begin;
+        size_t end;
+    };
+
+    // A single call to batch_decoder::decode, shared by all of the workers
+    class job
+    {
+        public:
+            job ( const fudge_byte * bytes,
+                  const std::vector<size_t> & offsets,
+                  fudge::envelope * results,
+                  size_t numframes,
+                  size_t numqueues )
+                : m_bytes ( bytes )
+                , m_offsets ( offsets )
+                , m_results ( results )
+                , m_queues ( new workqueue [ numqueues ] )
+                , m_numqueues ( numqueues )
+                , m_failed ( false )
+                , m_errorindex ( 0 )
+                , m_errorstatus ( FUDGE_OK )
+            {
+                // Start each worker with an even share of the frames
+                for ( size_t index ( 0 ); index < numqueues; ++index )
+                {
+                    m_queues [ index ].begin = numframes * index / numqueues;
+                    m_queues [ index ].end = numframes * ( index + 1 ) / numqueues;
+                }
+            }
+
+            ~job ( )
+            {
+                delete [] m_queues;
+            }
+
+            void run ( size_t worker )
+            {
+                fudge::codec codec;
+                size_t begin, end;
+                while ( take ( worker, begin, end ) )
+                {
+                    for ( ; begin < end; ++begin )
+                    {
+                        try
+                        {
+                            const size_t offset ( m_offsets [ begin ] );
+                            m_results [ begin ] = codec.decode ( m_bytes + offset,
+                                                                 static_cast<fudge_i32> ( m_offsets [ begin + 1 ] - offset ) );
+                        }
+                        catch ( const fudge::exception & exception )
+                        {
+                            fail ( begin, exception.status ( ) );
+                            return;
+                        }
+                        catch ( const std::bad_alloc & )
+                        {
+                            fail ( begin, FUDGE_OUT_OF_MEMORY );
+                            return;
+                        }
+                        catch ( ... )
+                        {
+                            // Anything else (from a user type's decoder, say)
+                            // must not escape the thread; it is raised again
+                            // on the calling thread
+                            fail ( begin, FUDGE_OK );
+                            return;
+                        }
+                    }
+                }
+            }
+
+            inline bool failed ( ) const                { return m_failed; }
+            inline size_t errorindex ( ) const          { return m_errorindex; }
+
+            // The status of the failure, or FUDGE_OK if the frame threw
+            // something other than a fudge::exception
+            inline FudgeStatus errorstatus ( ) const    { return m_errorstatus; }
+
+        private:
+            const fudge_byte * m_bytes;
+            const std::vector<size_t> & m_offsets;
+            fudge::envelope * m_results;
+            workqueue * m_queues;
+            size_t m_numqueues;
+
+            mutex m_errorlock;
+            bool m_failed;
+            size_t m_errorindex;
+            FudgeStatus m_errorstatus;
+
+            // Finds the next frames for the worker, from its own queue if it
+            // has any left, or otherwise by stealing half of what remains in
+            // another worker's queue. Only one queue is locked at a time.
+            bool take ( size_t worker, size_t & begin, size_t & end )
+            {
+                {
+                    scopedlock lock ( m_errorlock );
+                    if ( m_failed )
+                        return false;
+                }
+
+                workqueue & own ( m_queues [ worker ] );
+                {
+                    scopedlock lock ( own.lock );
+                    if ( own.begin < own.end )
+                    {
+                        begin = own.begin;
+                        end = own.begin = std::min ( own.begin + ChunkSize, own.end );
+                        return true;
+                    }
+                }
+
+                for ( size_t index ( 1 ); index < m_numqueues; ++index )
+                {
+                    workqueue & victim ( m_queues [ ( worker + index ) % m_numqueues ] );
+                    size_t stolenbegin, stolenend;
+                    {
+                        scopedlock lock ( victim.lock );
+                        if ( victim.begin >= victim.end )
+                            continue;
+
+                        stolenbegin = victim.begin + ( victim.end - victim.begin ) / 2;
+                        stolenend = victim.end;
+                        victim.end = stolenbegin;
+                    }
+
+                    scopedlock lock ( own.lock );
+                    begin = stolenbegin;
+                    end = own.begin = std::min ( stolenbegin + ChunkSize, stolenend );
+                    own.end = stolenend;
+                    return true;
+                }
+                return false;
+            }
+
+            // Records a failure, keeping the earliest frame's status if
+            // several workers fail
+            void fail ( size_t index, FudgeStatus status )
+            {
+                scopedlock lock ( m_errorlock );
+                if ( ! m_failed || index < m_errorindex )
+                {
+                    m_failed = true;
+                    m_errorindex = index;
+                    m_errorstatus = status;
+                }
+            }
+
+            job ( const job & );
+            job & operator= ( const job & );
+    };
+
+    // Decodes a frame that failed on a worker without a fudge::exception.
+    // An arbitrary exception can't be carried between threads, so the frame
+    // is decoded again on the calling thread to raise it there.
+    void redecode ( const fudge_byte * bytes, const std::vector<size_t> & offsets, size_t index )
+    {
+        const size_t offset ( offsets [ index ] );
+        fudge::codec ( ).decode ( bytes + offset, static_cast<fudge_i32> ( offsets [ index + 1 ] - offset ) );
+        throw std::runtime_error ( "Frame failed to decode on a worker thread" );
+    }
+
+    size_t defaultThreadCount ( )
+    {
+#if defined(FUDGE_HAVE_PTHREAD_H) && defined(_SC_NPROCESSORS_ONLN)
+        const long processors ( sysconf ( _SC_NPROCESSORS_ONLN ) );
+        if ( processors > 0 )
+            return static_cast<size_t> ( processors );
+#endif
+        return 1;
+    }
+
+    // The threads used by a batch_decoder. They wait for a job to be
+    // started, run it alongside the calling thread, then wait again.
+    class workerpool
+    {
+        public:
+            explicit workerpool ( size_t numthreads )
+                : m_numthreads ( 1 )
+#ifdef FUDGE_HAVE_PTHREAD_H
+                , m_current ( 0 )
+                , m_generation ( 0 )
+                , m_active ( 0 )
+                , m_stopping ( false )
+#endif
+            {
+#ifdef FUDGE_HAVE_PTHREAD_H
+                pthread_cond_init ( &m_started, 0 );
+                pthread_cond_init ( &m_finished, 0 );
+
+                // The calling thread is worker zero; if a thread can't be
+                // started the pool just runs with fewer
+                m_workers.resize ( numthreads > 1 ? numthreads - 1 : 0 );
+                for ( size_t index ( 0 ); index < m_workers.size ( ); ++index )
+                {
+                    m_workers [ index ].owner = this;
+                    m_workers [ index ].index = index + 1;
+                    if ( pthread_create ( &m_workers [ index ].thread, 0, &workerpool::threadMain, &m_workers [ index ] ) )
+                    {
+                        m_workers.resize ( index );
+                        break;
+                    }
+                }
+                m_numthreads = m_workers.size ( ) + 1;
+#else
+                ( void ) numthreads;
+#endif
+            }
+
+            ~workerpool ( )
+            {
+#ifdef FUDGE_HAVE_PTHREAD_H
+                m_lock.lock ( );
+                m_stopping = true;
+                pthread_cond_broadcast ( &m_started );
+                m_lock.unlock ( );
+
+                for ( size_t index ( 0 ); index < m_workers.size ( ); ++index )
+                    pthread_join ( m_workers [ index ].thread, 0 );
+
+                pthread_cond_destroy ( &m_finished );
+                pthread_cond_destroy ( &m_started );
+#endif
+            }
+
+            inline size_t numthreads ( ) const  { return m_numthreads; }
+
+            // Runs the job on every thread in the pool, returning once they
+            // have all finished with it
+            void run ( job & work )
+            {
+#ifdef FUDGE_HAVE_PTHREAD_H
+                m_lock.lock ( );
+                m_current = &work;
+                m_active = m_workers.size ( );
+                ++m_generation;
+                pthread_cond_broadcast ( &m_started );
+                m_lock.unlock ( );
+#endif
+
+                work.run ( 0 );
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+                m_lock.lock ( );
+                while ( m_active )
+                    pthread_cond_wait ( &m_finished, m_lock.raw ( ) );
+                m_current = 0;
+                m_lock.unlock ( );
+#endif
+            }
+
+        private:
+            size_t m_numthreads;
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+            struct worker
+            {
+                workerpool * owner;
+                size_t index;
+                pthread_t thread;
+            };
+
+            std::vector<worker> m_workers;
+            mutex m_lock;
+            pthread_cond_t m_started;
+            pthread_cond_t m_finished;
+            job * m_current;
+            unsigned long m_generation;
+            size_t m_active;
+            bool m_stopping;
+
+            static void * threadMain ( void * argument )
+            {
+                const worker * self ( static_cast<const worker *> ( argument ) );
+                self->owner->workerLoop ( self->index );
+                return 0;
+            }
+
+            void workerLoop ( size_t index )
+            {
+                unsigned long generation ( 0 );
+                for ( ;; )
+                {
+                    m_lock.lock ( );
+                    while ( m_generation == generation && ! m_stopping )
+                        pthread_cond_wait ( &m_started, m_lock.raw ( ) );
+                    if ( m_stopping )
+                    {
+                        m_lock.unlock ( );
+                        return;
+                    }
+                    generation = m_generation;
+                    job * work ( m_current );
+                    m_lock.unlock ( );
+
+                    work->run ( index );
+
+                    m_lock.lock ( );
+                    if ( ! --m_active )
+                        pthread_cond_signal ( &m_finished );
+                    m_lock.unlock ( );
+                }
+            }
+#endif
+
+            workerpool ( const workerpool & );
+            workerpool & operator= ( const workerpool & );
+    };
+}
+
+namespace fudge {
+
+struct batch_decoder::pool : public workerpool
+{
+    explicit pool ( size_t numthreads )
+        : workerpool ( numthreads )
+    {
+    }
+};
+
+batch_decoder::batch_decoder ( size_t numthreads )
+    : m_pool ( new pool ( numthreads ? numthreads : defaultThreadCount ( ) ) )
+{
+}
+
+batch_decoder::~batch_decoder ( )
+{
+    delete m_pool;
+}
+
+size_t batch_decoder::numthreads ( ) const
+{
+    return m_pool->numthreads ( );
+}
+
+size_t batch_decoder::decode ( const fudge_byte * bytes, size_t numbytes, std::vector<envelope> & target )
+{
+    // The offsets are followed by the end of the buffer, so that every
+    // frame's size is the difference between consecutive offsets
+    std::vector<size_t> offsets;
+    const size_t count ( scan ( bytes, numbytes, offsets ) );
+    if ( ! count )
+        return 0;
+    offsets.push_back ( numbytes );
+
+    const size_t start ( target.size ( ) );
+    target.resize ( start + count );
+
+    job work ( bytes, offsets, &target [ start ], count, m_pool->numthreads ( ) );
+    m_pool->run ( work );
+    if ( work.failed ( ) )
+    {
+        target.resize ( start );
+        if ( work.errorstatus ( ) == FUDGE_OK )
+            redecode ( bytes, offsets, work.errorindex ( ) );
+        throw exception ( work.errorstatus ( ) );
+    }
+    return count;
+}
+
+size_t batch_decoder::scan ( const fudge_byte * bytes, size_t numbytes, std::vector<size_t> & offsets )
+{
+    if ( ! bytes && numbytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    const size_t first ( offsets.size ( ) );
+    try
+    {
+        codec codec;
+        size_t offset ( 0 );
+        while ( offset < numbytes )
+        {
+            const size_t remaining ( numbytes - offset );
+            const fudge_i32 available ( static_cast<fudge_i32> ( std::min<size_t> ( remaining, wire::EnvelopeHeaderSize ) ) );
+            const size_t size ( codec.peekHeader ( bytes + offset, available ).size ( ) );
+            if ( size > remaining )
+                throw exception ( FUDGE_OUT_OF_BYTES );
+
+            offsets.push_back ( offset );
+            offset += size;
+        }
+    }
+    catch ( ... )
+    {
+        offsets.resize ( first );
+        throw;
+    }
+    return offsets.size ( ) - first;
+}
+
+}
+
@@ -14,11 +14,170 @@
  * limitations under the License.
  */
 #include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/allocator.hpp"
 #include "fudge-cpp/exception.hpp"
+#include "encoder.hpp"
+#include "wire.hpp"
 #include "fudge/codec.h"
+#include "fudge/envelope.h"
+#include <stdlib.h>
+
+namespace
+{
+    // Returns the total encoded size of the envelope, or -1 if it can only be
+    // encoded by Fudge-C. The submessage sizes are recorded in the cache.
+    fudge_i32 nativeEnvelopeSize ( const fudge::envelope & source,
+                                   fudge::encoder::fieldstack & stack,
+                                   fudge::encoder::sizecache & cache )
+    {
+        if ( ! source.raw ( ) )
+            throw fudge::exception ( FUDGE_NULL_POINTER );
+
+        const fudge_i32 size ( fudge::encoder::messageSize ( FudgeMsgEnvelope_getMessage ( source.raw ( ) ), stack, &cache ) );
+        return size < 0 ? -1 : size + fudge::wire::EnvelopeHeaderSize;
+    }
+
+    void writeEnvelope ( fudge_byte * target,
+                         const fudge::envelope & source,
+                         fudge_i32 size,
+                         fudge::encoder::fieldstack & stack,
+                         fudge::encoder::sizecache & cache )
+    {
+        target = fudge::encoder::writeEnvelopeHeader ( target, source.raw ( ), size );
+        fudge::encoder::writeMessage ( target, FudgeMsgEnvelope_getMessage ( source.raw ( ) ), stack, cache );
+    }
+
+    // Used for envelopes containing user types, which only Fudge-C can
+    // encode: owns the buffer Fudge-C allocates for the encoded envelope
+    class fudgecbuffer
+    {
+        public:
+            explicit fudgecbuffer ( const fudge::envelope & source )
+            {
+                fudge::exception::throwOnError ( FudgeCodec_encodeMsg ( source.raw ( ), &m_bytes, &m_numbytes ) );
+            }
+
+            ~fudgecbuffer ( )
+            {
+                free ( m_bytes );
+            }
+
+            inline const fudge_byte * bytes ( ) const   { return m_bytes; }
+            inline fudge_i32 numbytes ( ) const         { return m_numbytes; }
+
+        private:
+            fudge_byte * m_bytes;
+            fudge_i32 m_numbytes;
+
+            fudgecbuffer ( const fudgecbuffer & );
+            fudgecbuffer & operator= ( const fudgecbuffer & );
+    };
+
+    // Returns the size of the encoded envelope, having checked that it is
+    // all present
+    fudge_i32 readEnvelopeSize ( const fudge_byte * bytes, fudge_i32 numbytes )
+    {
+        const fudge_i32 size ( fudge::codec ( ).peekHeader ( bytes, numbytes ).size ( ) );
+        if ( size > numbytes )
+            throw fudge::exception ( FUDGE_OUT_OF_BYTES );
+        return size;
+    }
+
+    // Checks the fields between position and end, and those of any
+    // submessages, reporting offsets from base
+    fudge::validation validateFields ( const fudge_byte * base,
+                                       const fudge_byte * position,
+                                       const fudge_byte * end,
+                                       size_t depth )
+    {
+        using namespace fudge::wire;
+
+        fieldheader header;
+        while ( position < end )
+        {
+            const fudge_i32 offset ( static_cast<fudge_i32> ( position - base ) );
+            const FudgeStatus status ( readFieldHeader ( position, end, header ) );
+            if ( status != FUDGE_OK )
+                return fudge::validation ( status, offset );
+
+            if ( header.type == FUDGE_TYPE_FUDGE_MSG )
+            {
+                if ( ! depth )
+                    return fudge::validation ( FUDGE_OUT_OF_MEMORY, offset );
+
+                const fudge::validation result ( validateFields ( base, header.data, header.data + header.numbytes, depth - 1 ) );
+                if ( ! result.valid ( ) )
+                    return result;
+            }
+            position = header.data + header.numbytes;
+        }
+        return fudge::validation ( );
+    }
+
+    void projectFields ( std::vector<fudge_byte> & target,
+                         const fudge_byte * position,
+                         const fudge_byte * end,
+                         const fudge::field_selector & selector );
+
+    // Appends the submessage field at position to target, containing only
+    // those of its fields picked out by the selector. The field is written
+    // with a four byte length, which is shrunk once its size is known.
+    void projectMessage ( std::vector<fudge_byte> & target,
+                          const fudge_byte * position,
+                          const fudge::wire::fieldheader & header,
+                          const fudge::field_selector & selector )
+    {
+        using namespace fudge::wire;
+
+        const fudge_byte * lengthstart ( header.hasname ? header.name + header.namelength
+                                                        : position + ( header.hasordinal ? 4 : 2 ) );
+        const size_t fieldstart ( target.size ( ) );
+        target.insert ( target.end ( ), position, lengthstart );
+        target.resize ( target.size ( ) + 4 );
+
+        const size_t datastart ( target.size ( ) );
+        projectFields ( target, header.data, header.data + header.numbytes, selector );
+
+        const fudge_i32 numbytes ( static_cast<fudge_i32> ( target.size ( ) - datastart ) );
+        const fudge_i32 width ( lengthWidth ( numbytes ) );
+        target [ fieldstart ] = static_cast<fudge_byte> ( ( header.prefix & ~( 0x03 << VariableWidthShift ) ) | lengthPrefix ( numbytes ) );
+        writeLength ( &target [ datastart - 4 ], numbytes );
+        if ( width < 4 )
+            target.erase ( target.begin ( ) + ( datastart - 4 + width ), target.begin ( ) + datastart );
+    }
+
+    // Appends the selected fields between position and end to target,
+    // skipping over the rest without looking at their contents
+    void projectFields ( std::vector<fudge_byte> & target,
+                         const fudge_byte * position,
+                         const fudge_byte * end,
+                         const fudge::field_selector & selector )
+    {
+        fudge::wire::fieldheader header;
+        while ( position < end )
+        {
+            fudge::exception::throwOnError ( fudge::wire::readFieldHeader ( position, end, header ) );
+            const fudge_byte * next ( header.data + header.numbytes );
+
+            const fudge::field_selector * nested;
+            const fudge::slice name ( header.hasname ? header.name : 0, header.namelength );
+            if ( selector.selects ( header.hasordinal, header.ordinal, name, nested ) )
+            {
+                if ( nested && header.type == FUDGE_TYPE_FUDGE_MSG )
+                    projectMessage ( target, position, header, *nested );
+                else
+                    target.insert ( target.end ( ), position, next );
+            }
+            position = next;
+        }
+    }
+}
 
 namespace fudge {
 
+const size_t codec::DefaultMaxDepth;
+const size_t codec::DefaultGatherThreshold;
+
 envelope codec::decode ( const fudge_byte * bytes, fudge_i32 numbytes ) const
 {
     FudgeMsgEnvelope target;
@@ -26,10 +185,240 @@ envelope codec::decode ( const fudge_byte * bytes, fudge_i32 numbytes ) const
     return envelope ( target, false );
 }
 
+envelope_header codec::peekHeader ( const fudge_byte * bytes, fudge_i32 numbytes ) const
+{
+    envelope_header header;
+    exception::throwOnError ( tryPeekHeader ( header, bytes, numbytes ) );
+    return header;
+}
+
+envelope codec::decode ( const fudge_byte * bytes, fudge_i32 numbytes, const field_selector & selector ) const
+{
+    const fudge_i32 size ( readEnvelopeSize ( bytes, numbytes ) );
+
+    // Copy the selected fields in to a smaller envelope and let Fudge-C
+    // decode that, so that user types are still decoded by their
+    // registered decoders
+    std::vector<fudge_byte> projected;
+    projected.reserve ( size );
+    projected.insert ( projected.end ( ), bytes, bytes + wire::EnvelopeHeaderSize );
+    projectFields ( projected, bytes + wire::EnvelopeHeaderSize, bytes + size, selector );
+    wire::writeI32 ( &projected [ wire::EnvelopeSizeOffset ], static_cast<fudge_i32> ( projected.size ( ) ) );
+
+    return decode ( &projected [ 0 ], static_cast<fudge_i32> ( projected.size ( ) ) );
+}
+
+message_view codec::decode ( const fudge_byte * bytes, fudge_i32 numbytes, arena & target ) const
+{
+    const validation result ( validate ( bytes, numbytes ) );
+    if ( ! result.valid ( ) )
+        throw exception ( result.status ( ) );
+
+    const fudge_i32 size ( wire::readI32 ( bytes + wire::EnvelopeSizeOffset ) );
+    fudge_byte * copy ( static_cast<fudge_byte *> ( target.allocate ( size ) ) );
+    memcpy ( copy, bytes, size );
+    return message_view ( copy + wire::EnvelopeHeaderSize, size - wire::EnvelopeHeaderSize );
+}
+
+message_view codec::view ( const fudge_byte * bytes, fudge_i32 numbytes ) const
+{
+    const fudge_i32 size ( readEnvelopeSize ( bytes, numbytes ) );
+    return message_view ( bytes + wire::EnvelopeHeaderSize, size - wire::EnvelopeHeaderSize );
+}
+
+validation codec::validate ( const fudge_byte * bytes, fudge_i32 numbytes, size_t maxdepth ) const
+{
+    if ( ! bytes )
+        return validation ( FUDGE_NULL_POINTER, 0 );
+    if ( numbytes < wire::EnvelopeHeaderSize )
+        return validation ( FUDGE_OUT_OF_BYTES, 0 );
+
+    const fudge_i32 size ( wire::readI32 ( bytes + wire::EnvelopeSizeOffset ) );
+    if ( size < wire::EnvelopeHeaderSize || size > numbytes )
+        return validation ( FUDGE_OUT_OF_BYTES, wire::EnvelopeSizeOffset );
+
+    return validateFields ( bytes, bytes + wire::EnvelopeHeaderSize, bytes + size, maxdepth );
+}
+
+FudgeStatus codec::tryDecode ( envelope & target, const fudge_byte * bytes, fudge_i32 numbytes ) const
+{
+    FudgeMsgEnvelope decoded;
+    const FudgeStatus status ( FudgeCodec_decodeMsg ( &decoded, bytes, numbytes ) );
+    if ( status == FUDGE_OK )
+    {
+        envelope adopted ( decoded, false );
+        target.swap ( adopted );
+    }
+    return status;
+}
+
+FudgeStatus codec::tryPeekHeader ( envelope_header & target, const fudge_byte * bytes, fudge_i32 numbytes ) const
+{
+    if ( ! bytes )
+        return FUDGE_NULL_POINTER;
+    if ( numbytes < wire::EnvelopeHeaderSize )
+        return FUDGE_OUT_OF_BYTES;
+
+    const fudge_i32 size ( wire::readI32 ( bytes + wire::EnvelopeSizeOffset ) );
+    if ( size < wire::EnvelopeHeaderSize )
+        return FUDGE_OUT_OF_BYTES;
+
+    target = envelope_header ( bytes [ 0 ], bytes [ 1 ], wire::readI16 ( bytes + 2 ), size );
+    return FUDGE_OK;
+}
+
+FudgeStatus codec::tryView ( message_view & target, const fudge_byte * bytes, fudge_i32 numbytes ) const
+{
+    envelope_header header;
+    const FudgeStatus status ( tryPeekHeader ( header, bytes, numbytes ) );
+    if ( status != FUDGE_OK )
+        return status;
+    if ( header.size ( ) > numbytes )
+        return FUDGE_OUT_OF_BYTES;
+
+    target = message_view ( bytes + wire::EnvelopeHeaderSize, header.size ( ) - wire::EnvelopeHeaderSize );
+    return FUDGE_OK;
+}
+
 void codec::encode ( const envelope & source, fudge_byte * & bytes, fudge_i32 & numbytes ) const
 {
     exception::throwOnError ( FudgeCodec_encodeMsg ( source.raw ( ), &bytes, &numbytes ) );
 }
 
+bool codec::encode ( const envelope & source, fudge_byte * bytes, fudge_i32 capacity, fudge_i32 & numbytes ) const
+{
+    encoder::fieldstack stack;
+    encoder::sizecache cache;
+    const fudge_i32 size ( nativeEnvelopeSize ( source, stack, cache ) );
+    if ( size >= 0 )
+    {
+        numbytes = size;
+        if ( size > capacity )
+            return false;
+        if ( ! bytes )
+            throw exception ( FUDGE_NULL_POINTER );
+
+        writeEnvelope ( bytes, source, size, stack, cache );
+        return true;
+    }
+
+    const fudgecbuffer encoded ( source );
+    numbytes = encoded.numbytes ( );
+    if ( numbytes > capacity )
+        return false;
+    if ( ! bytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    memcpy ( bytes, encoded.bytes ( ), numbytes );
+    return true;
+}
+
+fudge_i32 codec::encode ( const envelope & source, std::vector<fudge_byte> & buffer ) const
+{
+    const size_t offset ( buffer.size ( ) );
+    encoder::fieldstack stack;
+    encoder::sizecache cache;
+    const fudge_i32 size ( nativeEnvelopeSize ( source, stack, cache ) );
+    if ( size >= 0 )
+    {
+        buffer.resize ( offset + size );
+        writeEnvelope ( &( buffer [ offset ] ), source, size, stack, cache );
+        return size;
+    }
+
+    const fudgecbuffer encoded ( source );
+    buffer.insert ( buffer.end ( ), encoded.bytes ( ), encoded.bytes ( ) + encoded.numbytes ( ) );
+    return encoded.numbytes ( );
+}
+
+fudge_i32 codec::encode ( const envelope & source, gather_list & target, size_t threshold ) const
+{
+    encoder::fieldstack stack;
+    encoder::sizecache cache;
+    const fudge_i32 size ( nativeEnvelopeSize ( source, stack, cache ) );
+    if ( size >= 0 )
+    {
+        encoder::writeEnvelopeHeader ( target.append ( wire::EnvelopeHeaderSize ), source.raw ( ), size );
+        encoder::gatherMessage ( target, FudgeMsgEnvelope_getMessage ( source.raw ( ) ), stack, cache, threshold ? threshold : 1 );
+        return size;
+    }
+
+    const fudgecbuffer encoded ( source );
+    memcpy ( target.append ( encoded.numbytes ( ) ), encoded.bytes ( ), encoded.numbytes ( ) );
+    return encoded.numbytes ( );
+}
+
+size_t codec::encodeBatch ( const envelope * envelopes,
+                           size_t count,
+                           std::vector<fudge_byte> & buffer,
+                           std::vector<size_t> & offsets ) const
+{
+    if ( ! envelopes && count )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    // Size every envelope first, recording the submessage sizes for the
+    // whole batch in a single cache. Envelopes that need Fudge-C are
+    // encoded straight away and copied in afterwards.
+    encoder::fieldstack stack;
+    encoder::sizecache cache;
+    std::vector<fudge_i32> sizes ( count );
+    std::vector<fudge_byte> fudgecbytes;
+    size_t total ( 0 );
+    for ( size_t index ( 0 ); index < count; ++index )
+    {
+        const size_t mark ( cache.size ( ) );
+        if ( ( sizes [ index ] = nativeEnvelopeSize ( envelopes [ index ], stack, cache ) ) < 0 )
+        {
+            cache.truncate ( mark );
+            const fudgecbuffer encoded ( envelopes [ index ] );
+            fudgecbytes.insert ( fudgecbytes.end ( ), encoded.bytes ( ), encoded.bytes ( ) + encoded.numbytes ( ) );
+            total += encoded.numbytes ( );
+        }
+        else
+            total += sizes [ index ];
+    }
+
+    const size_t start ( buffer.size ( ) );
+    buffer.resize ( start + total );
+    offsets.reserve ( offsets.size ( ) + count );
+
+    size_t offset ( start ), fudgecoffset ( 0 );
+    for ( size_t index ( 0 ); index < count; ++index )
+    {
+        offsets.push_back ( offset );
+        if ( sizes [ index ] >= 0 )
+        {
+            writeEnvelope ( &( buffer [ offset ] ), envelopes [ index ], sizes [ index ], stack, cache );
+            offset += sizes [ index ];
+        }
+        else
+        {
+            // The envelope header holds the size of the Fudge-C encoding
+            const fudge_i32 size ( wire::readI32 ( &( fudgecbytes [ fudgecoffset ] ) + wire::EnvelopeSizeOffset ) );
+            memcpy ( &( buffer [ offset ] ), &( fudgecbytes [ fudgecoffset ] ), size );
+            fudgecoffset += size;
+            offset += size;
+        }
+    }
+    return total;
+}
+
+size_t codec::encodeBatch ( const std::vector<envelope> & envelopes,
+                           std::vector<fudge_byte> & buffer,
+                           std::vector<size_t> & offsets ) const
+{
+    return encodeBatch ( envelopes.empty ( ) ? 0 : &envelopes [ 0 ], envelopes.size ( ), buffer, offsets );
+}
+
+fudge_i32 codec::encodedSize ( const envelope & source ) const
+{
+    if ( ! source.raw ( ) )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    encoder::fieldstack stack;
+    const fudge_i32 size ( encoder::messageSize ( FudgeMsgEnvelope_getMessage ( source.raw ( ) ), stack ) );
+    return size < 0 ? fudgecbuffer ( source ).numbytes ( ) : size + wire::EnvelopeHeaderSize;
+}
+
 }
 
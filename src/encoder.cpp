@@ -0,0 +1,334 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "encoder.hpp"
+#include "wire.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge/envelope.h"
+#include "fudge/message.h"
+#include "fudge/string.h"
+#include <algorithm>
+
+namespace
+{
+    using namespace fudge::wire;
+
+    // Fudge-C only offers indexed access to fields (which is linear in the
+    // number of fields) or a bulk copy. Takes a bulk copy on to the caller's
+    // field stack for the lifetime of the object. Fields are returned by
+    // value, as encoding a submessage pushes its own frame and may move the
+    // stack.
+    class fieldlist
+    {
+        public:
+            fieldlist ( fudge::encoder::fieldstack & stack, FudgeMsg message )
+                : m_stack ( stack )
+                , m_offset ( stack.push ( message, m_size ) )
+            {
+            }
+
+            ~fieldlist ( )
+            {
+                m_stack.pop ( m_offset );
+            }
+
+            inline size_t size ( ) const                        { return m_size; }
+            inline FudgeField operator[] ( size_t index ) const { return m_stack [ m_offset + index ]; }
+
+        private:
+            fudge::encoder::fieldstack & m_stack;
+            size_t m_size;
+            size_t m_offset;
+
+            fieldlist ( const fieldlist & );
+            fieldlist & operator= ( const fieldlist & );
+    };
+
+    template<class Type> inline fudge_byte * writeArray ( fudge_byte * target,
+                                                          const FudgeField & field,
+                                                          fudge_byte * ( *function ) ( fudge_byte *, Type ) )
+    {
+        const Type * elements ( reinterpret_cast<const Type *> ( field.data.bytes ) );
+        const size_t numelements ( field.numbytes / sizeof ( Type ) );
+        for ( size_t index ( 0 ); index < numelements; ++index )
+            target = function ( target, elements [ index ] );
+        return target;
+    }
+
+    // Returns the number of bytes used by the field data, or -1 if the field
+    // cannot be encoded natively
+    fudge_i32 dataSize ( const FudgeField & field, fudge::encoder::fieldstack & stack, fudge::encoder::sizecache * cache )
+    {
+        if ( ! isStandardType ( field.type ) )
+            return -1;
+
+        const fudge_i32 width ( fixedWidth ( field.type ) );
+        if ( width >= 0 )
+            return width;
+
+        switch ( field.type )
+        {
+            case FUDGE_TYPE_STRING:     return static_cast<fudge_i32> ( FudgeString_getSize ( field.data.string ) );
+            case FUDGE_TYPE_FUDGE_MSG:  break;
+            default:                    return field.numbytes;
+        }
+
+        if ( ! cache )
+            return fudge::encoder::messageSize ( field.data.message, stack );
+
+        const size_t slot ( cache->reserve ( ) );
+        const fudge_i32 size ( fudge::encoder::messageSize ( field.data.message, stack, cache ) );
+        cache->set ( slot, size );
+        return size;
+    }
+
+    fudge_i32 fieldHeaderSize ( const FudgeField & field, fudge_i32 numbytes )
+    {
+        fudge_i32 size ( 2 );
+        if ( field.flags & FUDGE_FIELD_HAS_ORDINAL )
+            size += 2;
+        if ( field.flags & FUDGE_FIELD_HAS_NAME )
+            size += 1 + static_cast<fudge_i32> ( FudgeString_getSize ( field.name ) );
+        if ( fixedWidth ( field.type ) < 0 )
+            size += lengthWidth ( numbytes );
+        return size;
+    }
+
+    fudge_i32 fieldSize ( const FudgeField & field, fudge::encoder::fieldstack & stack, fudge::encoder::sizecache * cache )
+    {
+        const fudge_i32 numbytes ( dataSize ( field, stack, cache ) );
+        return numbytes < 0 ? -1 : fieldHeaderSize ( field, numbytes ) + numbytes;
+    }
+
+    // Writes the field prefix, type, ordinal, name and (for variable width
+    // types) the length of the data that follows
+    fudge_byte * writeFieldHeader ( fudge_byte * target, const FudgeField & field, fudge_i32 numbytes )
+    {
+        const bool fixed ( fixedWidth ( field.type ) >= 0 );
+        unsigned char prefix ( fixed ? FixedWidthPrefix : lengthPrefix ( numbytes ) );
+        if ( field.flags & FUDGE_FIELD_HAS_ORDINAL )
+            prefix |= OrdinalPrefix;
+        if ( field.flags & FUDGE_FIELD_HAS_NAME )
+            prefix |= NamePrefix;
+
+        target = writeByte ( target, prefix );
+        target = writeByte ( target, field.type );
+        if ( field.flags & FUDGE_FIELD_HAS_ORDINAL )
+            target = writeI16 ( target, field.ordinal );
+        if ( field.flags & FUDGE_FIELD_HAS_NAME )
+        {
+            const size_t namelength ( FudgeString_getSize ( field.name ) );
+            target = writeByte ( target, static_cast<unsigned char> ( namelength ) );
+            target = writeBytes ( target, FudgeString_getData ( field.name ), namelength );
+        }
+        return fixed ? target : writeLength ( target, numbytes );
+    }
+
+    fudge_byte * writeField ( fudge_byte * target,
+                              const FudgeField & field,
+                              fudge::encoder::fieldstack & stack,
+                              fudge::encoder::sizecache & cache )
+    {
+        const fudge_i32 width ( fixedWidth ( field.type ) );
+        fudge_i32 numbytes ( width );
+        if ( field.type == FUDGE_TYPE_FUDGE_MSG )
+            numbytes = cache.next ( );
+        else if ( width < 0 )
+            numbytes = dataSize ( field, stack, 0 );
+
+        target = writeFieldHeader ( target, field, numbytes );
+
+        // Field data
+        switch ( field.type )
+        {
+            case FUDGE_TYPE_INDICATOR:      return target;
+            case FUDGE_TYPE_BOOLEAN:        return writeByte ( target, field.data.boolean ? 1 : 0 );
+            case FUDGE_TYPE_BYTE:           return writeByte ( target, static_cast<unsigned char> ( field.data.byte ) );
+            case FUDGE_TYPE_SHORT:          return writeI16 ( target, field.data.i16 );
+            case FUDGE_TYPE_INT:            return writeI32 ( target, field.data.i32 );
+            case FUDGE_TYPE_LONG:           return writeI64 ( target, field.data.i64 );
+            case FUDGE_TYPE_FLOAT:          return writeF32 ( target, field.data.f32 );
+            case FUDGE_TYPE_DOUBLE:         return writeF64 ( target, field.data.f64 );
+            case FUDGE_TYPE_SHORT_ARRAY:    return writeArray<fudge_i16> ( target, field, writeI16 );
+            case FUDGE_TYPE_INT_ARRAY:      return writeArray<fudge_i32> ( target, field, writeI32 );
+            case FUDGE_TYPE_LONG_ARRAY:     return writeArray<fudge_i64> ( target, field, writeI64 );
+            case FUDGE_TYPE_FLOAT_ARRAY:    return writeArray<fudge_f32> ( target, field, writeF32 );
+            case FUDGE_TYPE_DOUBLE_ARRAY:   return writeArray<fudge_f64> ( target, field, writeF64 );
+            case FUDGE_TYPE_STRING:         return writeBytes ( target, FudgeString_getData ( field.data.string ), numbytes );
+            case FUDGE_TYPE_FUDGE_MSG:      return fudge::encoder::writeMessage ( target, field.data.message, stack, cache );
+            case FUDGE_TYPE_DATE:           return writeDate ( target, field.data.datetime.date );
+            case FUDGE_TYPE_TIME:           return writeTime ( target, field.data.datetime.time );
+            case FUDGE_TYPE_DATETIME:       return writeTime ( writeDate ( target, field.data.datetime.date ), field.data.datetime.time );
+            default:                        return writeBytes ( target, field.data.bytes, numbytes );
+        }
+    }
+
+    // Returns the field's payload if it is already in wire order, and so
+    // can be written from where it is
+    const void * wirePayload ( const FudgeField & field )
+    {
+        switch ( field.type )
+        {
+            case FUDGE_TYPE_STRING:
+                return FudgeString_getData ( field.data.string );
+
+            case FUDGE_TYPE_SHORT_ARRAY:
+            case FUDGE_TYPE_INT_ARRAY:
+            case FUDGE_TYPE_LONG_ARRAY:
+            case FUDGE_TYPE_FLOAT_ARRAY:
+            case FUDGE_TYPE_DOUBLE_ARRAY:
+                return hostIsBigEndian ( ) ? field.data.bytes : 0;
+
+            default:
+                return arrayElementWidth ( field.type ) ? field.data.bytes : 0;
+        }
+    }
+}
+
+namespace fudge {
+namespace encoder {
+
+fieldstack::fieldstack ( )
+    : m_fields ( m_local )
+    , m_size ( 0 )
+    , m_capacity ( LocalCapacity )
+{
+}
+
+size_t fieldstack::push ( FudgeMsg message, size_t & count )
+{
+    count = FudgeMsg_numFields ( message );
+    if ( m_size + count > m_capacity )
+    {
+        // Frames below this one are copied across with the storage
+        const size_t capacity ( std::max ( m_capacity * 2, m_size + count ) );
+        const bool local ( m_fields == m_local );
+        m_heap.resize ( capacity );
+        if ( local )
+            std::copy ( m_local, m_local + m_size, m_heap.begin ( ) );
+
+        m_fields = &( m_heap [ 0 ] );
+        m_capacity = capacity;
+    }
+
+    const size_t offset ( m_size );
+    if ( count )
+    {
+        const fudge_i32 retrieved ( FudgeMsg_getFields ( m_fields + offset, count, message ) );
+        count = retrieved > 0 ? retrieved : 0;
+    }
+    m_size += count;
+    return offset;
+}
+
+sizecache::sizecache ( )
+    : m_size ( 0 )
+    , m_cursor ( 0 )
+{
+}
+
+size_t sizecache::reserve ( )
+{
+    if ( m_size >= LocalCapacity )
+        m_heap.push_back ( -1 );
+    return m_size++;
+}
+
+void sizecache::set ( size_t slot, fudge_i32 size )
+{
+    if ( slot < LocalCapacity )
+        m_local [ slot ] = size;
+    else
+        m_heap [ slot - LocalCapacity ] = size;
+}
+
+fudge_i32 sizecache::next ( )
+{
+    if ( m_cursor >= m_size )
+        throw exception ( FUDGE_INTERNAL_LIBRARY_ERROR );
+
+    const size_t slot ( m_cursor++ );
+    return slot < LocalCapacity ? m_local [ slot ] : m_heap [ slot - LocalCapacity ];
+}
+
+void sizecache::truncate ( size_t size )
+{
+    if ( size < m_size )
+    {
+        m_heap.resize ( size > LocalCapacity ? size - LocalCapacity : 0 );
+        m_size = size;
+    }
+}
+
+fudge_i32 messageSize ( FudgeMsg message, fieldstack & stack, sizecache * cache )
+{
+    const fieldlist fields ( stack, message );
+
+    fudge_i32 size ( 0 );
+    for ( size_t index ( 0 ); index < fields.size ( ); ++index )
+    {
+        const fudge_i32 fieldsize ( fieldSize ( fields [ index ], stack, cache ) );
+        if ( fieldsize < 0 )
+            return -1;
+        size += fieldsize;
+    }
+    return size;
+}
+
+fudge_byte * writeMessage ( fudge_byte * target, FudgeMsg message, fieldstack & stack, sizecache & cache )
+{
+    const fieldlist fields ( stack, message );
+    for ( size_t index ( 0 ); index < fields.size ( ); ++index )
+        target = writeField ( target, fields [ index ], stack, cache );
+    return target;
+}
+
+void gatherMessage ( gather_list & target, FudgeMsg message, fieldstack & stack, sizecache & cache, size_t threshold )
+{
+    const fieldlist fields ( stack, message );
+    for ( size_t index ( 0 ); index < fields.size ( ); ++index )
+    {
+        const FudgeField field ( fields [ index ] );
+        if ( field.type == FUDGE_TYPE_FUDGE_MSG )
+        {
+            const fudge_i32 numbytes ( cache.next ( ) );
+            writeFieldHeader ( target.append ( fieldHeaderSize ( field, numbytes ) ), field, numbytes );
+            gatherMessage ( target, field.data.message, stack, cache, threshold );
+            continue;
+        }
+
+        const fudge_i32 numbytes ( dataSize ( field, stack, 0 ) );
+        const void * payload ( numbytes > 0 && static_cast<size_t> ( numbytes ) >= threshold ? wirePayload ( field ) : 0 );
+        if ( payload )
+        {
+            writeFieldHeader ( target.append ( fieldHeaderSize ( field, numbytes ) ), field, numbytes );
+            target.appendBorrowed ( payload, numbytes );
+        }
+        else
+            writeField ( target.append ( fieldHeaderSize ( field, numbytes ) + numbytes ), field, stack, cache );
+    }
+}
+
+fudge_byte * writeEnvelopeHeader ( fudge_byte * target, FudgeMsgEnvelope envelope, fudge_i32 size )
+{
+    target = writeByte ( target, static_cast<unsigned char> ( FudgeMsgEnvelope_getDirectives ( envelope ) ) );
+    target = writeByte ( target, static_cast<unsigned char> ( FudgeMsgEnvelope_getSchemaVersion ( envelope ) ) );
+    target = writeI16 ( target, FudgeMsgEnvelope_getTaxonomy ( envelope ) );
+    return writeI32 ( target, size );
+}
+
+}
+}
+
@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_ENCODER_HPP
+#define INC_FUDGE_CPP_ENCODER_HPP
+
+#include "fudge-cpp/gatherlist.hpp"
+#include "fudge/message.h"
+#include <vector>
+
+// Native encoding of messages built from the standard Fudge types, used to
+// write directly in to caller supplied memory. Messages containing user
+// defined types must be encoded by Fudge-C, as only it has access to the
+// registered type encoders.
+namespace fudge {
+namespace encoder {
+
+// Scratch space for the field lists of the messages being encoded. Each
+// message pushes a frame holding exactly its own fields (the count taken
+// once from Fudge-C), which is popped once the message has been encoded.
+// One stack serves a whole message tree and both the sizing and writing
+// passes, so it grows at most a few times per encode; small trees never
+// touch the heap. Frames are addressed by offset, as pushing may move the
+// storage.
+class fieldstack
+{
+    public:
+        fieldstack ( );
+
+        // Copies the message's fields on to the top of the stack, returning
+        // the offset of the first and setting count to the number copied
+        size_t push ( FudgeMsg message, size_t & count );
+        inline void pop ( size_t offset )                               { m_size = offset; }
+
+        inline const FudgeField & operator[] ( size_t index ) const     { return m_fields [ index ]; }
+
+    private:
+        static const size_t LocalCapacity = 64;
+
+        FudgeField m_local [ LocalCapacity ];
+        std::vector<FudgeField> m_heap;
+        FudgeField * m_fields;
+        size_t m_size;
+        size_t m_capacity;
+
+        fieldstack ( const fieldstack & );
+        fieldstack & operator= ( const fieldstack & );
+};
+
+// Records the sizes of submessages in the order the encoder meets them, so
+// that sizing and then writing a message tree only sizes each submessage
+// once. The sizes of shallow trees are held without allocating.
+class sizecache
+{
+    public:
+        sizecache ( );
+
+        // Reserves a slot for a submessage about to be sized, then sets it
+        size_t reserve ( );
+        void set ( size_t slot, fudge_i32 size );
+
+        // Returns the sizes in the order they were reserved
+        fudge_i32 next ( );
+
+        // The number of slots reserved, and discarding those reserved after
+        // a previous count (when a message turns out to need Fudge-C)
+        inline size_t size ( ) const    { return m_size; }
+        void truncate ( size_t size );
+
+    private:
+        static const size_t LocalCapacity = 32;
+
+        fudge_i32 m_local [ LocalCapacity ];
+        std::vector<fudge_i32> m_heap;
+        size_t m_size;
+        size_t m_cursor;
+
+        sizecache ( const sizecache & );
+        sizecache & operator= ( const sizecache & );
+};
+
+// Returns the number of bytes needed to encode the fields of the message
+// (i.e. without an envelope header), or -1 if the message (or any of its
+// submessages) contains a field that cannot be encoded natively. If cache is
+// provided the size of every submessage is recorded in it.
+fudge_i32 messageSize ( FudgeMsg message, fieldstack & stack, sizecache * cache = 0 );
+
+// Writes the encoded fields of the message in to target, which must be at
+// least messageSize bytes long. The cache must have been populated by a
+// call to messageSize for the same message. Returns the position after the
+// last byte.
+fudge_byte * writeMessage ( fudge_byte * target, FudgeMsg message, fieldstack & stack, sizecache & cache );
+
+// Appends the encoded fields of the message to target in the same way as
+// writeMessage, except that string, byte array and (on big-endian hosts)
+// numeric array payloads of at least threshold bytes are added as segments
+// referring to the message's own storage rather than being copied.
+void gatherMessage ( gather_list & target, FudgeMsg message, fieldstack & stack, sizecache & cache, size_t threshold );
+
+// Writes an envelope header for an envelope of the given total size
+fudge_byte * writeEnvelopeHeader ( fudge_byte * target, FudgeMsgEnvelope envelope, fudge_i32 size );
+
+}
+}
+
+#endif
+
@@ -39,10 +39,9 @@ FudgeStatus exception::status ( ) const
     return m_status;
 }
 
-void exception::throwOnError ( FudgeStatus status )
+void exception::throwError ( FudgeStatus status )
 {
-    if ( status != FUDGE_OK )
-        throw exception ( status );
+    throw exception ( status );
 }
 
 }
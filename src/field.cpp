@@ -15,43 +15,33 @@
  */
 #include "fudge-cpp/field.hpp"
 #include "fudge-cpp/exception.hpp"
-#include "fudge/message_ex.h"
 #include "fudge/string.h"
 
 namespace
 {
-    template<class Type, fudge_type_id Desired> inline Type getImpl ( fudge_type_id type, Type value )
-    {
-        if ( Desired == type )
-            return value;
-        throw fudge::exception ( FUDGE_INVALID_TYPE_ACCESSOR );
-    }
-
-    template<class Type> inline Type getAsImpl ( const FudgeField * field,
-                                                 FudgeStatus ( *function ) ( const FudgeField *, Type * ) )
-    {
-        Type value;
-        fudge::exception::throwOnError ( function ( field, &value ) );
-        return value;
-    }
-
-    template<class Type> inline size_t getArrayImpl ( fudge_type_id type,
-                                                      const FudgeField & field,
-                                                      std::vector<Type> & target )
+    template<class Type> inline FudgeStatus tryGetArrayImpl ( fudge_type_id type,
+                                                              const FudgeField & field,
+                                                              std::vector<Type> & target )
     {
         if ( field.type != type )
-            throw fudge::exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+            return FUDGE_INVALID_TYPE_ACCESSOR;
 
         const size_t numelements ( field.numbytes / sizeof ( Type ) );
         if ( numelements )
         {
-            target.resize ( numelements );
-            for ( size_t index ( 0 ); index < numelements; ++index )
-                target [ index ] = reinterpret_cast<const Type *> ( field.data.bytes ) [ index ];
+            const Type * elements ( reinterpret_cast<const Type *> ( field.data.bytes ) );
+            target.assign ( elements, elements + numelements );
         }
         else
             target.clear ( );
+        return FUDGE_OK;
+    }
 
+    template<class Type> inline size_t getArrayImpl ( fudge_type_id type,
+                                                      const FudgeField & field,
+                                                      std::vector<Type> & target )
+    {
+        fudge::exception::throwOnError ( tryGetArrayImpl ( type, field, target ) );
         return target.size ( );
     }
 }
@@ -84,44 +74,42 @@ optional<fudge_i16> field::ordinal ( ) const
 
 bool field::getBoolean ( ) const
 {
-    if ( m_field.type == FUDGE_TYPE_BOOLEAN )
-        return m_field.data.boolean == FUDGE_TRUE;
-    throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    return get<bool> ( );
 }
 
 fudge_byte field::getByte ( ) const
 {
-    return getImpl<fudge_byte, FUDGE_TYPE_BYTE> ( m_field.type, m_field.data.byte );
+    return get<fudge_byte> ( );
 }
 
 fudge_i16 field::getInt16 ( ) const
 {
-    return getImpl<fudge_i16, FUDGE_TYPE_SHORT> ( m_field.type, m_field.data.i16 );
+    return get<fudge_i16> ( );
 }
 
 fudge_i32 field::getInt32 ( ) const
 {
-    return getImpl<fudge_i32, FUDGE_TYPE_INT> ( m_field.type, m_field.data.i32 );
+    return get<fudge_i32> ( );
 }
 
 fudge_i64 field::getInt64 ( ) const
 {
-    return getImpl<fudge_i64, FUDGE_TYPE_LONG> ( m_field.type, m_field.data.i64 );
+    return get<fudge_i64> ( );
 }
 
 fudge_f32 field::getFloat32 ( ) const
 {
-    return getImpl<fudge_f32, FUDGE_TYPE_FLOAT> ( m_field.type, m_field.data.f32 );
+    return get<fudge_f32> ( );
 }
 
 fudge_f64 field::getFloat64 ( ) const
 {
-    return getImpl<fudge_f64, FUDGE_TYPE_DOUBLE> ( m_field.type, m_field.data.f64 );
+    return get<fudge_f64> ( );
 }
 
 string field::getString ( ) const
 {
-    return getImpl<string, FUDGE_TYPE_STRING> ( m_field.type, m_field.data.string );
+    return get<string> ( );
 }
 
 FudgeMsg field::getMessage ( ) const
@@ -133,70 +121,190 @@ FudgeMsg field::getMessage ( ) const
 
 date field::getDate ( ) const
 {
-    return getImpl<date, FUDGE_TYPE_DATE> ( m_field.type, m_field.data.datetime.date );
+    return get<date> ( );
 }
 
 time field::getTime ( ) const
 {
-    return getImpl<time, FUDGE_TYPE_TIME> ( m_field.type, m_field.data.datetime.time );
+    return get<time> ( );
 }
 
 datetime field::getDateTime ( ) const
 {
-    return getImpl<datetime, FUDGE_TYPE_DATETIME> ( m_field.type, m_field.data.datetime );
+    return get<datetime> ( );
 }
 
 bool field::getAsBoolean ( ) const
 {
-    fudge_bool value;
-    exception::throwOnError ( FudgeMsg_getFieldAsBoolean ( &m_field, &value ) );
-    return value == FUDGE_TRUE;
+    return getAs<bool> ( );
 }
 
 fudge_byte field::getAsByte ( ) const
 {
-    return getAsImpl<fudge_byte> ( &m_field, &FudgeMsg_getFieldAsByte );
+    return getAs<fudge_byte> ( );
 }
 
 fudge_i16 field::getAsInt16 ( ) const
 {
-    return getAsImpl<fudge_i16> ( &m_field, &FudgeMsg_getFieldAsI16 );
+    return getAs<fudge_i16> ( );
 }
 
 fudge_i32 field::getAsInt32 ( ) const
 {
-    return getAsImpl<fudge_i32> ( &m_field, &FudgeMsg_getFieldAsI32 );
+    return getAs<fudge_i32> ( );
 }
 
 fudge_i64 field::getAsInt64 ( ) const
 {
-    return getAsImpl<fudge_i64> ( &m_field, &FudgeMsg_getFieldAsI64 );
+    return getAs<fudge_i64> ( );
 }
 
 fudge_f32 field::getAsFloat32 ( ) const
 {
-    return getAsImpl<fudge_f32> ( &m_field, &FudgeMsg_getFieldAsF32 );
+    return getAs<fudge_f32> ( );
 }
 
 fudge_f64 field::getAsFloat64 ( ) const
 {
-    return getAsImpl<fudge_f64> ( &m_field, &FudgeMsg_getFieldAsF64 );
+    return getAs<fudge_f64> ( );
 }
 
 string field::getAsString ( ) const
 {
-    FudgeFieldData data;
-    FudgeTypePayload payload;
-    fudge_i32 numbytes;
+    return getAs<string> ( );
+}
 
-    const FudgeStatus status ( FudgeMsg_getFieldAs ( &m_field, FUDGE_TYPE_STRING, &data, &payload, &numbytes ) );
-    if ( status == FUDGE_COERCION_NOT_REQUIRED )
-        return getString ( );
-    exception::throwOnError ( status );
+FudgeStatus field::tryGetBoolean ( bool & target ) const
+{
+    return tryGet<bool> ( target );
+}
 
-    const string copy ( data.string );
-    FudgeString_release ( data.string );
-    return copy;
+FudgeStatus field::tryGetByte ( fudge_byte & target ) const
+{
+    return tryGet<fudge_byte> ( target );
+}
+
+FudgeStatus field::tryGetInt16 ( fudge_i16 & target ) const
+{
+    return tryGet<fudge_i16> ( target );
+}
+
+FudgeStatus field::tryGetInt32 ( fudge_i32 & target ) const
+{
+    return tryGet<fudge_i32> ( target );
+}
+
+FudgeStatus field::tryGetInt64 ( fudge_i64 & target ) const
+{
+    return tryGet<fudge_i64> ( target );
+}
+
+FudgeStatus field::tryGetFloat32 ( fudge_f32 & target ) const
+{
+    return tryGet<fudge_f32> ( target );
+}
+
+FudgeStatus field::tryGetFloat64 ( fudge_f64 & target ) const
+{
+    return tryGet<fudge_f64> ( target );
+}
+
+FudgeStatus field::tryGetString ( string & target ) const
+{
+    return tryGet<string> ( target );
+}
+
+FudgeStatus field::tryGetMessage ( FudgeMsg & target ) const
+{
+    if ( m_field.type != FUDGE_TYPE_FUDGE_MSG )
+        return FUDGE_INVALID_TYPE_ACCESSOR;
+    target = m_field.data.message;
+    return FUDGE_OK;
+}
+
+FudgeStatus field::tryGetDate ( date & target ) const
+{
+    return tryGet<date> ( target );
+}
+
+FudgeStatus field::tryGetTime ( time & target ) const
+{
+    return tryGet<time> ( target );
+}
+
+FudgeStatus field::tryGetDateTime ( datetime & target ) const
+{
+    return tryGet<datetime> ( target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_byte> & target ) const
+{
+    return tryGetArrayImpl<fudge_byte> ( FUDGE_TYPE_BYTE_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_i16> & target ) const
+{
+    return tryGetArrayImpl<fudge_i16> ( FUDGE_TYPE_SHORT_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_i32> & target ) const
+{
+    return tryGetArrayImpl<fudge_i32> ( FUDGE_TYPE_INT_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_i64> & target ) const
+{
+    return tryGetArrayImpl<fudge_i64> ( FUDGE_TYPE_LONG_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_f32> & target ) const
+{
+    return tryGetArrayImpl<fudge_f32> ( FUDGE_TYPE_FLOAT_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetArray ( std::vector<fudge_f64> & target ) const
+{
+    return tryGetArrayImpl<fudge_f64> ( FUDGE_TYPE_DOUBLE_ARRAY, m_field, target );
+}
+
+FudgeStatus field::tryGetAsBoolean ( bool & target ) const
+{
+    return tryGetAs<bool> ( target );
+}
+
+FudgeStatus field::tryGetAsByte ( fudge_byte & target ) const
+{
+    return tryGetAs<fudge_byte> ( target );
+}
+
+FudgeStatus field::tryGetAsInt16 ( fudge_i16 & target ) const
+{
+    return tryGetAs<fudge_i16> ( target );
+}
+
+FudgeStatus field::tryGetAsInt32 ( fudge_i32 & target ) const
+{
+    return tryGetAs<fudge_i32> ( target );
+}
+
+FudgeStatus field::tryGetAsInt64 ( fudge_i64 & target ) const
+{
+    return tryGetAs<fudge_i64> ( target );
+}
+
+FudgeStatus field::tryGetAsFloat32 ( fudge_f32 & target ) const
+{
+    return tryGetAs<fudge_f32> ( target );
+}
+
+FudgeStatus field::tryGetAsFloat64 ( fudge_f64 & target ) const
+{
+    return tryGetAs<fudge_f64> ( target );
+}
+
+FudgeStatus field::tryGetAsString ( string & target ) const
+{
+    return tryGetAs<string> ( target );
 }
 
 size_t field::getArray ( std::vector<fudge_byte> & target ) const
@@ -229,6 +337,25 @@ size_t field::getArray ( std::vector<fudge_f64> & target ) const
     return getArrayImpl<fudge_f64> ( FUDGE_TYPE_DOUBLE_ARRAY, m_field, target );
 }
 
+slice field::stringView ( ) const
+{
+    if ( m_field.type != FUDGE_TYPE_STRING )
+        throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    return m_field.data.string ? slice ( FudgeString_getData ( m_field.data.string ), FudgeString_getSize ( m_field.data.string ) )
+                               : slice ( );
+}
+
+const fudge_byte * field::arrayBytes ( fudge_type_id type ) const
+{
+    if ( m_field.type != type )
+    {
+        // Fixed width byte arrays can be viewed as plain bytes
+        if ( type != FUDGE_TYPE_BYTE_ARRAY || m_field.type < FUDGE_TYPE_BYTE_ARRAY_4 || m_field.type > FUDGE_TYPE_BYTE_ARRAY_512 )
+            throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    }
+    return m_field.data.bytes;
+}
+
 size_t field::numelements ( ) const
 {
     size_t width;
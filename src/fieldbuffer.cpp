@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/fieldbuffer.hpp"
+#include "fudge-cpp/exception.hpp"
+#include <stdlib.h>
+
+namespace fudge {
+
+field_buffer::field_buffer ( )
+    : m_data ( 0 )
+    , m_numbytes ( 0 )
+{
+}
+
+field_buffer::field_buffer ( size_t numbytes )
+    : m_data ( 0 )
+    , m_numbytes ( 0 )
+{
+    allocate ( numbytes );
+}
+
+field_buffer::~field_buffer ( )
+{
+    clear ( );
+}
+
+void field_buffer::allocate ( size_t numbytes )
+{
+    clear ( );
+    if ( numbytes )
+    {
+        if ( ! ( m_data = static_cast<fudge_byte *> ( malloc ( numbytes ) ) ) )
+            throw exception ( FUDGE_OUT_OF_MEMORY );
+        m_numbytes = numbytes;
+    }
+}
+
+void field_buffer::clear ( )
+{
+    free ( m_data );
+    m_data = 0;
+    m_numbytes = 0;
+}
+
+fudge_byte * field_buffer::release ( )
+{
+    fudge_byte * data ( m_data );
+    m_data = 0;
+    m_numbytes = 0;
+    return data;
+}
+
+}
+
@@ -0,0 +1,209 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/fieldindex.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge/message.h"
+#include "fudge/string.h"
+#include <string.h>
+
+namespace
+{
+    inline bool nameEquals ( const FudgeString name, const fudge_byte * bytes, size_t numbytes, FudgeString interned )
+    {
+        if ( name == interned )
+            return true;
+        const size_t size ( FudgeString_getSize ( name ) );
+        return size == numbytes && ( ! size || memcmp ( FudgeString_getData ( name ), bytes, size ) == 0 );
+    }
+
+    inline size_t hashOrdinal ( fudge_i16 ordinal )
+    {
+        // Spread consecutive ordinals across the table
+        return static_cast<size_t> ( static_cast<unsigned short> ( ordinal ) ) * 2654435761u;
+    }
+}
+
+namespace fudge {
+
+field_index::field_index ( const message & source )
+    : m_message ( source )
+    , m_numnames ( 0 )
+    , m_numordinals ( 0 )
+{
+    refresh ( );
+}
+
+bool field_index::valid ( ) const
+{
+    return m_message.size ( ) == m_fields.size ( );
+}
+
+void field_index::refresh ( )
+{
+    const size_t count ( m_message.size ( ) );
+    const size_t indexed ( m_fields.size ( ) );
+    if ( count == indexed )
+        return;
+
+    // Fudge-C can only return every field, but only the new ones need
+    // adding to the tables
+    m_fields.resize ( count );
+    const fudge_i32 retrieved ( FudgeMsg_getFields ( &( m_fields [ 0 ] ), count, m_message.raw ( ) ) );
+    if ( retrieved < 0 || static_cast<size_t> ( retrieved ) != count )
+    {
+        m_fields.resize ( indexed );
+        throw exception ( FUDGE_INTERNAL_LIBRARY_ERROR );
+    }
+
+    grow ( m_names, count );
+    grow ( m_ordinals, count );
+    for ( size_t position ( indexed ); position < count; ++position )
+    {
+        insertName ( position );
+        insertOrdinal ( position );
+    }
+}
+
+bool field_index::find ( field & target, const string & name ) const
+{
+    checkValid ( );
+    return findName ( target, name.data ( ), name.size ( ), field_key::hashName ( name.data ( ), name.size ( ) ), name.raw ( ) );
+}
+
+bool field_index::find ( field & target, fudge_i16 ordinal ) const
+{
+    checkValid ( );
+    if ( ! m_numordinals )
+        return false;
+
+    const size_t mask ( m_ordinals.size ( ) - 1 );
+    for ( size_t index ( hashOrdinal ( ordinal ) & mask ); m_ordinals [ index ].position; index = ( index + 1 ) & mask )
+    {
+        const FudgeField & candidate ( m_fields [ m_ordinals [ index ].position - 1 ] );
+        if ( candidate.ordinal == ordinal )
+        {
+            target = field ( candidate );
+            return true;
+        }
+    }
+    return false;
+}
+
+bool field_index::find ( field & target, const field_key & key ) const
+{
+    if ( key.ordinal ( ) )
+        return find ( target, key.ordinal ( ).get ( ) );
+
+    checkValid ( );
+    const string & name ( key.name ( ).get ( ) );
+    return findName ( target, name.data ( ), name.size ( ), key.hash ( ), name.raw ( ) );
+}
+
+void field_index::grow ( std::vector<slot> & table, size_t required )
+{
+    // Keep tables no more than half full
+    size_t capacity ( table.empty ( ) ? 16 : table.size ( ) );
+    while ( capacity < required * 2 )
+        capacity *= 2;
+    if ( capacity == table.size ( ) )
+        return;
+
+    const slot empty = { 0, 0 };
+    std::vector<slot> resized ( capacity, empty );
+    const size_t mask ( capacity - 1 );
+    for ( size_t source ( 0 ); source < table.size ( ); ++source )
+    {
+        if ( table [ source ].position )
+        {
+            size_t index ( table [ source ].hash & mask );
+            while ( resized [ index ].position )
+                index = ( index + 1 ) & mask;
+            resized [ index ] = table [ source ];
+        }
+    }
+    table.swap ( resized );
+}
+
+void field_index::insertName ( size_t position )
+{
+    const FudgeField & source ( m_fields [ position ] );
+    if ( ! ( source.flags & FUDGE_FIELD_HAS_NAME ) )
+        return;
+
+    const fudge_byte * bytes ( FudgeString_getData ( source.name ) );
+    const size_t numbytes ( FudgeString_getSize ( source.name ) );
+    const size_t hash ( field_key::hashName ( bytes, numbytes ) );
+
+    const size_t mask ( m_names.size ( ) - 1 );
+    size_t index ( hash & mask );
+    for ( ; m_names [ index ].position; index = ( index + 1 ) & mask )
+    {
+        // Only the first field with a name is indexed
+        if ( m_names [ index ].hash == hash && nameEquals ( m_fields [ m_names [ index ].position - 1 ].name, bytes, numbytes, source.name ) )
+            return;
+    }
+
+    m_names [ index ].hash = hash;
+    m_names [ index ].position = position + 1;
+    ++m_numnames;
+}
+
+void field_index::insertOrdinal ( size_t position )
+{
+    const FudgeField & source ( m_fields [ position ] );
+    if ( ! ( source.flags & FUDGE_FIELD_HAS_ORDINAL ) )
+        return;
+
+    const size_t hash ( hashOrdinal ( source.ordinal ) );
+    const size_t mask ( m_ordinals.size ( ) - 1 );
+    size_t index ( hash & mask );
+    for ( ; m_ordinals [ index ].position; index = ( index + 1 ) & mask )
+    {
+        if ( m_fields [ m_ordinals [ index ].position - 1 ].ordinal == source.ordinal )
+            return;
+    }
+
+    m_ordinals [ index ].hash = hash;
+    m_ordinals [ index ].position = position + 1;
+    ++m_numordinals;
+}
+
+bool field_index::findName ( field & target, const fudge_byte * bytes, size_t numbytes, size_t hash, FudgeString interned ) const
+{
+    if ( ! m_numnames )
+        return false;
+
+    const size_t mask ( m_names.size ( ) - 1 );
+    for ( size_t index ( hash & mask ); m_names [ index ].position; index = ( index + 1 ) & mask )
+    {
+        const FudgeField & candidate ( m_fields [ m_names [ index ].position - 1 ] );
+        if ( m_names [ index ].hash == hash && nameEquals ( candidate.name, bytes, numbytes, interned ) )
+        {
+            target = field ( candidate );
+            return true;
+        }
+    }
+    return false;
+}
+
+void field_index::checkValid ( ) const
+{
+    if ( ! valid ( ) )
+        throw exception ( FUDGE_INVALID_INDEX );
+}
+
+}
+
@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/fieldkey.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "mutex.hpp"
+#include "fudge/string.h"
+#include <map>
+#include <string.h>
+
+namespace
+{
+    using fudge::threading::mutex;
+    using fudge::threading::scopedlock;
+
+    // Interned names, looked up by hash and then compared byte by byte.
+    // Entries are never removed, so the table's reference keeps each name
+    // alive for the life of the process and the entries never move.
+    class interntable
+    {
+        public:
+            const fudge::optional<fudge::string> & find ( const fudge_byte * bytes, size_t numbytes, size_t hash )
+            {
+                scopedlock lock ( m_lock );
+
+                std::pair<names::iterator, names::iterator> range ( m_names.equal_range ( hash ) );
+                for ( names::iterator it ( range.first ); it != range.second; ++it )
+                {
+                    const fudge::string & candidate ( it->second.get ( ) );
+                    if ( candidate.size ( ) == numbytes && ( ! numbytes || memcmp ( candidate.data ( ), bytes, numbytes ) == 0 ) )
+                        return it->second;
+                }
+
+                const fudge::string name ( bytes, numbytes, fudge::string::UTF8 );
+                return m_names.insert ( names::value_type ( hash, name ) )->second;
+            }
+
+        private:
+            typedef std::multimap<size_t, fudge::optional<fudge::string> > names;
+
+            mutex m_lock;
+            names m_names;
+    };
+
+    interntable & internTable ( )
+    {
+        static interntable table;
+        return table;
+    }
+
+    // Shared by all ordinal only keys
+    const fudge::optional<fudge::string> NoName;
+}
+
+namespace fudge {
+
+field_key::field_key ( const char * name )
+    : m_name ( &NoName )
+    , m_hash ( 0 )
+{
+    if ( ! name )
+        throw exception ( FUDGE_NULL_POINTER );
+    setName ( reinterpret_cast<const fudge_byte *> ( name ), strlen ( name ) );
+}
+
+field_key::field_key ( const string & name )
+    : m_name ( &NoName )
+    , m_hash ( 0 )
+{
+    setName ( name.data ( ), name.size ( ) );
+}
+
+field_key::field_key ( fudge_i16 ordinal )
+    : m_name ( &NoName )
+    , m_ordinal ( ordinal )
+    , m_hash ( 0 )
+{
+}
+
+field_key::field_key ( const char * name, fudge_i16 ordinal )
+    : m_name ( &NoName )
+    , m_ordinal ( ordinal )
+    , m_hash ( 0 )
+{
+    if ( ! name )
+        throw exception ( FUDGE_NULL_POINTER );
+    setName ( reinterpret_cast<const fudge_byte *> ( name ), strlen ( name ) );
+}
+
+field_key::field_key ( const string & name, fudge_i16 ordinal )
+    : m_name ( &NoName )
+    , m_ordinal ( ordinal )
+    , m_hash ( 0 )
+{
+    setName ( name.data ( ), name.size ( ) );
+}
+
+optional<string> field_key::copyName ( ) const
+{
+    if ( ! *m_name )
+        return optional<string> ( );
+    const string & name ( m_name->get ( ) );
+    return string ( name.data ( ), name.size ( ), string::UTF8 );
+}
+
+const string & field_key::intern ( const fudge_byte * bytes, size_t numbytes )
+{
+    if ( ! bytes && numbytes )
+        throw exception ( FUDGE_NULL_POINTER );
+    return internTable ( ).find ( bytes, numbytes, hashName ( bytes, numbytes ) ).get ( );
+}
+
+const string & field_key::intern ( const string & name )
+{
+    return intern ( name.data ( ), name.size ( ) );
+}
+
+size_t field_key::hashName ( const fudge_byte * bytes, size_t numbytes )
+{
+    // FNV-1a
+    size_t hash ( static_cast<size_t> ( 2166136261u ) );
+    for ( size_t index ( 0 ); index < numbytes; ++index )
+    {
+        hash ^= static_cast<unsigned char> ( bytes [ index ] );
+        hash *= static_cast<size_t> ( 16777619u );
+    }
+    return hash;
+}
+
+void field_key::setName ( const fudge_byte * bytes, size_t numbytes )
+{
+    if ( ! bytes && numbytes )
+        throw exception ( FUDGE_NULL_POINTER );
+    m_hash = hashName ( bytes, numbytes );
+    m_name = &( internTable ( ).find ( bytes, numbytes, m_hash ) );
+}
+
+bool operator== ( const field_key & left, const field_key & right )
+{
+    if ( static_cast<bool> ( left.name ( ) ) != static_cast<bool> ( right.name ( ) ) ||
+         static_cast<bool> ( left.ordinal ( ) ) != static_cast<bool> ( right.ordinal ( ) ) )
+        return false;
+
+    // Names are always interned, so equal names are the same string
+    return left.rawName ( ) == right.rawName ( ) &&
+           ( ! left.ordinal ( ) || left.ordinal ( ).get ( ) == right.ordinal ( ).get ( ) );
+}
+
+bool operator!= ( const field_key & left, const field_key & right )
+{
+    return ! ( left == right );
+}
+
+}
+
@@ -0,0 +1,165 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/fieldselector.hpp"
+#include "fudge-cpp/exception.hpp"
+#include <algorithm>
+
+namespace
+{
+    typedef std::pair<std::string, size_t> namedselection;
+
+    int compareName ( const std::string & left, const fudge::slice & right )
+    {
+        const size_t common ( std::min ( left.size ( ), right.size ( ) ) );
+        const int result ( common ? memcmp ( left.data ( ), right.data ( ), common ) : 0 );
+        if ( result )
+            return result;
+        return left.size ( ) < right.size ( ) ? -1 : ( left.size ( ) > right.size ( ) ? 1 : 0 );
+    }
+
+    struct namelessthan
+    {
+        bool operator() ( const namedselection & left, const fudge::slice & right ) const
+        {
+            return compareName ( left.first, right ) < 0;
+        }
+    };
+}
+
+namespace fudge {
+
+field_selector::field_selector ( )
+{
+}
+
+field_selector::field_selector ( const field_selector & source )
+    : m_ordinals ( source.m_ordinals )
+    , m_names ( source.m_names )
+{
+    m_nested.reserve ( source.m_nested.size ( ) );
+    for ( size_t index ( 0 ); index < source.m_nested.size ( ); ++index )
+        m_nested.push_back ( new field_selector ( *source.m_nested [ index ] ) );
+}
+
+field_selector & field_selector::operator= ( const field_selector & source )
+{
+    if ( this != &source )
+    {
+        field_selector copy ( source );
+        clear ( );
+        m_ordinals.swap ( copy.m_ordinals );
+        m_names.swap ( copy.m_names );
+        m_nested.swap ( copy.m_nested );
+    }
+    return *this;
+}
+
+field_selector::~field_selector ( )
+{
+    clear ( );
+}
+
+field_selector & field_selector::add ( fudge_i16 ordinal )
+{
+    m_ordinals [ ordinal ] = 0;
+    return *this;
+}
+
+field_selector & field_selector::add ( const string & name )
+{
+    namedSlot ( name ) = 0;
+    return *this;
+}
+
+field_selector & field_selector::select ( fudge_i16 ordinal )
+{
+    return nestedSelector ( m_ordinals [ ordinal ] );
+}
+
+field_selector & field_selector::select ( const string & name )
+{
+    return nestedSelector ( namedSlot ( name ) );
+}
+
+bool field_selector::empty ( ) const
+{
+    return m_ordinals.empty ( ) && m_names.empty ( );
+}
+
+void field_selector::clear ( )
+{
+    for ( size_t index ( 0 ); index < m_nested.size ( ); ++index )
+        delete m_nested [ index ];
+    m_nested.clear ( );
+    m_names.clear ( );
+    m_ordinals.clear ( );
+}
+
+bool field_selector::selects ( bool hasordinal, fudge_i16 ordinal, const slice & name, const field_selector * & nested ) const
+{
+    const size_t * byordinal ( 0 );
+    if ( hasordinal )
+    {
+        std::map<fudge_i16, size_t>::const_iterator iterator ( m_ordinals.find ( ordinal ) );
+        if ( iterator != m_ordinals.end ( ) )
+            byordinal = &iterator->second;
+    }
+    const size_t * byname ( name.data ( ) ? findName ( name ) : 0 );
+
+    if ( ! byordinal && ! byname )
+        return false;
+
+    // A whole field selection beats a partial one
+    if ( ( byordinal && ! *byordinal ) || ( byname && ! *byname ) )
+        nested = 0;
+    else
+        nested = m_nested [ ( byordinal ? *byordinal : *byname ) - 1 ];
+    return true;
+}
+
+size_t & field_selector::namedSlot ( const string & name )
+{
+    if ( ! name.raw ( ) )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    const slice bytes ( name.data ( ), name.size ( ) );
+    std::vector<namedselection>::iterator iterator ( std::lower_bound ( m_names.begin ( ), m_names.end ( ), bytes, namelessthan ( ) ) );
+    if ( iterator == m_names.end ( ) || compareName ( iterator->first, bytes ) )
+        iterator = m_names.insert ( iterator, namedselection ( bytes.str ( ), 0 ) );
+    return iterator->second;
+}
+
+field_selector & field_selector::nestedSelector ( size_t & slot )
+{
+    if ( ! slot )
+    {
+        m_nested.reserve ( m_nested.size ( ) + 1 );
+        m_nested.push_back ( new field_selector );
+        slot = m_nested.size ( );
+    }
+    return *m_nested [ slot - 1 ];
+}
+
+const size_t * field_selector::findName ( const slice & name ) const
+{
+    std::vector<namedselection>::const_iterator iterator ( std::lower_bound ( m_names.begin ( ), m_names.end ( ), name, namelessthan ( ) ) );
+    if ( iterator == m_names.end ( ) || compareName ( iterator->first, name ) )
+        return 0;
+    return &iterator->second;
+}
+
+}
+
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/fieldtraits.hpp"
+#include "fudge/message_ex.h"
+#include "fudge/string.h"
+
+namespace
+{
+    // Fudge-C's coercions, leaving the target alone unless they succeed
+    template<class Type> inline FudgeStatus coerceImpl ( const FudgeField & source,
+                                                         FudgeStatus ( *function ) ( const FudgeField *, Type * ),
+                                                         Type & target )
+    {
+        Type value;
+        const FudgeStatus status ( function ( &source, &value ) );
+        if ( status == FUDGE_OK )
+            target = value;
+        return status;
+    }
+
+    template<class Type> inline FudgeStatus coerceExact ( const FudgeField & source, Type & target )
+    {
+        if ( source.type != fudge::field_traits<Type>::id )
+            return FUDGE_INVALID_TYPE_COERCION;
+        target = fudge::field_traits<Type>::value ( source );
+        return FUDGE_OK;
+    }
+}
+
+namespace fudge {
+
+const fudge_type_id field_traits<bool>::id;
+const fudge_type_id field_traits<fudge_byte>::id;
+const fudge_type_id field_traits<fudge_i16>::id;
+const fudge_type_id field_traits<fudge_i32>::id;
+const fudge_type_id field_traits<fudge_i64>::id;
+const fudge_type_id field_traits<fudge_f32>::id;
+const fudge_type_id field_traits<fudge_f64>::id;
+const fudge_type_id field_traits<string>::id;
+const fudge_type_id field_traits<date>::id;
+const fudge_type_id field_traits<time>::id;
+const fudge_type_id field_traits<datetime>::id;
+
+const fudge_i32 field_traits<bool>::width;
+const fudge_i32 field_traits<fudge_byte>::width;
+const fudge_i32 field_traits<fudge_i16>::width;
+const fudge_i32 field_traits<fudge_i32>::width;
+const fudge_i32 field_traits<fudge_i64>::width;
+const fudge_i32 field_traits<fudge_f32>::width;
+const fudge_i32 field_traits<fudge_f64>::width;
+const fudge_i32 field_traits<string>::width;
+const fudge_i32 field_traits<date>::width;
+const fudge_i32 field_traits<time>::width;
+const fudge_i32 field_traits<datetime>::width;
+
+FudgeStatus field_traits<bool>::coerce ( const FudgeField & source, bool & target )
+{
+    fudge_bool value;
+    const FudgeStatus status ( FudgeMsg_getFieldAsBoolean ( &source, &value ) );
+    if ( status == FUDGE_OK )
+        target = value == FUDGE_TRUE;
+    return status;
+}
+
+FudgeStatus field_traits<fudge_byte>::coerce ( const FudgeField & source, fudge_byte & target )
+{
+    return coerceImpl<fudge_byte> ( source, &FudgeMsg_getFieldAsByte, target );
+}
+
+FudgeStatus field_traits<fudge_i16>::coerce ( const FudgeField & source, fudge_i16 & target )
+{
+    return coerceImpl<fudge_i16> ( source, &FudgeMsg_getFieldAsI16, target );
+}
+
+FudgeStatus field_traits<fudge_i32>::coerce ( const FudgeField & source, fudge_i32 & target )
+{
+    return coerceImpl<fudge_i32> ( source, &FudgeMsg_getFieldAsI32, target );
+}
+
+FudgeStatus field_traits<fudge_i64>::coerce ( const FudgeField & source, fudge_i64 & target )
+{
+    return coerceImpl<fudge_i64> ( source, &FudgeMsg_getFieldAsI64, target );
+}
+
+FudgeStatus field_traits<fudge_f32>::coerce ( const FudgeField & source, fudge_f32 & target )
+{
+    return coerceImpl<fudge_f32> ( source, &FudgeMsg_getFieldAsF32, target );
+}
+
+FudgeStatus field_traits<fudge_f64>::coerce ( const FudgeField & source, fudge_f64 & target )
+{
+    return coerceImpl<fudge_f64> ( source, &FudgeMsg_getFieldAsF64, target );
+}
+
+FudgeStatus field_traits<string>::coerce ( const FudgeField & source, string & target )
+{
+    FudgeFieldData data;
+    FudgeTypePayload payload;
+    fudge_i32 numbytes;
+
+    const FudgeStatus status ( FudgeMsg_getFieldAs ( &source, FUDGE_TYPE_STRING, &data, &payload, &numbytes ) );
+    if ( status == FUDGE_COERCION_NOT_REQUIRED )
+    {
+        target = value ( source );
+        return FUDGE_OK;
+    }
+    if ( status != FUDGE_OK )
+        return status;
+
+    target = string ( data.string );
+    FudgeString_release ( data.string );
+    return FUDGE_OK;
+}
+
+FudgeStatus field_traits<date>::coerce ( const FudgeField & source, date & target )
+{
+    return coerceExact ( source, target );
+}
+
+FudgeStatus field_traits<time>::coerce ( const FudgeField & source, time & target )
+{
+    return coerceExact ( source, target );
+}
+
+FudgeStatus field_traits<datetime>::coerce ( const FudgeField & source, datetime & target )
+{
+    return coerceExact ( source, target );
+}
+
+}
+
@@ -15,8 +15,14 @@
  */
 #include "fudge-cpp/fudge.hpp"
 #include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/allocator.hpp"
 #include "fudge/fudge.h"
 
+namespace
+{
+    fudge::allocator * defaultallocator ( 0 );
+}
+
 namespace fudge {
 
 void fudge::init ( )
@@ -24,5 +30,16 @@ void fudge::init ( )
     exception::throwOnError ( Fudge_init ( ) );
 }
 
+void fudge::init ( allocator & target )
+{
+    init ( );
+    defaultallocator = &target;
+}
+
+allocator & fudge::defaultAllocator ( )
+{
+    return defaultallocator ? *defaultallocator : allocator::standard ( );
+}
+
 }
 
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/gatherlist.hpp"
+#include "fudge-cpp/exception.hpp"
+#include <algorithm>
+#include <string.h>
+
+namespace fudge {
+
+gather_list::gather_list ( )
+    : m_used ( 0 )
+    , m_numbytes ( 0 )
+    , m_dirty ( false )
+{
+}
+
+const iovec * gather_list::segments ( ) const
+{
+    if ( m_dirty )
+    {
+        m_iovecs.resize ( m_segments.size ( ) );
+        for ( size_t index ( 0 ); index < m_segments.size ( ); ++index )
+        {
+            const segment & source ( m_segments [ index ] );
+            m_iovecs [ index ].iov_base = const_cast<void *> ( source.borrowed ? source.borrowed : &( m_storage [ source.offset ] ) );
+            m_iovecs [ index ].iov_len = source.numbytes;
+        }
+        m_dirty = false;
+    }
+    return m_iovecs.empty ( ) ? 0 : &( m_iovecs [ 0 ] );
+}
+
+size_t gather_list::count ( ) const
+{
+    return m_segments.size ( );
+}
+
+void gather_list::clear ( )
+{
+    m_segments.clear ( );
+    m_iovecs.clear ( );
+    m_used = 0;
+    m_numbytes = 0;
+    m_dirty = false;
+}
+
+fudge_byte * gather_list::append ( size_t numbytes )
+{
+    if ( ! numbytes )
+        return 0;
+
+    if ( m_used + numbytes > m_storage.size ( ) )
+        m_storage.resize ( std::max ( m_used + numbytes, m_storage.size ( ) * 2 ) );
+
+    // Consecutive held segments are merged
+    if ( m_segments.empty ( ) || m_segments.back ( ).borrowed )
+    {
+        const segment held = { 0, m_used, 0 };
+        m_segments.push_back ( held );
+    }
+    m_segments.back ( ).numbytes += numbytes;
+
+    fudge_byte * target ( &( m_storage [ 0 ] ) + m_used );
+    m_used += numbytes;
+    m_numbytes += numbytes;
+    m_dirty = true;
+    return target;
+}
+
+void gather_list::appendBorrowed ( const void * bytes, size_t numbytes )
+{
+    if ( ! numbytes )
+        return;
+    if ( ! bytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    const segment borrowed = { bytes, 0, numbytes };
+    m_segments.push_back ( borrowed );
+    m_numbytes += numbytes;
+    m_dirty = true;
+}
+
+void gather_list::flatten ( std::vector<fudge_byte> & target ) const
+{
+    const iovec * source ( segments ( ) );
+    const size_t start ( target.size ( ) );
+    target.resize ( start + m_numbytes );
+
+    fudge_byte * position ( target.empty ( ) ? 0 : &( target [ start ] ) );
+    for ( size_t index ( 0 ); index < count ( ); ++index )
+    {
+        memcpy ( position, source [ index ].iov_base, source [ index ].iov_len );
+        position += source [ index ].iov_len;
+    }
+}
+
+}
+
@@ -15,10 +15,42 @@
  */
 #include "fudge-cpp/message.hpp"
 #include "fudge-cpp/exception.hpp"
+#include "atomic.hpp"
+#include "encoder.hpp"
+#include "wire.hpp"
+#include "fudge/codec.h"
+#include "fudge/envelope.h"
 #include "fudge/message.h"
+#include "fudge/string.h"
+#include <stdlib.h>
 
 namespace
 {
+    // Messages containing user types can only be sized by encoding them
+    fudge_i32 fudgeCEncodedSize ( FudgeMsg message )
+    {
+        FudgeMsgEnvelope envelope;
+        fudge::exception::throwOnError ( FudgeMsgEnvelope_create ( &envelope, 0, 0, 0, message ) );
+
+        fudge_byte * bytes;
+        fudge_i32 numbytes;
+        const FudgeStatus status ( FudgeCodec_encodeMsg ( envelope, &bytes, &numbytes ) );
+        FudgeMsgEnvelope_release ( envelope );
+        fudge::exception::throwOnError ( status );
+
+        free ( bytes );
+        return numbytes - fudge::wire::EnvelopeHeaderSize;
+    }
+
+    // Messages with up to this many fields are searched by key without
+    // going through Fudge-C's name comparisons
+    static const size_t KeyScanLimit = 32;
+
+    inline bool namesMatch ( const FudgeString left, const FudgeString right )
+    {
+        return left == right || FudgeString_compare ( left, right ) == 0;
+    }
+
     inline const FudgeString convertNameArg ( const fudge::optional<fudge::string> & name )
     {
         return name ? name.get ( ).raw ( ) : 0;
@@ -29,6 +61,24 @@ namespace
         return ordinal ? &( *ordinal ) : 0;
     }
 
+    // Only types whose payload is a block of bytes can be given a buffer
+    FudgeStatus checkBufferField ( fudge_type_id type, size_t numbytes )
+    {
+        if ( numbytes > 0x7fffffff )
+            return FUDGE_OUT_OF_MEMORY;
+        if ( ! fudge::wire::isStandardType ( type ) || type == FUDGE_TYPE_BYTE_ARRAY )
+            return FUDGE_OK;
+
+        const size_t elementwidth ( fudge::wire::arrayElementWidth ( type ) );
+        if ( ! elementwidth )
+            return FUDGE_INVALID_TYPE_COERCION;
+
+        const fudge_i32 width ( fudge::wire::fixedWidth ( type ) );
+        if ( width >= 0 ? numbytes != static_cast<size_t> ( width ) : numbytes % elementwidth )
+            return FUDGE_UNKNOWN_FIELD_WIDTH;
+        return FUDGE_OK;
+    }
+
     template<class Type> inline void addFieldImpl ( FudgeMsg message,
                                                     FudgeStatus ( *function ) ( FudgeMsg, const FudgeString, const fudge_i16 *, Type ),
                                                     const Type & value,
@@ -53,8 +103,20 @@ namespace
 
 namespace fudge {
 
+const fudge_type_id field_traits<message>::id;
+const fudge_i32 field_traits<message>::width;
+
+FudgeStatus field_traits<message>::coerce ( const FudgeField & source, message & target )
+{
+    if ( source.type != id )
+        return FUDGE_INVALID_TYPE_COERCION;
+    target = value ( source );
+    return FUDGE_OK;
+}
+
 const optional<string> message::noname;
 const optional<fudge_i16> message::noordinal;
+const size_t message::LocalFields;
 
 message::message ( )
     : m_message ( 0 )
@@ -83,14 +145,16 @@ message & message::operator= ( const message & source )
         exception::throwOnError ( FudgeMsg_retain ( source.m_message ) );
         m_message = source.m_message;
 
-        exception::throwOnError ( FudgeMsg_release ( oldMessage ) );
+        if ( oldMessage )
+            exception::throwOnError ( FudgeMsg_release ( oldMessage ) );
     }
     return *this;
 }
 
 message::~message ( )
 {
-    exception::throwOnError ( FudgeMsg_release ( m_message ) );
+    if ( m_message )
+        exception::throwOnError ( FudgeMsg_release ( m_message ) );
 }
 
 size_t message::size ( ) const
@@ -108,14 +172,14 @@ field message::getFieldAt ( size_t index ) const
 field message::getField ( const string & name ) const
 {
     FudgeField raw;
-    exception::throwOnError ( FudgeMsg_getFieldByName ( &raw, m_message, name.raw ( ) ) );
+    exception::throwOnError ( findField ( raw, name ) );
     return raw;
 }
 
 field message::getField ( fudge_i16 ordinal ) const
 {
     FudgeField raw;
-    exception::throwOnError ( FudgeMsg_getFieldByOrdinal ( &raw, m_message, ordinal ) );
+    exception::throwOnError ( findField ( raw, ordinal ) );
     return raw;
 }
 
@@ -123,7 +187,7 @@ bool message::getField ( field & target, const string & name ) const
 {
     FudgeStatus status;
     FudgeField raw;
-    if ( ( status = FudgeMsg_getFieldByName ( &raw, m_message, name.raw ( ) ) ) != FUDGE_OK )
+    if ( ( status = findField ( raw, name ) ) != FUDGE_OK )
     {
         if ( status != FUDGE_INVALID_NAME )
             exception::throwOnError ( status );
@@ -140,7 +204,7 @@ bool message::getField ( field & target, fudge_i16 ordinal ) const
 {
     FudgeStatus status;
     FudgeField raw;
-    if ( ( status = FudgeMsg_getFieldByOrdinal ( &raw, m_message, ordinal ) ) != FUDGE_OK )
+    if ( ( status = findField ( raw, ordinal ) ) != FUDGE_OK )
     {
         if ( status != FUDGE_INVALID_ORDINAL )
             exception::throwOnError ( status );
@@ -153,22 +217,176 @@ bool message::getField ( field & target, fudge_i16 ordinal ) const
     }
 }
 
+field message::getField ( const field_key & key ) const
+{
+    FudgeField raw;
+    exception::throwOnError ( findField ( raw, key ) );
+    return raw;
+}
+
+bool message::getField ( field & target, const field_key & key ) const
+{
+    FudgeField raw;
+    const FudgeStatus status ( findField ( raw, key ) );
+    if ( status == FUDGE_INVALID_NAME || status == FUDGE_INVALID_ORDINAL )
+        return false;
+    exception::throwOnError ( status );
+
+    target = field ( raw );
+    return true;
+}
+
+FudgeStatus message::tryGetFieldAt ( field & target, size_t index ) const
+{
+    FudgeField raw;
+    const FudgeStatus status ( FudgeMsg_getFieldAtIndex ( &raw, m_message, index ) );
+    if ( status == FUDGE_OK )
+        target = field ( raw );
+    return status;
+}
+
+FudgeStatus message::tryGetField ( field & target, const string & name ) const
+{
+    FudgeField raw;
+    const FudgeStatus status ( findField ( raw, name ) );
+    if ( status == FUDGE_OK )
+        target = field ( raw );
+    return status;
+}
+
+FudgeStatus message::tryGetField ( field & target, fudge_i16 ordinal ) const
+{
+    FudgeField raw;
+    const FudgeStatus status ( findField ( raw, ordinal ) );
+    if ( status == FUDGE_OK )
+        target = field ( raw );
+    return status;
+}
+
+FudgeStatus message::tryGetField ( field & target, const field_key & key ) const
+{
+    FudgeField raw;
+    const FudgeStatus status ( findField ( raw, key ) );
+    if ( status == FUDGE_OK )
+        target = field ( raw );
+    return status;
+}
+
 void message::getFields ( std::vector<field> & fields ) const
 {
-    fields.clear ( );
+    FudgeField local [ LocalFields ];
+    const size_t count ( localFields ( local ) );
+    if ( count <= LocalFields )
+        fields.assign ( local, local + count );
+    else
+    {
+        std::vector<FudgeField> all;
+        allFields ( all );
+        fields.assign ( all.begin ( ), all.end ( ) );
+    }
+}
 
-    const size_t count ( size ( ) );
-    if ( ! count )
-        return;
+// The fields of a message as they were when begin was called, shared by
+// the copies of the iterator it returned
+struct message::const_iterator::snapshot
+{
+    snapshot ( )
+        : count ( 1 )
+    {
+    }
 
-    FudgeField * array ( new FudgeField [ count ] );
-    const fudge_i32 retrieved ( FudgeMsg_getFields ( array, count, m_message ) );
-    if ( retrieved > 0 )
+    threading::atomiccount count;
+    std::vector<FudgeField> fields;
+};
+
+message::const_iterator message::begin ( ) const
+{
+    if ( ! size ( ) )
+        return const_iterator ( m_message, 0, 0 );
+
+    const_iterator::snapshot * fields ( new const_iterator::snapshot );
+    try
+    {
+        allFields ( fields->fields );
+    }
+    catch ( ... )
     {
-        fields.resize ( retrieved );
-        fields.assign ( array, array + retrieved );
+        delete fields;
+        throw;
     }
-    delete [] array;
+    return const_iterator ( m_message, 0, fields );
+}
+
+message::const_iterator message::end ( ) const
+{
+    return const_iterator ( m_message, size ( ), 0 );
+}
+
+message::const_iterator::const_iterator ( FudgeMsg message, size_t index, snapshot * fields )
+    : m_message ( message )
+    , m_index ( index )
+    , m_snapshot ( fields )
+    , m_fetched ( false )
+{
+}
+
+message::const_iterator::const_iterator ( const const_iterator & source )
+    : m_message ( source.m_message )
+    , m_index ( source.m_index )
+    , m_snapshot ( source.m_snapshot )
+    , m_field ( source.m_field )
+    , m_fetched ( source.m_fetched )
+{
+    if ( m_snapshot )
+        m_snapshot->count.increment ( );
+}
+
+message::const_iterator & message::const_iterator::operator= ( const const_iterator & source )
+{
+    if ( source.m_snapshot )
+        source.m_snapshot->count.increment ( );
+    release ( );
+    m_message = source.m_message;
+    m_index = source.m_index;
+    m_snapshot = source.m_snapshot;
+    m_field = source.m_field;
+    m_fetched = source.m_fetched;
+    return *this;
+}
+
+message::const_iterator::~const_iterator ( )
+{
+    release ( );
+}
+
+void message::const_iterator::fetch ( ) const
+{
+    if ( ! m_fetched )
+    {
+        if ( m_snapshot && m_index < m_snapshot->fields.size ( ) )
+            m_field = field ( m_snapshot->fields [ m_index ] );
+        else
+        {
+            FudgeField raw;
+            exception::throwOnError ( FudgeMsg_getFieldAtIndex ( &raw, m_message, m_index ) );
+            m_field = field ( raw );
+        }
+        m_fetched = true;
+    }
+}
+
+void message::const_iterator::release ( )
+{
+    if ( m_snapshot && ! m_snapshot->count.decrement ( ) )
+        delete m_snapshot;
+    m_snapshot = 0;
+}
+
+fudge_i32 message::encodedSize ( ) const
+{
+    encoder::fieldstack stack;
+    const fudge_i32 encodedsize ( encoder::messageSize ( m_message, stack ) );
+    return encodedsize < 0 ? fudgeCEncodedSize ( m_message ) : encodedsize;
 }
 
 void message::addField ( const optional<string> & name, const optional<fudge_i16> ordinal )
@@ -332,10 +550,89 @@ void message::addFieldData ( fudge_type_id type,
     exception::throwOnError ( FudgeMsg_addFieldData ( m_message, type, convertNameArg ( name ), convertOrdinalArg ( ordinal ), data, numbytes ) );
 }
 
+void message::addFieldBuffer ( fudge_type_id type,
+                               field_buffer & buffer,
+                               const optional<string> name,
+                               const optional<fudge_i16> ordinal )
+{
+    exception::throwOnError ( checkBufferField ( type, buffer.size ( ) ) );
+
+    FudgeFieldData data;
+    data.bytes = buffer.data ( );
+    exception::throwOnError ( FudgeMsg_addFieldData ( m_message,
+                                                      type,
+                                                      convertNameArg ( name ),
+                                                      convertOrdinalArg ( ordinal ),
+                                                      &data,
+                                                      static_cast<fudge_i32> ( buffer.size ( ) ) ) );
+
+    // The message now owns the storage
+    buffer.release ( );
+}
+
 FudgeMsg message::raw ( ) const
 {
     return m_message;
 }
 
+size_t message::localFields ( FudgeField * target ) const
+{
+    const size_t count ( size ( ) );
+    if ( count && count <= LocalFields )
+    {
+        const fudge_i32 retrieved ( FudgeMsg_getFields ( target, count, m_message ) );
+        return retrieved > 0 ? retrieved : 0;
+    }
+    return count;
+}
+
+void message::allFields ( std::vector<FudgeField> & target ) const
+{
+    target.resize ( size ( ) );
+    if ( ! target.empty ( ) )
+    {
+        const fudge_i32 retrieved ( FudgeMsg_getFields ( &( target [ 0 ] ), target.size ( ), m_message ) );
+        target.resize ( retrieved > 0 ? retrieved : 0 );
+    }
+}
+
+FudgeStatus message::findField ( FudgeField & target, const string & name ) const
+{
+    return FudgeMsg_getFieldByName ( &target, m_message, name.raw ( ) );
+}
+
+FudgeStatus message::findField ( FudgeField & target, fudge_i16 ordinal ) const
+{
+    return FudgeMsg_getFieldByOrdinal ( &target, m_message, ordinal );
+}
+
+FudgeStatus message::findField ( FudgeField & target, const field_key & key ) const
+{
+    if ( key.ordinal ( ) )
+        return findField ( target, key.ordinal ( ).get ( ) );
+
+    const size_t count ( size ( ) );
+    if ( count > KeyScanLimit )
+        return FudgeMsg_getFieldByName ( &target, m_message, key.rawName ( ) );
+
+    // Small messages are scanned here, where fields sharing the key's
+    // interned name match on the pointer alone
+    FudgeField fields [ KeyScanLimit ];
+    const fudge_i32 retrieved ( FudgeMsg_getFields ( fields, count, m_message ) );
+    if ( retrieved < 0 )
+        return FUDGE_INTERNAL_LIBRARY_ERROR;
+
+    const FudgeString name ( key.rawName ( ) );
+    for ( fudge_i32 position ( 0 ); position < retrieved; ++position )
+    {
+        if ( fields [ position ].flags & FUDGE_FIELD_HAS_NAME && namesMatch ( fields [ position ].name, name ) )
+        {
+            target = fields [ position ];
+            return FUDGE_OK;
+        }
+    }
+    return FUDGE_INVALID_NAME;
+}
+
 }
 
@@ -0,0 +1,359 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/messagebuilder.hpp"
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "encoder.hpp"
+#include "wire.hpp"
+#include "fudge/codec.h"
+#include "fudge/envelope.h"
+#include <string.h>
+#include <stdlib.h>
+
+namespace
+{
+    using namespace fudge::wire;
+
+    template<class Type> inline void writeArray ( fudge_byte * target,
+                                                  const std::vector<Type> & value,
+                                                  fudge_byte * ( *function ) ( fudge_byte *, Type ) )
+    {
+        for ( typename std::vector<Type>::const_iterator it ( value.begin ( ) ); it != value.end ( ); ++it )
+            target = function ( target, *it );
+    }
+
+    template<class Type> inline fudge_i32 arraySize ( const std::vector<Type> & value )
+    {
+        const size_t numbytes ( value.size ( ) * sizeof ( Type ) );
+        if ( numbytes > 0x7fffffff )
+            throw fudge::exception ( FUDGE_OUT_OF_MEMORY );
+        return static_cast<fudge_i32> ( numbytes );
+    }
+
+    // Messages containing user types can only be encoded by Fudge-C;
+    // returns the buffer it allocates for the whole envelope
+    fudge_byte * fudgeCEncode ( FudgeMsg message, fudge_i32 & numbytes )
+    {
+        FudgeMsgEnvelope envelope;
+        fudge::exception::throwOnError ( FudgeMsgEnvelope_create ( &envelope, 0, 0, 0, message ) );
+
+        fudge_byte * bytes;
+        const FudgeStatus status ( FudgeCodec_encodeMsg ( envelope, &bytes, &numbytes ) );
+        FudgeMsgEnvelope_release ( envelope );
+        fudge::exception::throwOnError ( status );
+        return bytes;
+    }
+}
+
+namespace fudge {
+
+const size_t message_builder::EstimatedFieldSize;
+
+message_builder::message_builder ( )
+    : m_bytes ( wire::EnvelopeHeaderSize )
+    , m_numfields ( 0 )
+{
+}
+
+message_builder::message_builder ( size_t numfields )
+    : m_bytes ( wire::EnvelopeHeaderSize )
+    , m_numfields ( 0 )
+{
+    reserve ( numfields );
+}
+
+void message_builder::reset ( )
+{
+    m_bytes.resize ( wire::EnvelopeHeaderSize );
+    m_numfields = 0;
+}
+
+void message_builder::reserve ( size_t numfields, size_t numbytes )
+{
+    m_bytes.reserve ( wire::EnvelopeHeaderSize + ( numbytes ? numbytes : numfields * EstimatedFieldSize ) );
+}
+
+fudge_i32 message_builder::encodedSize ( ) const
+{
+    return static_cast<fudge_i32> ( m_bytes.size ( ) ) - wire::EnvelopeHeaderSize;
+}
+
+size_t message_builder::capacity ( ) const
+{
+    return m_bytes.capacity ( ) - wire::EnvelopeHeaderSize;
+}
+
+void message_builder::addField ( const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    appendField ( FUDGE_TYPE_INDICATOR, 0, name, ordinal );
+}
+
+void message_builder::addField ( bool value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeByte ( appendField ( FUDGE_TYPE_BOOLEAN, 1, name, ordinal ), value ? 1 : 0 );
+}
+
+void message_builder::addField ( fudge_byte value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeByte ( appendField ( FUDGE_TYPE_BYTE, 1, name, ordinal ), static_cast<unsigned char> ( value ) );
+}
+
+void message_builder::addField ( fudge_i16 value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    appendInteger ( value, name, ordinal );
+}
+
+void message_builder::addField ( fudge_i32 value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    appendInteger ( value, name, ordinal );
+}
+
+void message_builder::addField ( fudge_i64 value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    appendInteger ( value, name, ordinal );
+}
+
+void message_builder::addField ( fudge_f32 value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeF32 ( appendField ( FUDGE_TYPE_FLOAT, 4, name, ordinal ), value );
+}
+
+void message_builder::addField ( fudge_f64 value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeF64 ( appendField ( FUDGE_TYPE_DOUBLE, 8, name, ordinal ), value );
+}
+
+void message_builder::addField ( const message & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    encoder::fieldstack stack;
+    encoder::sizecache cache;
+    const fudge_i32 numbytes ( encoder::messageSize ( value.raw ( ), stack, &cache ) );
+    if ( numbytes >= 0 )
+    {
+        encoder::writeMessage ( appendField ( FUDGE_TYPE_FUDGE_MSG, numbytes, name, ordinal ), value.raw ( ), stack, cache );
+        return;
+    }
+
+    fudge_i32 encodedsize;
+    fudge_byte * encoded ( fudgeCEncode ( value.raw ( ), encodedsize ) );
+    try
+    {
+        const fudge_i32 fieldsize ( encodedsize - wire::EnvelopeHeaderSize );
+        memcpy ( appendField ( FUDGE_TYPE_FUDGE_MSG, fieldsize, name, ordinal ), encoded + wire::EnvelopeHeaderSize, fieldsize );
+    }
+    catch ( ... )
+    {
+        free ( encoded );
+        throw;
+    }
+    free ( encoded );
+}
+
+void message_builder::addField ( const message_builder & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    // A builder added to itself copies the fields it held beforehand, from
+    // wherever the append has left its storage
+    const fudge_i32 numbytes ( value.encodedSize ( ) );
+    const size_t start ( m_bytes.size ( ) );
+    fudge_byte * target ( appendField ( FUDGE_TYPE_FUDGE_MSG, numbytes, name, ordinal ) );
+    const std::vector<fudge_byte> & source ( &value == this ? m_bytes : value.m_bytes );
+    const size_t sourceend ( &value == this ? start : source.size ( ) );
+    if ( numbytes )
+        memcpy ( target, &( source [ wire::EnvelopeHeaderSize ] ), sourceend - wire::EnvelopeHeaderSize );
+}
+
+void message_builder::addField ( const std::vector<fudge_byte> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    const fudge_i32 numbytes ( arraySize ( value ) );
+    fudge_byte * target ( appendField ( FUDGE_TYPE_BYTE_ARRAY, numbytes, name, ordinal ) );
+    if ( numbytes )
+        memcpy ( target, &( value [ 0 ] ), numbytes );
+}
+
+void message_builder::addField ( const std::vector<fudge_i16> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    writeArray<fudge_i16> ( appendField ( FUDGE_TYPE_SHORT_ARRAY, arraySize ( value ), name, ordinal ), value, wire::writeI16 );
+}
+
+void message_builder::addField ( const std::vector<fudge_i32> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    writeArray<fudge_i32> ( appendField ( FUDGE_TYPE_INT_ARRAY, arraySize ( value ), name, ordinal ), value, wire::writeI32 );
+}
+
+void message_builder::addField ( const std::vector<fudge_i64> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    writeArray<fudge_i64> ( appendField ( FUDGE_TYPE_LONG_ARRAY, arraySize ( value ), name, ordinal ), value, wire::writeI64 );
+}
+
+void message_builder::addField ( const std::vector<fudge_f32> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    writeArray<fudge_f32> ( appendField ( FUDGE_TYPE_FLOAT_ARRAY, arraySize ( value ), name, ordinal ), value, wire::writeF32 );
+}
+
+void message_builder::addField ( const std::vector<fudge_f64> & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    writeArray<fudge_f64> ( appendField ( FUDGE_TYPE_DOUBLE_ARRAY, arraySize ( value ), name, ordinal ), value, wire::writeF64 );
+}
+
+void message_builder::addField ( const string & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    const size_t numbytes ( value.size ( ) );
+    if ( numbytes > 0x7fffffff )
+        throw exception ( FUDGE_OUT_OF_MEMORY );
+    fudge_byte * target ( appendField ( FUDGE_TYPE_STRING, static_cast<fudge_i32> ( numbytes ), name, ordinal ) );
+    if ( numbytes )
+        memcpy ( target, value.data ( ), numbytes );
+}
+
+void message_builder::addField ( const date & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeDate ( appendField ( FUDGE_TYPE_DATE, 4, name, ordinal ), value.raw ( ).date );
+}
+
+void message_builder::addField ( const time & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    wire::writeTime ( appendField ( FUDGE_TYPE_TIME, 8, name, ordinal ), value.raw ( ).time );
+}
+
+void message_builder::addField ( const datetime & value, const optional<string> & name, const optional<fudge_i16> ordinal )
+{
+    fudge_byte * target ( appendField ( FUDGE_TYPE_DATETIME, 12, name, ordinal ) );
+    wire::writeTime ( wire::writeDate ( target, value.raw ( ).date ), value.raw ( ).time );
+}
+
+void message_builder::addField ( fudge_type_id type,
+                                 const fudge_byte * bytes,
+                                 fudge_i32 numbytes,
+                                 const optional<string> name,
+                                 const optional<fudge_i16> ordinal )
+{
+    if ( wire::arrayElementWidth ( type ) != 1 )
+        throw exception ( FUDGE_INVALID_TYPE_COERCION );
+    const fudge_i32 width ( wire::fixedWidth ( type ) );
+    if ( numbytes < 0 || ( width >= 0 && numbytes != width ) )
+        throw exception ( FUDGE_UNKNOWN_FIELD_WIDTH );
+    if ( ! bytes && numbytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    fudge_byte * target ( appendField ( type, numbytes, name, ordinal ) );
+    if ( numbytes )
+        memcpy ( target, bytes, numbytes );
+}
+
+message_view message_builder::view ( ) const
+{
+    return message_view ( &( m_bytes [ wire::EnvelopeHeaderSize ] ), encodedSize ( ) );
+}
+
+fudge_i32 message_builder::encode ( std::vector<fudge_byte> & buffer,
+                                    fudge_byte directives,
+                                    fudge_byte schemaversion,
+                                    fudge_i16 taxonomy ) const
+{
+    const size_t offset ( buffer.size ( ) );
+    buffer.insert ( buffer.end ( ), m_bytes.begin ( ), m_bytes.end ( ) );
+    writeEnvelopeHeader ( &( buffer [ offset ] ), directives, schemaversion, taxonomy );
+    return static_cast<fudge_i32> ( m_bytes.size ( ) );
+}
+
+bool message_builder::encode ( fudge_byte * bytes,
+                               fudge_i32 capacity,
+                               fudge_i32 & numbytes,
+                               fudge_byte directives,
+                               fudge_byte schemaversion,
+                               fudge_i16 taxonomy ) const
+{
+    numbytes = static_cast<fudge_i32> ( m_bytes.size ( ) );
+    if ( numbytes > capacity )
+        return false;
+    if ( ! bytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    memcpy ( bytes, &( m_bytes [ 0 ] ), numbytes );
+    writeEnvelopeHeader ( bytes, directives, schemaversion, taxonomy );
+    return true;
+}
+
+message message_builder::build ( ) const
+{
+    std::vector<fudge_byte> encoded;
+    encode ( encoded );
+    return codec ( ).decode ( &( encoded [ 0 ] ), static_cast<fudge_i32> ( encoded.size ( ) ) ).payload ( );
+}
+
+fudge_byte * message_builder::appendField ( fudge_type_id type,
+                                            fudge_i32 numbytes,
+                                            const optional<string> & name,
+                                            const optional<fudge_i16> & ordinal )
+{
+    const size_t namelength ( name ? name.get ( ).size ( ) : 0 );
+    if ( namelength > wire::MaxNameLength )
+        throw exception ( FUDGE_NAME_TOO_LONG );
+
+    const bool fixed ( wire::fixedWidth ( type ) >= 0 );
+    size_t headersize ( 2 + ( fixed ? 0 : wire::lengthWidth ( numbytes ) ) );
+    if ( ordinal )
+        headersize += 2;
+    if ( name )
+        headersize += 1 + namelength;
+
+    const size_t start ( m_bytes.size ( ) );
+    if ( start - wire::EnvelopeHeaderSize + headersize + numbytes > 0x7ffffff7 )
+        throw exception ( FUDGE_OUT_OF_MEMORY );
+    m_bytes.resize ( start + headersize + numbytes );
+
+    unsigned char prefix ( fixed ? wire::FixedWidthPrefix : wire::lengthPrefix ( numbytes ) );
+    if ( ordinal )
+        prefix |= wire::OrdinalPrefix;
+    if ( name )
+        prefix |= wire::NamePrefix;
+
+    fudge_byte * target ( &( m_bytes [ start ] ) );
+    target = wire::writeByte ( target, prefix );
+    target = wire::writeByte ( target, type );
+    if ( ordinal )
+        target = wire::writeI16 ( target, *ordinal );
+    if ( name )
+    {
+        target = wire::writeByte ( target, static_cast<unsigned char> ( namelength ) );
+        target = wire::writeBytes ( target, name.get ( ).data ( ), namelength );
+    }
+    ++m_numfields;
+    return fixed ? target : wire::writeLength ( target, numbytes );
+}
+
+void message_builder::appendInteger ( fudge_i64 value, const optional<string> & name, const optional<fudge_i16> & ordinal )
+{
+    if ( value >= -128 && value <= 127 )
+        wire::writeByte ( appendField ( FUDGE_TYPE_BYTE, 1, name, ordinal ), static_cast<unsigned char> ( value ) );
+    else if ( value >= -32768 && value <= 32767 )
+        wire::writeI16 ( appendField ( FUDGE_TYPE_SHORT, 2, name, ordinal ), static_cast<fudge_i16> ( value ) );
+    else if ( value >= -static_cast<fudge_i64> ( 2147483647 ) - 1 && value <= 2147483647 )
+        wire::writeI32 ( appendField ( FUDGE_TYPE_INT, 4, name, ordinal ), static_cast<fudge_i32> ( value ) );
+    else
+        wire::writeI64 ( appendField ( FUDGE_TYPE_LONG, 8, name, ordinal ), value );
+}
+
+void message_builder::writeEnvelopeHeader ( fudge_byte * target, fudge_byte directives, fudge_byte schemaversion, fudge_i16 taxonomy ) const
+{
+    target = wire::writeByte ( target, static_cast<unsigned char> ( directives ) );
+    target = wire::writeByte ( target, static_cast<unsigned char> ( schemaversion ) );
+    target = wire::writeI16 ( target, taxonomy );
+    wire::writeI32 ( target, static_cast<fudge_i32> ( m_bytes.size ( ) ) );
+}
+
+}
+
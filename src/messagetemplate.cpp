@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/messagetemplate.hpp"
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "wire.hpp"
+
+namespace
+{
+    using namespace fudge::wire;
+
+    // The width of the value of each type of slot
+    fudge_i32 slotWidth ( fudge_type_id type )
+    {
+        switch ( type )
+        {
+            case FUDGE_TYPE_INT:
+            case FUDGE_TYPE_LONG:
+            case FUDGE_TYPE_DOUBLE:
+            case FUDGE_TYPE_DATETIME:
+                return fixedWidth ( type );
+            default:
+                throw fudge::exception ( FUDGE_INVALID_TYPE_COERCION );
+        }
+    }
+
+    bool matches ( const fudge::field_view & field, const fudge::field_key & key )
+    {
+        if ( key.ordinal ( ) )
+        {
+            const fudge::optional<fudge_i16> ordinal ( field.ordinal ( ) );
+            return ordinal && *ordinal == *key.ordinal ( );
+        }
+        const fudge::string & name ( *key.name ( ) );
+        return field.hasName ( ) && field.nameBytes ( ) == fudge::slice ( name.data ( ), name.size ( ) );
+    }
+
+    // Writes the field's value coerced to the slot type
+    void writeValue ( fudge_byte * target, const fudge::field_view & source, fudge_type_id type )
+    {
+        switch ( type )
+        {
+            case FUDGE_TYPE_INT:
+            {
+                const fudge_i64 value ( source.getAsInt64 ( ) );
+                if ( value != static_cast<fudge_i32> ( value ) )
+                    throw fudge::exception ( FUDGE_INVALID_TYPE_COERCION );
+                writeI32 ( target, static_cast<fudge_i32> ( value ) );
+                break;
+            }
+            case FUDGE_TYPE_LONG:
+                writeI64 ( target, source.getAsInt64 ( ) );
+                break;
+            case FUDGE_TYPE_DOUBLE:
+                writeF64 ( target, source.getAsFloat64 ( ) );
+                break;
+            default:
+            {
+                const fudge::datetime value ( source.getDateTime ( ) );
+                writeTime ( writeDate ( target, value.raw ( ).date ), value.raw ( ).time );
+                break;
+            }
+        }
+    }
+}
+
+namespace fudge {
+
+message_template::message_template ( )
+{
+}
+
+message_template::message_template ( const message & prototype,
+                                      fudge_byte directives,
+                                      fudge_byte schemaversion,
+                                      fudge_i16 taxonomy )
+{
+    codec ( ).encode ( envelope ( directives, schemaversion, taxonomy, prototype ), m_bytes );
+}
+
+size_t message_template::addSlot ( const field_key & key, fudge_type_id type )
+{
+    const fudge_i32 width ( slotWidth ( type ) );
+    const FudgeStatus missing ( key.ordinal ( ) ? FUDGE_INVALID_ORDINAL : FUDGE_INVALID_NAME );
+    if ( m_bytes.empty ( ) )
+        throw exception ( missing );
+
+    // Find the field, and the start of its header: fields follow each other
+    // without gaps, so each starts where the last one's value ended
+    const message_view view ( bytes ( ) + EnvelopeHeaderSize, numbytes ( ) - EnvelopeHeaderSize );
+    std::vector<field_view> fields;
+    view.getFields ( fields );
+
+    const fudge_byte * start ( view.bytes ( ) );
+    std::vector<field_view>::const_iterator it ( fields.begin ( ) );
+    for ( ; it != fields.end ( ) && ! matches ( *it, key ); ++it )
+        start = it->bytes ( ) + it->numbytes ( );
+    if ( it == fields.end ( ) )
+        throw exception ( missing );
+
+    const size_t fieldoffset ( start - bytes ( ) );
+    const size_t headersize ( it->bytes ( ) - start );
+    const size_t valueoffset ( fieldoffset + headersize );
+    for ( size_t index ( 0 ); index < m_slots.size ( ); ++index )
+    {
+        if ( m_slots [ index ].offset == valueoffset )
+        {
+            if ( m_slots [ index ].type != type )
+                throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+            return index;
+        }
+    }
+
+    // Re-encode the field at the slot type's full width. Only fixed width
+    // fields are accepted, so there's no length in the header to change.
+    if ( fixedWidth ( it->type ( ) ) < 0 )
+        throw exception ( FUDGE_INVALID_TYPE_COERCION );
+    std::vector<fudge_byte> replacement ( start, it->bytes ( ) );
+    replacement [ 1 ] = static_cast<fudge_byte> ( type );
+    replacement.resize ( headersize + width );
+    writeValue ( &( replacement [ headersize ] ), *it, type );
+
+    const fudge_i32 growth ( width - it->numbytes ( ) );
+    const std::vector<fudge_byte>::iterator position ( m_bytes.begin ( ) + fieldoffset );
+    m_bytes.erase ( position, position + headersize + it->numbytes ( ) );
+    m_bytes.insert ( m_bytes.begin ( ) + fieldoffset, replacement.begin ( ), replacement.end ( ) );
+    writeI32 ( &( m_bytes [ EnvelopeSizeOffset ] ), numbytes ( ) );
+
+    for ( std::vector<slot>::iterator existing ( m_slots.begin ( ) ); existing != m_slots.end ( ); ++existing )
+        if ( existing->offset > valueoffset )
+            existing->offset += growth;
+
+    const slot added = { valueoffset, type };
+    m_slots.push_back ( added );
+    return m_slots.size ( ) - 1;
+}
+
+void message_template::set ( size_t slot, fudge_i32 value )
+{
+    writeI32 ( slotValue ( slot, FUDGE_TYPE_INT ), value );
+}
+
+void message_template::set ( size_t slot, fudge_i64 value )
+{
+    writeI64 ( slotValue ( slot, FUDGE_TYPE_LONG ), value );
+}
+
+void message_template::set ( size_t slot, fudge_f64 value )
+{
+    writeF64 ( slotValue ( slot, FUDGE_TYPE_DOUBLE ), value );
+}
+
+void message_template::set ( size_t slot, const datetime & value )
+{
+    writeTime ( writeDate ( slotValue ( slot, FUDGE_TYPE_DATETIME ), value.raw ( ).date ), value.raw ( ).time );
+}
+
+fudge_type_id message_template::slotType ( size_t slot ) const
+{
+    if ( slot >= m_slots.size ( ) )
+        throw exception ( FUDGE_INVALID_INDEX );
+    return m_slots [ slot ].type;
+}
+
+fudge_byte * message_template::slotValue ( size_t slot, fudge_type_id type )
+{
+    if ( slotType ( slot ) != type )
+        throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    return &( m_bytes [ m_slots [ slot ].offset ] );
+}
+
+}
+
@@ -0,0 +1,451 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/messageview.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "wire.hpp"
+#include "fudge/message_ex.h"
+#include <string.h>
+
+namespace
+{
+    using namespace fudge::wire;
+
+    inline void checkType ( fudge_type_id desired, fudge_type_id type )
+    {
+        if ( desired != type )
+            throw fudge::exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    }
+
+    template<class Type> inline Type getAsImpl ( const FudgeField & field,
+                                                 FudgeStatus ( *function ) ( const FudgeField *, Type * ) )
+    {
+        Type value;
+        fudge::exception::throwOnError ( function ( &field, &value ) );
+        return value;
+    }
+
+    // Copies an array's elements in to storage in host order, as Fudge-C
+    // expects of the arrays it coerces, and returns the copy
+    template<class Type> const fudge_byte * hostOrder ( const fudge_byte * bytes,
+                                                        fudge_i32 numbytes,
+                                                        std::vector<fudge_byte> & storage,
+                                                        Type ( *function ) ( const fudge_byte * ) )
+    {
+        if ( ! numbytes )
+            return bytes;
+
+        storage.assign ( bytes, bytes + numbytes );
+        for ( fudge_i32 offset ( 0 ); offset + static_cast<fudge_i32> ( sizeof ( Type ) ) <= numbytes; offset += sizeof ( Type ) )
+        {
+            const Type value ( function ( bytes + offset ) );
+            memcpy ( &( storage [ offset ] ), &value, sizeof ( Type ) );
+        }
+        return &( storage [ 0 ] );
+    }
+
+    template<class Type> inline size_t getArrayImpl ( fudge_type_id type,
+                                                      const fudge::field_view & field,
+                                                      std::vector<Type> & target,
+                                                      Type ( *function ) ( const fudge_byte * ) )
+    {
+        checkType ( type, field.type ( ) );
+
+        const size_t numelements ( field.numbytes ( ) / sizeof ( Type ) );
+        target.resize ( numelements );
+        for ( size_t index ( 0 ); index < numelements; ++index )
+            target [ index ] = function ( field.bytes ( ) + index * sizeof ( Type ) );
+        return target.size ( );
+    }
+
+    inline fudge_byte readByte ( const fudge_byte * source )
+    {
+        return *source;
+    }
+}
+
+namespace fudge {
+
+field_view::field_view ( )
+    : m_type ( FUDGE_TYPE_INDICATOR )
+    , m_hasordinal ( false )
+    , m_ordinal ( 0 )
+    , m_hasname ( false )
+    , m_name ( 0 )
+    , m_namelength ( 0 )
+    , m_data ( 0 )
+    , m_numbytes ( 0 )
+{
+}
+
+optional<string> field_view::name ( ) const
+{
+    if ( m_hasname )
+        return string ( m_name, m_namelength, string::UTF8 );
+    return optional<string> ( );
+}
+
+optional<fudge_i16> field_view::ordinal ( ) const
+{
+    if ( m_hasordinal )
+        return m_ordinal;
+    return optional<fudge_i16> ( );
+}
+
+bool field_view::getBoolean ( ) const
+{
+    checkType ( FUDGE_TYPE_BOOLEAN, m_type );
+    return *m_data != 0;
+}
+
+fudge_byte field_view::getByte ( ) const
+{
+    checkType ( FUDGE_TYPE_BYTE, m_type );
+    return *m_data;
+}
+
+fudge_i16 field_view::getInt16 ( ) const
+{
+    checkType ( FUDGE_TYPE_SHORT, m_type );
+    return readI16 ( m_data );
+}
+
+fudge_i32 field_view::getInt32 ( ) const
+{
+    checkType ( FUDGE_TYPE_INT, m_type );
+    return readI32 ( m_data );
+}
+
+fudge_i64 field_view::getInt64 ( ) const
+{
+    checkType ( FUDGE_TYPE_LONG, m_type );
+    return readI64 ( m_data );
+}
+
+fudge_f32 field_view::getFloat32 ( ) const
+{
+    checkType ( FUDGE_TYPE_FLOAT, m_type );
+    return readF32 ( m_data );
+}
+
+fudge_f64 field_view::getFloat64 ( ) const
+{
+    checkType ( FUDGE_TYPE_DOUBLE, m_type );
+    return readF64 ( m_data );
+}
+
+string field_view::getString ( ) const
+{
+    checkType ( FUDGE_TYPE_STRING, m_type );
+    return string ( m_data, m_numbytes, string::UTF8 );
+}
+
+slice field_view::getStringBytes ( ) const
+{
+    checkType ( FUDGE_TYPE_STRING, m_type );
+    return slice ( m_data, m_numbytes );
+}
+
+message_view field_view::getMessage ( ) const
+{
+    checkType ( FUDGE_TYPE_FUDGE_MSG, m_type );
+    return message_view ( m_data, m_numbytes );
+}
+
+date field_view::getDate ( ) const
+{
+    checkType ( FUDGE_TYPE_DATE, m_type );
+    return readDate ( m_data );
+}
+
+time field_view::getTime ( ) const
+{
+    checkType ( FUDGE_TYPE_TIME, m_type );
+    return readTime ( m_data );
+}
+
+datetime field_view::getDateTime ( ) const
+{
+    checkType ( FUDGE_TYPE_DATETIME, m_type );
+
+    FudgeDateTime datetime;
+    datetime.date = readDate ( m_data );
+    datetime.time = readTime ( m_data + 4 );
+    return datetime;
+}
+
+size_t field_view::getArray ( std::vector<fudge_byte> & target ) const
+{
+    return getArrayImpl<fudge_byte> ( FUDGE_TYPE_BYTE_ARRAY, *this, target, readByte );
+}
+
+size_t field_view::getArray ( std::vector<fudge_i16> & target ) const
+{
+    return getArrayImpl<fudge_i16> ( FUDGE_TYPE_SHORT_ARRAY, *this, target, readI16 );
+}
+
+size_t field_view::getArray ( std::vector<fudge_i32> & target ) const
+{
+    return getArrayImpl<fudge_i32> ( FUDGE_TYPE_INT_ARRAY, *this, target, readI32 );
+}
+
+size_t field_view::getArray ( std::vector<fudge_i64> & target ) const
+{
+    return getArrayImpl<fudge_i64> ( FUDGE_TYPE_LONG_ARRAY, *this, target, readI64 );
+}
+
+size_t field_view::getArray ( std::vector<fudge_f32> & target ) const
+{
+    return getArrayImpl<fudge_f32> ( FUDGE_TYPE_FLOAT_ARRAY, *this, target, readF32 );
+}
+
+size_t field_view::getArray ( std::vector<fudge_f64> & target ) const
+{
+    return getArrayImpl<fudge_f64> ( FUDGE_TYPE_DOUBLE_ARRAY, *this, target, readF64 );
+}
+
+size_t field_view::numelements ( ) const
+{
+    const size_t width ( arrayElementWidth ( m_type ) );
+    if ( ! width )
+        throw exception ( FUDGE_INVALID_TYPE_ACCESSOR );
+    return m_numbytes / width;
+}
+
+bool field_view::getAsBoolean ( ) const
+{
+    fudge_bool value;
+    std::vector<fudge_byte> storage;
+    const FudgeField field ( raw ( storage ) );
+    exception::throwOnError ( FudgeMsg_getFieldAsBoolean ( &field, &value ) );
+    return value == FUDGE_TRUE;
+}
+
+fudge_byte field_view::getAsByte ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_byte> ( raw ( storage ), &FudgeMsg_getFieldAsByte );
+}
+
+fudge_i16 field_view::getAsInt16 ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_i16> ( raw ( storage ), &FudgeMsg_getFieldAsI16 );
+}
+
+fudge_i32 field_view::getAsInt32 ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_i32> ( raw ( storage ), &FudgeMsg_getFieldAsI32 );
+}
+
+fudge_i64 field_view::getAsInt64 ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_i64> ( raw ( storage ), &FudgeMsg_getFieldAsI64 );
+}
+
+fudge_f32 field_view::getAsFloat32 ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_f32> ( raw ( storage ), &FudgeMsg_getFieldAsF32 );
+}
+
+fudge_f64 field_view::getAsFloat64 ( ) const
+{
+    std::vector<fudge_byte> storage;
+    return getAsImpl<fudge_f64> ( raw ( storage ), &FudgeMsg_getFieldAsF64 );
+}
+
+string field_view::getAsString ( ) const
+{
+    if ( m_type == FUDGE_TYPE_STRING )
+        return getString ( );
+
+    FudgeFieldData data;
+    FudgeTypePayload payload;
+    fudge_i32 numbytes;
+    std::vector<fudge_byte> storage;
+    const FudgeField field ( raw ( storage ) );
+    exception::throwOnError ( FudgeMsg_getFieldAs ( &field, FUDGE_TYPE_STRING, &data, &payload, &numbytes ) );
+
+    const string copy ( data.string );
+    FudgeString_release ( data.string );
+    return copy;
+}
+
+FudgeField field_view::raw ( std::vector<fudge_byte> & storage ) const
+{
+    FudgeField field;
+    memset ( &field, 0, sizeof ( field ) );
+    field.type = m_type;
+    field.numbytes = m_numbytes;
+
+    switch ( m_type )
+    {
+        case FUDGE_TYPE_INDICATOR:  break;
+        case FUDGE_TYPE_BOOLEAN:    field.data.boolean = *m_data ? FUDGE_TRUE : FUDGE_FALSE; break;
+        case FUDGE_TYPE_BYTE:       field.data.byte = *m_data; break;
+        case FUDGE_TYPE_SHORT:      field.data.i16 = readI16 ( m_data ); break;
+        case FUDGE_TYPE_INT:        field.data.i32 = readI32 ( m_data ); break;
+        case FUDGE_TYPE_LONG:       field.data.i64 = readI64 ( m_data ); break;
+        case FUDGE_TYPE_FLOAT:      field.data.f32 = readF32 ( m_data ); break;
+        case FUDGE_TYPE_DOUBLE:     field.data.f64 = readF64 ( m_data ); break;
+        case FUDGE_TYPE_DATE:       field.data.datetime.date = readDate ( m_data ); break;
+        case FUDGE_TYPE_TIME:       field.data.datetime.time = readTime ( m_data ); break;
+        case FUDGE_TYPE_DATETIME:   field.data.datetime.date = readDate ( m_data );
+                                    field.data.datetime.time = readTime ( m_data + 4 ); break;
+
+        // Messages and strings can't be coerced to anything else
+        case FUDGE_TYPE_STRING:
+        case FUDGE_TYPE_FUDGE_MSG:  throw exception ( FUDGE_INVALID_TYPE_COERCION );
+
+        // Array elements are big-endian on the wire
+        case FUDGE_TYPE_SHORT_ARRAY:  field.data.bytes = hostOrder ( m_data, m_numbytes, storage, readI16 ); break;
+        case FUDGE_TYPE_INT_ARRAY:    field.data.bytes = hostOrder ( m_data, m_numbytes, storage, readI32 ); break;
+        case FUDGE_TYPE_LONG_ARRAY:   field.data.bytes = hostOrder ( m_data, m_numbytes, storage, readI64 ); break;
+        case FUDGE_TYPE_FLOAT_ARRAY:  field.data.bytes = hostOrder ( m_data, m_numbytes, storage, readF32 ); break;
+        case FUDGE_TYPE_DOUBLE_ARRAY: field.data.bytes = hostOrder ( m_data, m_numbytes, storage, readF64 ); break;
+
+        // Byte arrays and user types are opaque bytes, in any order
+        default:                    field.data.bytes = m_data; break;
+    }
+    return field;
+}
+
+message_view::message_view ( )
+    : m_bytes ( 0 )
+    , m_numbytes ( 0 )
+    , m_size ( 0 )
+{
+}
+
+message_view::message_view ( const fudge_byte * bytes, fudge_i32 numbytes )
+    : m_bytes ( bytes )
+    , m_numbytes ( numbytes )
+    , m_size ( -1 )
+{
+    if ( numbytes < 0 )
+        throw exception ( FUDGE_OUT_OF_BYTES );
+    if ( numbytes && ! bytes )
+        throw exception ( FUDGE_NULL_POINTER );
+}
+
+size_t message_view::size ( ) const
+{
+    if ( m_size < 0 )
+    {
+        fudge_i32 count ( 0 );
+        field_view field;
+        for ( fudge_i32 offset ( 0 ); offset < m_numbytes; ++count )
+            offset = parseField ( offset, field );
+        m_size = count;
+    }
+    return m_size;
+}
+
+field_view message_view::getFieldAt ( size_t index ) const
+{
+    field_view field;
+    size_t current ( 0 );
+    for ( fudge_i32 offset ( 0 ); offset < m_numbytes; ++current )
+    {
+        offset = parseField ( offset, field );
+        if ( current == index )
+            return field;
+    }
+    throw exception ( FUDGE_INVALID_INDEX );
+}
+
+field_view message_view::getField ( const string & name ) const
+{
+    field_view field;
+    if ( ! getField ( field, name ) )
+        throw exception ( FUDGE_INVALID_NAME );
+    return field;
+}
+
+field_view message_view::getField ( fudge_i16 ordinal ) const
+{
+    field_view field;
+    if ( ! getField ( field, ordinal ) )
+        throw exception ( FUDGE_INVALID_ORDINAL );
+    return field;
+}
+
+bool message_view::getField ( field_view & target, const string & name ) const
+{
+    if ( ! name.raw ( ) )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    const slice namebytes ( name.data ( ), name.size ( ) );
+    field_view field;
+    for ( fudge_i32 offset ( 0 ); offset < m_numbytes; )
+    {
+        offset = parseField ( offset, field );
+        if ( field.m_hasname && field.nameBytes ( ) == namebytes )
+        {
+            target = field;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool message_view::getField ( field_view & target, fudge_i16 ordinal ) const
+{
+    field_view field;
+    for ( fudge_i32 offset ( 0 ); offset < m_numbytes; )
+    {
+        offset = parseField ( offset, field );
+        if ( field.m_hasordinal && field.m_ordinal == ordinal )
+        {
+            target = field;
+            return true;
+        }
+    }
+    return false;
+}
+
+void message_view::getFields ( std::vector<field_view> & fields ) const
+{
+    fields.clear ( );
+
+    field_view field;
+    for ( fudge_i32 offset ( 0 ); offset < m_numbytes; )
+    {
+        offset = parseField ( offset, field );
+        fields.push_back ( field );
+    }
+}
+
+fudge_i32 message_view::parseField ( fudge_i32 offset, field_view & target ) const
+{
+    fieldheader header;
+    exception::throwOnError ( readFieldHeader ( m_bytes + offset, m_bytes + m_numbytes, header ) );
+
+    target.m_type = header.type;
+    target.m_hasordinal = header.hasordinal;
+    target.m_ordinal = header.ordinal;
+    target.m_hasname = header.hasname;
+    target.m_name = header.name;
+    target.m_namelength = header.namelength;
+    target.m_data = header.data;
+    target.m_numbytes = header.numbytes;
+    return static_cast<fudge_i32> ( ( header.data + header.numbytes ) - m_bytes );
+}
+
+}
+
@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_MUTEX_HPP
+#define INC_FUDGE_CPP_MUTEX_HPP
+
+#include "fudge-cpp/config.h"
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// Locking for the parts of the library shared between threads
+namespace fudge {
+namespace threading {
+
+// A mutex that does nothing when threads aren't available
+class mutex
+{
+    public:
+        mutex ( )
+        {
+#ifdef FUDGE_HAVE_PTHREAD_H
+            pthread_mutex_init ( &m_mutex, 0 );
+#endif
+        }
+
+        ~mutex ( )
+        {
+#ifdef FUDGE_HAVE_PTHREAD_H
+            pthread_mutex_destroy ( &m_mutex );
+#endif
+        }
+
+        inline void lock ( )
+        {
+#ifdef FUDGE_HAVE_PTHREAD_H
+            pthread_mutex_lock ( &m_mutex );
+#endif
+        }
+
+        inline void unlock ( )
+        {
+#ifdef FUDGE_HAVE_PTHREAD_H
+            pthread_mutex_unlock ( &m_mutex );
+#endif
+        }
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+        inline pthread_mutex_t * raw ( )    { return &m_mutex; }
+
+    private:
+        pthread_mutex_t m_mutex;
+#endif
+
+    private:
+        mutex ( const mutex & );
+        mutex & operator= ( const mutex & );
+};
+
+class scopedlock
+{
+    public:
+        explicit scopedlock ( mutex & target )
+            : m_mutex ( target )
+        {
+            m_mutex.lock ( );
+        }
+
+        ~scopedlock ( )
+        {
+            m_mutex.unlock ( );
+        }
+
+    private:
+        mutex & m_mutex;
+
+        scopedlock ( const scopedlock & );
+        scopedlock & operator= ( const scopedlock & );
+};
+
+}
+}
+
+#endif
+
@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/sharedmessage.hpp"
+#include "fudge-cpp/allocator.hpp"
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "atomic.hpp"
+#include "wire.hpp"
+
+namespace fudge {
+
+// The encoded bytes come from the default allocator in use when the message
+// was frozen, which is remembered so that they go back to the same one
+struct shared_message::block
+{
+    explicit block ( const message & source )
+        : count ( 1 )
+        , memory ( fudge::defaultAllocator ( ) )
+        , bytes ( 0 )
+        , numbytes ( 0 )
+        , capacity ( 0 )
+    {
+        const envelope frozen ( 0, 0, 0, source );
+        const codec encoder;
+        capacity = encoder.encodedSize ( frozen );
+        bytes = static_cast<fudge_byte *> ( memory.allocate ( capacity ) );
+        try
+        {
+            if ( ! encoder.encode ( frozen, bytes, capacity, numbytes ) )
+                throw exception ( FUDGE_OUT_OF_BYTES );
+        }
+        catch ( ... )
+        {
+            memory.deallocate ( bytes, capacity );
+            throw;
+        }
+        view = message_view ( bytes + wire::EnvelopeHeaderSize, numbytes - wire::EnvelopeHeaderSize );
+
+        // Count the fields now, so that readers never fill in the cache
+        view.size ( );
+    }
+
+    ~block ( )
+    {
+        memory.deallocate ( bytes, capacity );
+    }
+
+    threading::atomiccount count;
+    allocator & memory;
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+    fudge_i32 capacity;
+    message_view view;
+};
+
+shared_message::shared_message ( )
+    : m_block ( 0 )
+{
+}
+
+shared_message::shared_message ( const message & source )
+    : m_block ( new block ( source ) )
+{
+}
+
+shared_message::shared_message ( const shared_message & source )
+    : m_block ( source.m_block )
+{
+    if ( m_block )
+        m_block->count.increment ( );
+}
+
+shared_message & shared_message::operator= ( const shared_message & source )
+{
+    if ( m_block != source.m_block )
+    {
+        if ( source.m_block )
+            source.m_block->count.increment ( );
+        release ( );
+        m_block = source.m_block;
+    }
+    return *this;
+}
+
+shared_message::~shared_message ( )
+{
+    release ( );
+}
+
+const message_view & shared_message::view ( ) const
+{
+    static const message_view empty;
+    return m_block ? m_block->view : empty;
+}
+
+message shared_message::thaw ( ) const
+{
+    if ( ! m_block )
+        return message ( );
+    return codec ( ).decode ( m_block->bytes, m_block->numbytes ).payload ( );
+}
+
+const fudge_byte * shared_message::bytes ( ) const
+{
+    return m_block ? m_block->bytes : 0;
+}
+
+fudge_i32 shared_message::numbytes ( ) const
+{
+    return m_block ? m_block->numbytes : 0;
+}
+
+long shared_message::useCount ( ) const
+{
+    return m_block ? m_block->count.value ( ) : 0;
+}
+
+void shared_message::release ( )
+{
+    // Whichever thread drops the last reference is the only one left
+    // touching the block
+    if ( m_block && m_block->count.decrement ( ) == 0 )
+        delete m_block;
+    m_block = 0;
+}
+
+}
+
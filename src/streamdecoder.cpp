@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/streamdecoder.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "wire.hpp"
+
+namespace
+{
+    using fudge::wire::EnvelopeHeaderSize;
+}
+
+namespace fudge {
+
+stream_decoder::stream_decoder ( )
+    : m_chunk ( 0 )
+    , m_chunksize ( 0 )
+    , m_chunkoffset ( 0 )
+{
+}
+
+void stream_decoder::push ( const fudge_byte * bytes, size_t numbytes )
+{
+    if ( ! bytes && numbytes )
+        throw exception ( FUDGE_NULL_POINTER );
+
+    storeRemainder ( );
+    m_chunk = bytes;
+    m_chunksize = numbytes;
+    m_chunkoffset = 0;
+}
+
+bool stream_decoder::next ( envelope & target )
+{
+    if ( m_partial.empty ( ) )
+    {
+        // Decode straight out of the caller's chunk if the whole envelope
+        // is present; otherwise hold on to what there is
+        const size_t available ( m_chunksize - m_chunkoffset );
+        const fudge_byte * start ( m_chunk + m_chunkoffset );
+        if ( available >= EnvelopeHeaderSize )
+        {
+            const size_t size ( m_codec.peekHeader ( start, EnvelopeHeaderSize ).size ( ) );
+            if ( size <= available )
+            {
+                target = m_codec.decode ( start, static_cast<fudge_i32> ( size ) );
+                m_chunkoffset += size;
+                return true;
+            }
+        }
+
+        storeRemainder ( );
+        return false;
+    }
+
+    // Bytes are already held: complete the header, then the envelope body,
+    // from the current chunk
+    fillPartial ( EnvelopeHeaderSize );
+    if ( m_partial.size ( ) < EnvelopeHeaderSize )
+        return false;
+
+    const size_t size ( m_codec.peekHeader ( &m_partial [ 0 ], EnvelopeHeaderSize ).size ( ) );
+    fillPartial ( size );
+    if ( m_partial.size ( ) < size )
+        return false;
+
+    // The held bytes may run past this envelope if a chunk was replaced
+    // before it had been drained
+    target = m_codec.decode ( &m_partial [ 0 ], static_cast<fudge_i32> ( size ) );
+    m_partial.erase ( m_partial.begin ( ), m_partial.begin ( ) + size );
+    return true;
+}
+
+size_t stream_decoder::pending ( ) const
+{
+    return m_partial.size ( ) + ( m_chunksize - m_chunkoffset );
+}
+
+void stream_decoder::reset ( )
+{
+    m_partial.clear ( );
+    m_chunk = 0;
+    m_chunksize = 0;
+    m_chunkoffset = 0;
+}
+
+void stream_decoder::fillPartial ( size_t target )
+{
+    if ( m_partial.size ( ) >= target )
+        return;
+
+    const size_t required ( target - m_partial.size ( ) ),
+                 available ( m_chunksize - m_chunkoffset ),
+                 numbytes ( required < available ? required : available );
+    // The buffer grows only as bytes arrive: the size comes from a header
+    // that hasn't been validated, so it can't be trusted to reserve space
+    if ( numbytes )
+    {
+        m_partial.insert ( m_partial.end ( ), m_chunk + m_chunkoffset, m_chunk + m_chunkoffset + numbytes );
+        m_chunkoffset += numbytes;
+    }
+}
+
+void stream_decoder::storeRemainder ( )
+{
+    if ( m_chunkoffset < m_chunksize )
+    {
+        m_partial.insert ( m_partial.end ( ), m_chunk + m_chunkoffset, m_chunk + m_chunksize );
+        m_chunkoffset = m_chunksize;
+    }
+}
+
+}
+
@@ -124,10 +124,7 @@ const fudge_byte * string::data ( ) const
 
 void string::convertToASCIIZ ( char * & string ) const
 {
-    if ( m_string )
-        exception::throwOnError ( FudgeString_convertToASCIIZ ( &string, m_string ) );
-    else
-        string = 0;
+    exception::throwOnError ( tryConvertToASCIIZ ( string ) );
 }
 
 std::string string::convertToStdString ( ) const
@@ -145,24 +142,62 @@ std::string string::convertToStdString ( ) const
 
 void string::convertToUTF16 ( fudge_byte * & bytes, size_t & numbytes ) const
 {
-    if ( m_string )
-        exception::throwOnError ( FudgeString_convertToUTF16 ( &bytes, &numbytes, m_string ) );
-    else
+    exception::throwOnError ( tryConvertToUTF16 ( bytes, numbytes ) );
+}
+
+void string::convertToUTF32 ( fudge_byte * & bytes, size_t & numbytes ) const
+{
+    exception::throwOnError ( tryConvertToUTF32 ( bytes, numbytes ) );
+}
+
+FudgeStatus string::tryCreate ( string & target, const fudge_byte * bytes, size_t numbytes, UnicodeType type )
+{
+    FudgeStringUTFConstructor constructor ( getConstructorForType ( type ) );
+    if ( ! constructor )
+        return FUDGE_STRING_UNKNOWN_UNICODE_TYPE;
+
+    FudgeString created;
+    const FudgeStatus status ( constructor ( &created, bytes, numbytes ) );
+    if ( status != FUDGE_OK )
+        return status;
+
+    // Adopt the new string's only reference
+    string adopted ( created );
+    FudgeString_release ( created );
+    target.swap ( adopted );
+    return FUDGE_OK;
+}
+
+FudgeStatus string::tryConvertToASCIIZ ( char * & string ) const
+{
+    if ( ! m_string )
+    {
+        string = 0;
+        return FUDGE_OK;
+    }
+    return FudgeString_convertToASCIIZ ( &string, m_string );
+}
+
+FudgeStatus string::tryConvertToUTF16 ( fudge_byte * & bytes, size_t & numbytes ) const
+{
+    if ( ! m_string )
     {
         bytes = 0;
         numbytes = 0;
+        return FUDGE_OK;
     }
+    return FudgeString_convertToUTF16 ( &bytes, &numbytes, m_string );
 }
 
-void string::convertToUTF32 ( fudge_byte * & bytes, size_t & numbytes ) const
+FudgeStatus string::tryConvertToUTF32 ( fudge_byte * & bytes, size_t & numbytes ) const
 {
-    if ( m_string )
-        exception::throwOnError ( FudgeString_convertToUTF32 ( &bytes, &numbytes, m_string ) );
-    else
+    if ( ! m_string )
     {
         bytes = 0;
         numbytes = 0;
+        return FUDGE_OK;
     }
+    return FudgeString_convertToUTF32 ( &bytes, &numbytes, m_string );
 }
 
 const FudgeString string::raw ( ) const
@@ -0,0 +1,382 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_WIRE_HPP
+#define INC_FUDGE_CPP_WIRE_HPP
+
+#include "fudge/status.h"
+#include "fudge/types.h"
+#include <string.h>
+
+// Helpers for reading and writing the Fudge wire format directly. All
+// multi-byte values are big-endian on the wire. The write functions return
+// the position immediately after the bytes written.
+namespace fudge {
+namespace wire {
+
+// Envelope header: directives (1), schema version (1), taxonomy (2) and the
+// total envelope size (4), which includes the header itself.
+static const fudge_i32 EnvelopeHeaderSize = 8;
+static const fudge_i32 EnvelopeSizeOffset = 4;
+
+// Field prefix flags; bits 5 and 6 hold the width of a variable width field's
+// length (0, 1, 2 or 4 bytes)
+static const unsigned char FixedWidthPrefix = 0x80;
+static const unsigned char OrdinalPrefix    = 0x10;
+static const unsigned char NamePrefix       = 0x08;
+static const int VariableWidthShift         = 5;
+
+// The maximum length of a field name, which is stored with a single byte
+// length on the wire
+static const size_t MaxNameLength = 255;
+
+inline fudge_byte * writeByte ( fudge_byte * target, unsigned char value )
+{
+    *target = static_cast<fudge_byte> ( value );
+    return target + 1;
+}
+
+inline fudge_byte * writeI16 ( fudge_byte * target, fudge_i16 value )
+{
+    const unsigned short bits ( static_cast<unsigned short> ( value ) );
+    target [ 0 ] = static_cast<fudge_byte> ( bits >> 8 );
+    target [ 1 ] = static_cast<fudge_byte> ( bits );
+    return target + 2;
+}
+
+inline fudge_byte * writeI32 ( fudge_byte * target, fudge_i32 value )
+{
+    const unsigned long bits ( static_cast<unsigned long> ( static_cast<uint32_t> ( value ) ) );
+    target [ 0 ] = static_cast<fudge_byte> ( bits >> 24 );
+    target [ 1 ] = static_cast<fudge_byte> ( bits >> 16 );
+    target [ 2 ] = static_cast<fudge_byte> ( bits >> 8 );
+    target [ 3 ] = static_cast<fudge_byte> ( bits );
+    return target + 4;
+}
+
+inline fudge_byte * writeI64 ( fudge_byte * target, fudge_i64 value )
+{
+    target = writeI32 ( target, static_cast<fudge_i32> ( value >> 32 ) );
+    return writeI32 ( target, static_cast<fudge_i32> ( value ) );
+}
+
+inline fudge_byte * writeF32 ( fudge_byte * target, fudge_f32 value )
+{
+    fudge_i32 bits;
+    memcpy ( &bits, &value, sizeof ( bits ) );
+    return writeI32 ( target, bits );
+}
+
+inline fudge_byte * writeF64 ( fudge_byte * target, fudge_f64 value )
+{
+    fudge_i64 bits;
+    memcpy ( &bits, &value, sizeof ( bits ) );
+    return writeI64 ( target, bits );
+}
+
+inline fudge_byte * writeBytes ( fudge_byte * target, const void * source, size_t numbytes )
+{
+    if ( numbytes )
+        memcpy ( target, source, numbytes );
+    return target + numbytes;
+}
+
+// True if the host's own byte order matches the wire's, in which case arrays
+// held in host order are already encoded
+inline bool hostIsBigEndian ( )
+{
+    const uint32_t value ( 1 );
+    unsigned char first;
+    memcpy ( &first, &value, 1 );
+    return first == 0;
+}
+
+inline fudge_i16 readI16 ( const fudge_byte * source )
+{
+    const unsigned char * bytes ( reinterpret_cast<const unsigned char *> ( source ) );
+    return static_cast<fudge_i16> ( ( bytes [ 0 ] << 8 ) | bytes [ 1 ] );
+}
+
+inline fudge_i32 readI32 ( const fudge_byte * source )
+{
+    const unsigned char * bytes ( reinterpret_cast<const unsigned char *> ( source ) );
+    return static_cast<fudge_i32> ( ( static_cast<uint32_t> ( bytes [ 0 ] ) << 24 ) |
+                                    ( static_cast<uint32_t> ( bytes [ 1 ] ) << 16 ) |
+                                    ( static_cast<uint32_t> ( bytes [ 2 ] ) << 8 ) |
+                                      static_cast<uint32_t> ( bytes [ 3 ] ) );
+}
+
+inline fudge_i64 readI64 ( const fudge_byte * source )
+{
+    return static_cast<fudge_i64> ( ( static_cast<uint64_t> ( static_cast<uint32_t> ( readI32 ( source ) ) ) << 32 ) |
+                                      static_cast<uint64_t> ( static_cast<uint32_t> ( readI32 ( source + 4 ) ) ) );
+}
+
+inline fudge_f32 readF32 ( const fudge_byte * source )
+{
+    const fudge_i32 bits ( readI32 ( source ) );
+    fudge_f32 value;
+    memcpy ( &value, &bits, sizeof ( value ) );
+    return value;
+}
+
+inline fudge_f64 readF64 ( const fudge_byte * source )
+{
+    const fudge_i64 bits ( readI64 ( source ) );
+    fudge_f64 value;
+    memcpy ( &value, &bits, sizeof ( value ) );
+    return value;
+}
+
+// Returns the encoded width of a fixed width type, or -1 if the type is
+// variable width (or unknown, in which case it is treated as variable width).
+inline fudge_i32 fixedWidth ( fudge_type_id type )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_INDICATOR:      return 0;
+        case FUDGE_TYPE_BOOLEAN:        return 1;
+        case FUDGE_TYPE_BYTE:           return 1;
+        case FUDGE_TYPE_SHORT:          return 2;
+        case FUDGE_TYPE_INT:            return 4;
+        case FUDGE_TYPE_LONG:           return 8;
+        case FUDGE_TYPE_FLOAT:          return 4;
+        case FUDGE_TYPE_DOUBLE:         return 8;
+        case FUDGE_TYPE_BYTE_ARRAY_4:   return 4;
+        case FUDGE_TYPE_BYTE_ARRAY_8:   return 8;
+        case FUDGE_TYPE_BYTE_ARRAY_16:  return 16;
+        case FUDGE_TYPE_BYTE_ARRAY_20:  return 20;
+        case FUDGE_TYPE_BYTE_ARRAY_32:  return 32;
+        case FUDGE_TYPE_BYTE_ARRAY_64:  return 64;
+        case FUDGE_TYPE_BYTE_ARRAY_128: return 128;
+        case FUDGE_TYPE_BYTE_ARRAY_256: return 256;
+        case FUDGE_TYPE_BYTE_ARRAY_512: return 512;
+        case FUDGE_TYPE_DATE:           return 4;
+        case FUDGE_TYPE_TIME:           return 8;
+        case FUDGE_TYPE_DATETIME:       return 12;
+        default:                        return -1;
+    }
+}
+
+// True for the types defined by the specification (and so understood by the
+// native encoding routines); false for user defined and unknown types.
+inline bool isStandardType ( fudge_type_id type )
+{
+    return type <= FUDGE_TYPE_DATETIME && type != 16;
+}
+
+// The number of bytes used to hold the length of a variable width field
+inline fudge_i32 lengthWidth ( fudge_i32 numbytes )
+{
+    if ( numbytes <= 255 )
+        return 1;
+    if ( numbytes <= 32767 )
+        return 2;
+    return 4;
+}
+
+inline fudge_byte * writeLength ( fudge_byte * target, fudge_i32 numbytes )
+{
+    switch ( lengthWidth ( numbytes ) )
+    {
+        case 1:  return writeByte ( target, static_cast<unsigned char> ( numbytes ) );
+        case 2:  return writeI16 ( target, static_cast<fudge_i16> ( numbytes ) );
+        default: return writeI32 ( target, numbytes );
+    }
+}
+
+inline unsigned char lengthPrefix ( fudge_i32 numbytes )
+{
+    const fudge_i32 width ( lengthWidth ( numbytes ) );
+    return static_cast<unsigned char> ( ( width == 4 ? 3 : width ) << VariableWidthShift );
+}
+
+// The size in bytes of a single element of an array type, or zero if the
+// type is not an array
+inline size_t arrayElementWidth ( fudge_type_id type )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_BYTE_ARRAY:
+        case FUDGE_TYPE_BYTE_ARRAY_4:
+        case FUDGE_TYPE_BYTE_ARRAY_8:
+        case FUDGE_TYPE_BYTE_ARRAY_16:
+        case FUDGE_TYPE_BYTE_ARRAY_20:
+        case FUDGE_TYPE_BYTE_ARRAY_32:
+        case FUDGE_TYPE_BYTE_ARRAY_64:
+        case FUDGE_TYPE_BYTE_ARRAY_128:
+        case FUDGE_TYPE_BYTE_ARRAY_256:
+        case FUDGE_TYPE_BYTE_ARRAY_512:  return 1;
+        case FUDGE_TYPE_SHORT_ARRAY:     return 2;
+        case FUDGE_TYPE_INT_ARRAY:
+        case FUDGE_TYPE_FLOAT_ARRAY:     return 4;
+        case FUDGE_TYPE_LONG_ARRAY:
+        case FUDGE_TYPE_DOUBLE_ARRAY:    return 8;
+        default:                         return 0;
+    }
+}
+
+// A field header as found on the wire, with the name and data left in place
+struct fieldheader
+{
+    unsigned char prefix;
+    fudge_type_id type;
+    bool hasordinal;
+    fudge_i16 ordinal;
+    bool hasname;
+    const fudge_byte * name;
+    size_t namelength;
+    const fudge_byte * data;
+    fudge_i32 numbytes;
+};
+
+// Parses the field starting at position, which must not extend beyond end.
+// On success returns FUDGE_OK and the field ends at header.data +
+// header.numbytes. Allocates nothing and never reads beyond end. A fixed
+// width type whose payload is not exactly its width is rejected with
+// FUDGE_UNKNOWN_FIELD_WIDTH.
+inline FudgeStatus readFieldHeader ( const fudge_byte * position, const fudge_byte * end, fieldheader & header )
+{
+    if ( end - position < 2 )
+        return FUDGE_OUT_OF_BYTES;
+    header.prefix = static_cast<unsigned char> ( position [ 0 ] );
+    header.type = static_cast<fudge_type_id> ( static_cast<unsigned char> ( position [ 1 ] ) );
+    position += 2;
+
+    if ( ( header.hasordinal = ( header.prefix & OrdinalPrefix ) != 0 ) )
+    {
+        if ( end - position < 2 )
+            return FUDGE_OUT_OF_BYTES;
+        header.ordinal = readI16 ( position );
+        position += 2;
+    }
+    else
+        header.ordinal = 0;
+
+    if ( ( header.hasname = ( header.prefix & NamePrefix ) != 0 ) )
+    {
+        if ( end - position < 1 )
+            return FUDGE_OUT_OF_BYTES;
+        header.namelength = static_cast<unsigned char> ( *position );
+        header.name = position + 1;
+        position += 1 + header.namelength;
+        if ( position > end )
+            return FUDGE_OUT_OF_BYTES;
+    }
+    else
+    {
+        header.name = 0;
+        header.namelength = 0;
+    }
+
+    if ( header.prefix & FixedWidthPrefix )
+    {
+        if ( ( header.numbytes = fixedWidth ( header.type ) ) < 0 )
+            return FUDGE_UNKNOWN_FIELD_WIDTH;
+    }
+    else
+    {
+        switch ( ( header.prefix >> VariableWidthShift ) & 0x03 )
+        {
+            case 0:
+                header.numbytes = 0;
+                break;
+            case 1:
+                if ( end - position < 1 )
+                    return FUDGE_OUT_OF_BYTES;
+                header.numbytes = static_cast<unsigned char> ( *position );
+                position += 1;
+                break;
+            case 2:
+                if ( end - position < 2 )
+                    return FUDGE_OUT_OF_BYTES;
+                header.numbytes = static_cast<unsigned short> ( readI16 ( position ) );
+                position += 2;
+                break;
+            default:
+                if ( end - position < 4 )
+                    return FUDGE_OUT_OF_BYTES;
+                if ( ( header.numbytes = readI32 ( position ) ) < 0 )
+                    return FUDGE_OUT_OF_BYTES;
+                position += 4;
+                break;
+        }
+    }
+
+    if ( end - position < header.numbytes )
+        return FUDGE_OUT_OF_BYTES;
+
+    // Fixed width types must have their fixed width, however they were
+    // encoded, or their readers would run past the payload
+    const fudge_i32 width ( fixedWidth ( header.type ) );
+    if ( width >= 0 && header.numbytes != width )
+        return FUDGE_UNKNOWN_FIELD_WIDTH;
+
+    header.data = position;
+    return FUDGE_OK;
+}
+
+inline uint32_t encodeDate ( const FudgeDate & date )
+{
+    return ( static_cast<uint32_t> ( date.year ) << 9 ) |
+           ( static_cast<uint32_t> ( date.month & 0x0f ) << 5 ) |
+             static_cast<uint32_t> ( date.day & 0x1f );
+}
+
+inline fudge_byte * writeDate ( fudge_byte * target, const FudgeDate & date )
+{
+    return writeI32 ( target, static_cast<fudge_i32> ( encodeDate ( date ) ) );
+}
+
+// Times are two 32 bit words: the timezone offset (in 15 minute intervals,
+// -128 if there is no timezone), precision and seconds since midnight; then
+// the nanoseconds.
+inline fudge_byte * writeTime ( fudge_byte * target, const FudgeTime & time )
+{
+    const uint32_t timezone ( time.hasTimezone ? static_cast<unsigned char> ( time.timezoneOffset ) : 0x80 );
+    target = writeI32 ( target, static_cast<fudge_i32> ( ( timezone << 24 ) |
+                                                         ( ( static_cast<uint32_t> ( time.precision ) & 0x0f ) << 20 ) |
+                                                         ( time.seconds & 0x1ffff ) ) );
+    return writeI32 ( target, static_cast<fudge_i32> ( time.nanoseconds & 0x3fffffff ) );
+}
+
+inline FudgeDate readDate ( const fudge_byte * source )
+{
+    const fudge_i32 encoded ( readI32 ( source ) );
+    FudgeDate date;
+    date.year = encoded >> 9;
+    date.month = static_cast<uint8_t> ( ( encoded >> 5 ) & 0x0f );
+    date.day = static_cast<uint8_t> ( encoded & 0x1f );
+    return date;
+}
+
+inline FudgeTime readTime ( const fudge_byte * source )
+{
+    const uint32_t first ( static_cast<uint32_t> ( readI32 ( source ) ) );
+    const signed char timezone ( static_cast<signed char> ( first >> 24 ) );
+    FudgeTime time;
+    time.hasTimezone = timezone == -128 ? FUDGE_FALSE : FUDGE_TRUE;
+    time.timezoneOffset = timezone == -128 ? 0 : timezone;
+    time.precision = static_cast<FudgeDateTimePrecision> ( ( first >> 20 ) & 0x0f );
+    time.seconds = first & 0x1ffff;
+    time.nanoseconds = static_cast<uint32_t> ( readI32 ( source + 4 ) ) & 0x3fffffff;
+    return time;
+}
+
+}
+}
+
+#endif
+
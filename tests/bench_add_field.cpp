@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "fudge-cpp/message.hpp"
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+#ifdef FUDGE_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// Counts the C++ heap allocations made by message::addField for each way of
+// identifying a field, and times the adds. Allocations made for the name or
+// ordinal arguments show up as the difference from an anonymous add.
+// Usage: bench_add_field [fields]
+
+namespace
+{
+    size_t numallocations ( 0 );
+
+    // Wall clock time in seconds
+    double now ( )
+    {
+#ifdef FUDGE_HAVE_SYS_TIME_H
+        timeval tv;
+        gettimeofday ( &tv, 0 );
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+        return static_cast<double> ( time ( 0 ) );
+#endif
+    }
+
+    enum identity { Anonymous, Named, Ordinal, NamedOrdinal };
+
+    // Adds numfields doubles to a new message, returning the elapsed time
+    // and setting allocations to the number of allocations made
+    double addFields ( identity id, size_t numfields, size_t & allocations )
+    {
+        using fudge::message;
+
+        const fudge::string name ( "price" );
+        message target;
+
+        const size_t before ( numallocations );
+        const double start ( now ( ) );
+        for ( size_t index ( 0 ); index < numfields; ++index )
+        {
+            const fudge_f64 value ( index * 0.25 );
+            switch ( id )
+            {
+                case Anonymous:     target.addField ( value ); break;
+                case Named:         target.addField ( value, name ); break;
+                case Ordinal:       target.addField ( value, message::noname, 1 ); break;
+                case NamedOrdinal:  target.addField ( value, name, 1 ); break;
+            }
+        }
+        const double elapsed ( now ( ) - start );
+        allocations = numallocations - before;
+        return elapsed;
+    }
+}
+
+// Dynamic exception specifications were removed in C++17
+#if __cplusplus < 201103L
+void * operator new ( size_t size ) throw ( std::bad_alloc )
+#else
+void * operator new ( size_t size )
+#endif
+{
+    ++numallocations;
+    if ( void * memory = malloc ( size ? size : 1 ) )
+        return memory;
+    throw std::bad_alloc ( );
+}
+
+void operator delete ( void * memory ) FUDGE_CPP_NOEXCEPT
+{
+    free ( memory );
+}
+
+int main ( int argc, char * argv [ ] )
+{
+    const size_t numfields ( argc > 1 ? strtoul ( argv [ 1 ], 0, 10 ) : 200000 );
+    static const char * const names [ ] = { "anonymous", "name", "ordinal", "name+ordinal" };
+
+    try
+    {
+        fudge::fudge::init ( );
+
+        std::cout << numfields << " fields per message" << std::endl
+                  << std::setw ( 14 ) << "identity" << std::setw ( 14 ) << "allocs/add" << std::setw ( 14 ) << "extra/add" << std::setw ( 14 ) << "ns/add" << std::endl;
+
+        size_t baseline ( 0 );
+        for ( int id ( Anonymous ); id <= NamedOrdinal; ++id )
+        {
+            size_t allocations;
+            const double elapsed ( addFields ( static_cast<identity> ( id ), numfields, allocations ) );
+            if ( id == Anonymous )
+                baseline = allocations;
+
+            std::cout << std::setw ( 14 ) << names [ id ]
+                      << std::setw ( 14 ) << std::fixed << std::setprecision ( 2 ) << static_cast<double> ( allocations ) / numfields
+                      << std::setw ( 14 ) << ( static_cast<double> ( allocations ) - static_cast<double> ( baseline ) ) / numfields
+                      << std::setw ( 14 ) << std::setprecision ( 1 ) << elapsed * 1e9 / numfields << std::endl;
+        }
+    }
+    catch ( const fudge::exception & exception )
+    {
+        std::cerr << "Failed: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/batchdecoder.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+
+#ifdef FUDGE_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// Measures the throughput of batch_decoder as the number of threads grows.
+// Usage: bench_batch_decoder [frames] [max threads]
+
+namespace
+{
+    // Wall clock time in seconds
+    double now ( )
+    {
+#ifdef FUDGE_HAVE_SYS_TIME_H
+        timeval tv;
+        gettimeofday ( &tv, 0 );
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+        return static_cast<double> ( time ( 0 ) );
+#endif
+    }
+
+    // A typical market data style payload: a handful of scalars, a string
+    // and a small submessage
+    fudge::envelope createEnvelope ( size_t index )
+    {
+        using fudge::message;
+        using fudge::string;
+
+        message quote;
+        quote.addField ( 100.25 + index % 100, string ( "bid" ) );
+        quote.addField ( 100.5 + index % 100, string ( "ask" ) );
+        quote.addField ( static_cast<fudge_i64> ( 1000 + index ), string ( "size" ) );
+
+        message payload;
+        payload.addField ( string ( "INSTRUMENT" ), string ( "ticker" ), 1 );
+        payload.addField ( static_cast<fudge_i64> ( index ), string ( "sequence" ), 2 );
+        payload.addField ( quote, string ( "quote" ), 3 );
+        payload.addField ( std::vector<fudge_f64> ( 8, 1.5 ), string ( "history" ), 4 );
+        return fudge::envelope ( 0, 0, 1, payload );
+    }
+}
+
+int main ( int argc, char * argv [ ] )
+{
+    const size_t numframes ( argc > 1 ? strtoul ( argv [ 1 ], 0, 10 ) : 200000 );
+    size_t maxthreads ( argc > 2 ? strtoul ( argv [ 2 ], 0, 10 ) : 0 );
+
+    try
+    {
+        fudge::fudge::init ( );
+        if ( ! maxthreads )
+            maxthreads = fudge::batch_decoder ( ).numthreads ( );
+
+        std::vector<fudge::envelope> envelopes;
+        for ( size_t index ( 0 ); index < numframes; ++index )
+            envelopes.push_back ( createEnvelope ( index ) );
+
+        std::vector<fudge_byte> buffer;
+        std::vector<size_t> offsets;
+        fudge::codec ( ).encodeBatch ( envelopes, buffer, offsets );
+        envelopes.clear ( );
+
+        std::cout << numframes << " frames, " << buffer.size ( ) << " bytes" << std::endl
+                  << std::setw ( 8 ) << "threads" << std::setw ( 14 ) << "frames/s" << std::setw ( 10 ) << "MB/s" << std::setw ( 10 ) << "speedup" << std::endl;
+
+        double baseline ( 0.0 );
+        for ( size_t numthreads ( 1 ); numthreads <= maxthreads; numthreads *= 2 )
+        {
+            fudge::batch_decoder decoder ( numthreads );
+
+            // Take the best of three runs
+            double best ( 0.0 );
+            for ( int run ( 0 ); run < 3; ++run )
+            {
+                envelopes.clear ( );
+                envelopes.reserve ( numframes );
+
+                const double start ( now ( ) );
+                decoder.decode ( &buffer [ 0 ], buffer.size ( ), envelopes );
+                const double elapsed ( now ( ) - start );
+                if ( ! run || elapsed < best )
+                    best = elapsed;
+            }
+
+            const double rate ( best > 0.0 ? numframes / best : 0.0 );
+            if ( numthreads == 1 )
+                baseline = rate;
+
+            std::cout << std::setw ( 8 ) << decoder.numthreads ( )
+                      << std::setw ( 14 ) << std::fixed << std::setprecision ( 0 ) << rate
+                      << std::setw ( 10 ) << std::setprecision ( 1 ) << ( best > 0.0 ? buffer.size ( ) / best / 1048576.0 : 0.0 )
+                      << std::setw ( 10 ) << std::setprecision ( 2 ) << ( baseline > 0.0 ? rate / baseline : 0.0 ) << std::endl;
+
+            if ( numthreads < maxthreads && numthreads * 2 > maxthreads )
+                numthreads = maxthreads / 2;
+        }
+    }
+    catch ( const fudge::exception & exception )
+    {
+        std::cerr << "Failed: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
@@ -0,0 +1,157 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "fudge-cpp/messagebuilder.hpp"
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+#ifdef FUDGE_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// Compares building and encoding the same shape of message repeatedly with a
+// new fudge::message each time against reusing a message_builder. Counts the
+// C++ heap allocations made per message (Fudge-C's own mallocs, made for
+// every field of a fudge::message, are not included) and times each.
+// Usage: bench_message_builder [messages]
+
+namespace
+{
+    size_t numallocations ( 0 );
+
+    // Wall clock time in seconds
+    double now ( )
+    {
+#ifdef FUDGE_HAVE_SYS_TIME_H
+        timeval tv;
+        gettimeofday ( &tv, 0 );
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+        return static_cast<double> ( time ( 0 ) );
+#endif
+    }
+
+    const fudge::field_key Ticker ( "ticker", 1 ),
+                           Sequence ( "sequence", 2 ),
+                           Bid ( "bid", 3 ),
+                           Ask ( "ask", 4 ),
+                           Size ( "size", 5 );
+
+    template<class Target> inline void addFields ( Target & target, size_t index, const fudge::string & ticker )
+    {
+        target.addField ( ticker, Ticker );
+        target.addField ( static_cast<fudge_i64> ( index ), Sequence );
+        target.addField ( 100.25 + index % 100, Bid );
+        target.addField ( 100.5 + index % 100, Ask );
+        target.addField ( static_cast<fudge_i32> ( 1000 + index % 5000 ), Size );
+    }
+
+    double buildMessages ( size_t nummessages, std::vector<fudge_byte> & buffer, size_t & allocations )
+    {
+        const fudge::string ticker ( "INSTRUMENT" );
+        const fudge::codec codec;
+
+        const size_t before ( numallocations );
+        const double start ( now ( ) );
+        for ( size_t index ( 0 ); index < nummessages; ++index )
+        {
+            fudge::message target;
+            addFields ( target, index, ticker );
+            buffer.clear ( );
+            codec.encode ( fudge::envelope ( 0, 0, 0, target ), buffer );
+        }
+        const double elapsed ( now ( ) - start );
+        allocations = numallocations - before;
+        return elapsed;
+    }
+
+    double buildWithBuilder ( size_t nummessages, std::vector<fudge_byte> & buffer, size_t & allocations )
+    {
+        const fudge::string ticker ( "INSTRUMENT" );
+        fudge::message_builder target;
+
+        const size_t before ( numallocations );
+        const double start ( now ( ) );
+        for ( size_t index ( 0 ); index < nummessages; ++index )
+        {
+            target.reset ( );
+            addFields ( target, index, ticker );
+            buffer.clear ( );
+            target.encode ( buffer );
+        }
+        const double elapsed ( now ( ) - start );
+        allocations = numallocations - before;
+        return elapsed;
+    }
+}
+
+// Dynamic exception specifications were removed in C++17
+#if __cplusplus < 201103L
+void * operator new ( size_t size ) throw ( std::bad_alloc )
+#else
+void * operator new ( size_t size )
+#endif
+{
+    ++numallocations;
+    if ( void * memory = malloc ( size ? size : 1 ) )
+        return memory;
+    throw std::bad_alloc ( );
+}
+
+void operator delete ( void * memory ) FUDGE_CPP_NOEXCEPT
+{
+    free ( memory );
+}
+
+int main ( int argc, char * argv [ ] )
+{
+    const size_t nummessages ( argc > 1 ? strtoul ( argv [ 1 ], 0, 10 ) : 200000 );
+
+    try
+    {
+        fudge::fudge::init ( );
+
+        std::vector<fudge_byte> buffer;
+        buffer.reserve ( 1024 );
+
+        std::cout << nummessages << " messages" << std::endl
+                  << std::setw ( 14 ) << "method" << std::setw ( 14 ) << "allocs/msg" << std::setw ( 14 ) << "ns/msg" << std::endl;
+
+        for ( int method ( 0 ); method < 2; ++method )
+        {
+            size_t allocations;
+            const double elapsed ( method ? buildWithBuilder ( nummessages, buffer, allocations )
+                                          : buildMessages ( nummessages, buffer, allocations ) );
+
+            std::cout << std::setw ( 14 ) << ( method ? "builder" : "message" )
+                      << std::setw ( 14 ) << std::fixed << std::setprecision ( 2 ) << static_cast<double> ( allocations ) / nummessages
+                      << std::setw ( 14 ) << std::setprecision ( 1 ) << elapsed * 1e9 / nummessages << std::endl;
+        }
+    }
+    catch ( const fudge::exception & exception )
+    {
+        std::cerr << "Failed: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
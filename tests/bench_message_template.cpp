@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "fudge-cpp/messagebuilder.hpp"
+#include "fudge-cpp/messagetemplate.hpp"
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef FUDGE_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// Compares producing a stream of quotes, which differ only in their numeric
+// fields, by building each with a message_builder against patching the
+// slots of a message_template. Each quote is copied out to a send buffer,
+// standing in for the write to the network.
+// Usage: bench_message_template [messages]
+
+namespace
+{
+    // Wall clock time in seconds
+    double now ( )
+    {
+#ifdef FUDGE_HAVE_SYS_TIME_H
+        timeval tv;
+        gettimeofday ( &tv, 0 );
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+        return static_cast<double> ( time ( 0 ) );
+#endif
+    }
+
+    const fudge::field_key Ticker ( "ticker", 1 ),
+                           Sequence ( "sequence", 2 ),
+                           Bid ( "bid", 3 ),
+                           Ask ( "ask", 4 ),
+                           Size ( "size", 5 );
+
+    template<class Target> inline void addFields ( Target & target, size_t index, const fudge::string & ticker )
+    {
+        target.addField ( ticker, Ticker );
+        target.addField ( static_cast<fudge_i64> ( index ), Sequence );
+        target.addField ( 100.25 + index % 100, Bid );
+        target.addField ( 100.5 + index % 100, Ask );
+        target.addField ( static_cast<fudge_i32> ( 1000 + index % 5000 ), Size );
+    }
+
+    double buildWithBuilder ( size_t nummessages, fudge_byte * buffer )
+    {
+        const fudge::string ticker ( "INSTRUMENT" );
+        fudge::message_builder target;
+        std::vector<fudge_byte> encoded;
+
+        const double start ( now ( ) );
+        for ( size_t index ( 0 ); index < nummessages; ++index )
+        {
+            target.reset ( );
+            addFields ( target, index, ticker );
+            encoded.clear ( );
+            target.encode ( encoded );
+            memcpy ( buffer, &( encoded [ 0 ] ), encoded.size ( ) );
+        }
+        return now ( ) - start;
+    }
+
+    double patchTemplate ( size_t nummessages, fudge_byte * buffer )
+    {
+        fudge::message prototype;
+        addFields ( prototype, 0, fudge::string ( "INSTRUMENT" ) );
+        fudge::message_template target ( prototype );
+        const size_t sequence ( target.addSlot ( Sequence, FUDGE_TYPE_LONG ) ),
+                     bid ( target.addSlot ( Bid, FUDGE_TYPE_DOUBLE ) ),
+                     ask ( target.addSlot ( Ask, FUDGE_TYPE_DOUBLE ) ),
+                     size ( target.addSlot ( Size, FUDGE_TYPE_INT ) );
+
+        const double start ( now ( ) );
+        for ( size_t index ( 0 ); index < nummessages; ++index )
+        {
+            target.set ( sequence, static_cast<fudge_i64> ( index ) );
+            target.set ( bid, 100.25 + index % 100 );
+            target.set ( ask, 100.5 + index % 100 );
+            target.set ( size, static_cast<fudge_i32> ( 1000 + index % 5000 ) );
+            memcpy ( buffer, target.bytes ( ), target.numbytes ( ) );
+        }
+        return now ( ) - start;
+    }
+}
+
+int main ( int argc, char * argv [ ] )
+{
+    const size_t nummessages ( argc > 1 ? strtoul ( argv [ 1 ], 0, 10 ) : 1000000 );
+
+    try
+    {
+        fudge::fudge::init ( );
+
+        fudge_byte buffer [ 1024 ];
+
+        std::cout << nummessages << " messages" << std::endl
+                  << std::setw ( 14 ) << "method" << std::setw ( 14 ) << "ns/msg" << std::endl;
+
+        for ( int method ( 0 ); method < 2; ++method )
+        {
+            const double elapsed ( method ? patchTemplate ( nummessages, buffer )
+                                          : buildWithBuilder ( nummessages, buffer ) );
+
+            std::cout << std::setw ( 14 ) << ( method ? "template" : "builder" )
+                      << std::setw ( 14 ) << std::fixed << std::setprecision ( 1 ) << elapsed * 1e9 / nummessages << std::endl;
+        }
+    }
+    catch ( const fudge::exception & exception )
+    {
+        std::cerr << "Failed: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "fudge-cpp/sharedmessage.hpp"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#ifdef FUDGE_HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// Measures how reads of a single shared_message scale as the number of
+// reader threads grows. Each read takes a reference to the message, looks up
+// a few fields through its view and drops the reference again.
+// Usage: bench_shared_message [reads per thread] [max threads]
+
+namespace
+{
+    // Wall clock time in seconds
+    double now ( )
+    {
+#ifdef FUDGE_HAVE_SYS_TIME_H
+        timeval tv;
+        gettimeofday ( &tv, 0 );
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+        return static_cast<double> ( time ( 0 ) );
+#endif
+    }
+
+    // Work for one reader thread
+    struct reader
+    {
+        const fudge::shared_message * source;
+        size_t reads;
+        double total;
+    };
+
+    void * readerMain ( void * arg )
+    {
+        using fudge::string;
+
+        reader & self ( *static_cast<reader *> ( arg ) );
+        for ( size_t index ( 0 ); index < self.reads; ++index )
+        {
+            const fudge::shared_message local ( *self.source );
+            const fudge::message_view & view ( local.view ( ) );
+            self.total += view.getField ( string ( "bid" ) ).getAsFloat64 ( ) +
+                          view.getField ( static_cast<fudge_i16> ( 2 ) ).getAsInt64 ( );
+        }
+        return 0;
+    }
+
+    // Runs numthreads readers against the message, returning the elapsed time
+    double run ( const fudge::shared_message & message, size_t numthreads, size_t reads )
+    {
+        std::vector<reader> readers ( numthreads );
+        for ( size_t index ( 0 ); index < numthreads; ++index )
+        {
+            readers [ index ].source = &message;
+            readers [ index ].reads = reads;
+            readers [ index ].total = 0.0;
+        }
+
+        const double start ( now ( ) );
+#ifdef FUDGE_HAVE_PTHREAD_H
+        std::vector<pthread_t> threads ( numthreads );
+        for ( size_t index ( 0 ); index < numthreads; ++index )
+            if ( pthread_create ( &( threads [ index ] ), 0, &readerMain, &( readers [ index ] ) ) )
+                throw fudge::exception ( FUDGE_OUT_OF_MEMORY );
+        for ( size_t index ( 0 ); index < numthreads; ++index )
+            pthread_join ( threads [ index ], 0 );
+#else
+        for ( size_t index ( 0 ); index < numthreads; ++index )
+            readerMain ( &( readers [ index ] ) );
+#endif
+        return now ( ) - start;
+    }
+}
+
+int main ( int argc, char * argv [ ] )
+{
+    using fudge::message;
+    using fudge::string;
+
+    const size_t numreads ( argc > 1 ? strtoul ( argv [ 1 ], 0, 10 ) : 1000000 );
+    const size_t maxthreads ( argc > 2 ? strtoul ( argv [ 2 ], 0, 10 ) : 8 );
+
+    try
+    {
+        fudge::fudge::init ( );
+
+        message quote;
+        quote.addField ( string ( "INSTRUMENT" ), string ( "ticker" ), 1 );
+        quote.addField ( static_cast<fudge_i64> ( 123456 ), string ( "sequence" ), 2 );
+        quote.addField ( 100.25, string ( "bid" ), 3 );
+        quote.addField ( 100.5, string ( "ask" ), 4 );
+        const fudge::shared_message shared ( quote );
+
+        std::cout << numreads << " reads per thread, " << shared.numbytes ( ) << " bytes" << std::endl
+                  << std::setw ( 8 ) << "threads" << std::setw ( 14 ) << "reads/s" << std::setw ( 10 ) << "speedup" << std::endl;
+
+        double baseline ( 0.0 );
+        for ( size_t numthreads ( 1 ); numthreads <= maxthreads; numthreads *= 2 )
+        {
+            // Take the best of three runs
+            double best ( 0.0 );
+            for ( int attempt ( 0 ); attempt < 3; ++attempt )
+            {
+                const double elapsed ( run ( shared, numthreads, numreads ) );
+                if ( ! attempt || elapsed < best )
+                    best = elapsed;
+            }
+
+            const double rate ( best > 0.0 ? numreads * numthreads / best : 0.0 );
+            if ( numthreads == 1 )
+                baseline = rate;
+
+            std::cout << std::setw ( 8 ) << numthreads
+                      << std::setw ( 14 ) << std::fixed << std::setprecision ( 0 ) << rate
+                      << std::setw ( 10 ) << std::setprecision ( 2 ) << ( baseline > 0.0 ? rate / baseline : 0.0 ) << std::endl;
+
+            if ( numthreads < maxthreads && numthreads * 2 > maxthreads )
+                numthreads = maxthreads / 2;
+        }
+    }
+    catch ( const fudge::exception & exception )
+    {
+        std::cerr << "Failed: " << exception.what ( ) << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
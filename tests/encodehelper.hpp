@@ -0,0 +1,32 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGE_CPP_ENCODEHELPER_HPP
+#define INC_FUDGE_CPP_ENCODEHELPER_HPP
+
+#include "fudge-cpp/codec.hpp"
+#include <vector>
+
+// Encodes the message in an envelope with the codec, giving the reference
+// bytes that the faster encoders under test are compared against
+inline std::vector<fudge_byte> encodeMessage ( const fudge::message & source, fudge_i16 taxonomy = 0 )
+{
+    std::vector<fudge_byte> bytes;
+    fudge::codec ( ).encode ( fudge::envelope ( 0, 0, taxonomy, source ), bytes );
+    return bytes;
+}
+
+#endif
+
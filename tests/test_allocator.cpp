@@ -0,0 +1,200 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "fudge-cpp/allocator.hpp"
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fudge.hpp"
+#include "fudge-cpp/sharedmessage.hpp"
+#include <string.h>
+
+namespace
+{
+    // Counts the bytes outstanding from the standard allocator
+    class countingallocator : public fudge::allocator
+    {
+        public:
+            countingallocator ( ) : allocations ( 0 ), outstanding ( 0 ) { }
+
+            void * allocate ( size_t numbytes );
+            void deallocate ( void * memory, size_t numbytes );
+
+            size_t allocations;
+            size_t outstanding;
+    };
+
+    inline bool isAligned ( const void * memory )
+    {
+        return reinterpret_cast<size_t> ( memory ) % sizeof ( long double ) == 0;
+    }
+}
+
+DEFINE_TEST( Arena )
+    using fudge::arena;
+
+    arena memory ( 1024 );
+    TEST_EQUALS_INT( memory.used ( ), 0 );
+    TEST_EQUALS_INT( memory.capacity ( ), 0 );
+
+    // Allocations are aligned and follow one another in the same chunk
+    char * first ( static_cast<char *> ( memory.allocate ( 3 ) ) );
+    char * second ( static_cast<char *> ( memory.allocate ( 100 ) ) );
+    TEST_EQUALS_TRUE( isAligned ( first ) );
+    TEST_EQUALS_TRUE( isAligned ( second ) );
+    TEST_EQUALS_TRUE( second > first && second - first < 64 );
+    TEST_EQUALS_INT( memory.capacity ( ), 1024 );
+    memset ( first, 1, 3 );
+    memset ( second, 2, 100 );
+    TEST_EQUALS_INT( first [ 2 ], 1 );
+
+    // Filling the chunk moves on to another, oversized requests get their own
+    for ( int index ( 0 ); index < 20; ++index )
+        TEST_EQUALS_TRUE( isAligned ( memory.allocate ( 100 ) ) );
+    TEST_EQUALS_INT( memory.capacity ( ), 3072 );
+    memory.allocate ( 4096 );
+    TEST_EQUALS_INT( memory.capacity ( ), 7168 );
+    TEST_EQUALS_TRUE( memory.used ( ) >= 4096 + 21 * 100 + 3 );
+
+    // Resetting releases the oversized chunk and reuses the others
+    memory.deallocate ( first, 3 );
+    memory.reset ( );
+    TEST_EQUALS_INT( memory.used ( ), 0 );
+    TEST_EQUALS_INT( memory.capacity ( ), 3072 );
+    TEST_EQUALS_TRUE( memory.allocate ( 3 ) == first );
+    for ( int index ( 0 ); index < 20; ++index )
+        memory.allocate ( 100 );
+    TEST_EQUALS_INT( memory.capacity ( ), 3072 );
+END_TEST
+
+DEFINE_TEST( Pool )
+    using fudge::pool;
+
+    pool memory;
+
+    // Released blocks are handed out again to requests of the same class
+    void * small ( memory.allocate ( 20 ) );
+    void * other ( memory.allocate ( 32 ) );
+    TEST_EQUALS_TRUE( small != other );
+    TEST_EQUALS_TRUE( isAligned ( small ) );
+    memset ( small, 0xff, 20 );
+    memory.deallocate ( small, 20 );
+    TEST_EQUALS_TRUE( memory.allocate ( 17 ) == small );
+
+    void * large ( memory.allocate ( 1000 ) );
+    TEST_EQUALS_TRUE( isAligned ( large ) );
+    memset ( large, 0, 1000 );
+    memory.deallocate ( large, 1000 );
+    TEST_EQUALS_TRUE( memory.allocate ( 1024 ) == large );
+
+    // Beyond the largest class the pool uses malloc
+    void * huge ( memory.allocate ( pool::MaxPooledSize + 1 ) );
+    memset ( huge, 0, pool::MaxPooledSize + 1 );
+    memory.deallocate ( huge, pool::MaxPooledSize + 1 );
+    memory.deallocate ( 0, 16 );
+
+    // Enough blocks to need several slabs
+    std::vector<void *> blocks;
+    for ( int index ( 0 ); index < 100; ++index )
+        blocks.push_back ( memory.allocate ( 4096 ) );
+    for ( size_t index ( 1 ); index < blocks.size ( ); ++index )
+        TEST_EQUALS_TRUE( blocks [ index ] != blocks [ index - 1 ] );
+    for ( size_t index ( 0 ); index < blocks.size ( ); ++index )
+        memory.deallocate ( blocks [ index ], 4096 );
+END_TEST
+
+DEFINE_TEST( DecodeInToArena )
+    using fudge::message;
+    using fudge::string;
+
+    message source;
+    source.addField ( static_cast<fudge_i32> ( 1234 ), string ( "int" ) );
+    source.addField ( string ( "In the arena" ), string ( "string" ), 2 );
+    message submessage;
+    submessage.addField ( 1.5, string ( "price" ) );
+    source.addField ( submessage, string ( "sub" ) );
+
+    std::vector<fudge_byte> bytes;
+    const fudge::codec codec;
+    codec.encode ( fudge::envelope ( 0, 0, 0, source ), bytes );
+
+    fudge::arena memory;
+    const fudge::message_view view ( codec.decode ( &bytes [ 0 ], bytes.size ( ), memory ) );
+    TEST_EQUALS_INT( memory.used ( ), bytes.size ( ) + ( 16 - bytes.size ( ) % 16 ) % 16 );
+
+    // The view reads the arena's copy, not the original bytes
+    bytes.assign ( bytes.size ( ), 0 );
+    TEST_EQUALS_INT( view.size ( ), 3 );
+    TEST_EQUALS_INT( view.getField ( string ( "int" ) ).getAsInt32 ( ), 1234 );
+    TEST_EQUALS_TRUE( view.getField ( static_cast<fudge_i16> ( 2 ) ).getStringBytes ( ) == "In the arena" );
+    TEST_EQUALS_FLOAT( view.getField ( string ( "sub" ) ).getMessage ( ).getFieldAt ( 0 ).getFloat64 ( ), 1.5, 0.0 );
+    memory.reset ( );
+
+    // Malformed envelopes are rejected
+    bytes.clear ( );
+    codec.encode ( fudge::envelope ( 0, 0, 0, source ), bytes );
+    TEST_THROWS_EXCEPTION( codec.decode ( &bytes [ 0 ], 4, memory ), fudge::exception );
+    bytes [ 8 ] = 0xff;
+    TEST_THROWS_EXCEPTION( codec.decode ( &bytes [ 0 ], bytes.size ( ), memory ), fudge::exception );
+    TEST_EQUALS_INT( memory.used ( ), 0 );
+END_TEST
+
+DEFINE_TEST( DefaultAllocator )
+    using fudge::message;
+
+    TEST_EQUALS_TRUE( &fudge::fudge::defaultAllocator ( ) == &fudge::allocator::standard ( ) );
+
+    countingallocator counting;
+    fudge::fudge::init ( counting );
+    TEST_EQUALS_TRUE( &fudge::fudge::defaultAllocator ( ) == &counting );
+
+    message source;
+    source.addField ( static_cast<fudge_i32> ( 42 ) );
+    {
+        const fudge::shared_message frozen ( source );
+        TEST_EQUALS_INT( counting.allocations, 1 );
+        TEST_EQUALS_INT( counting.outstanding, frozen.numbytes ( ) );
+
+        // Memory goes back to the allocator it came from
+        fudge::fudge::init ( fudge::allocator::standard ( ) );
+        const fudge::shared_message copy ( frozen );
+        TEST_EQUALS_INT( counting.allocations, 1 );
+    }
+    TEST_EQUALS_INT( counting.outstanding, 0 );
+END_TEST
+
+DEFINE_TEST_SUITE( Allocator )
+    REGISTER_TEST( Arena )
+    REGISTER_TEST( Pool )
+    REGISTER_TEST( DecodeInToArena )
+    REGISTER_TEST( DefaultAllocator )
+END_TEST_SUITE
+
+namespace
+{
+    void * countingallocator::allocate ( size_t numbytes )
+    {
+        ++allocations;
+        outstanding += numbytes;
+        return fudge::allocator::standard ( ).allocate ( numbytes );
+    }
+
+    void countingallocator::deallocate ( void * memory, size_t numbytes )
+    {
+        outstanding -= numbytes;
+        fudge::allocator::standard ( ).deallocate ( memory, numbytes );
+    }
+}
+
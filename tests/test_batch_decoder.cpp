@@ -0,0 +1,192 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "fudge-cpp/batchdecoder.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge/codec.h"
+#include "fudge/message.h"
+
+namespace
+{
+    // Encodes count envelopes back to back, each identified by its index
+    void createBatch ( size_t count, std::vector<fudge_byte> & buffer, std::vector<size_t> & offsets );
+
+    // Returns true if the envelope is the one createBatch built at index
+    bool isEnvelope ( const fudge::envelope & envelope, size_t index );
+
+    // A user type whose decoder throws something other than a
+    // fudge::exception
+    static const fudge_type_id FUDGE_TYPE_REJECTED = 102;
+
+    struct rejected
+    {
+    };
+
+    FudgeStatus decodeRejected ( const fudge_byte * bytes, const fudge_i32 width, FudgeFieldData * data );
+    FudgeStatus coerceRejected ( const FudgeField * source, const fudge_type_id type, FudgeFieldData * target, fudge_i32 * numbytes );
+}
+
+DEFINE_TEST( Scan )
+    using fudge::batch_decoder;
+
+    std::vector<fudge_byte> buffer;
+    std::vector<size_t> offsets, scanned ( 1, 0 );
+    createBatch ( 100, buffer, offsets );
+
+    // Scanning appends to the offsets
+    TEST_EQUALS_INT( batch_decoder::scan ( &buffer [ 0 ], buffer.size ( ), scanned ), 100 );
+    TEST_EQUALS_INT( scanned.size ( ), 101 );
+    scanned.erase ( scanned.begin ( ) );
+    TEST_EQUALS_VECTOR( scanned, offsets );
+
+    // Incomplete buffers leave the offsets alone
+    scanned.clear ( );
+    TEST_THROWS_EXCEPTION( batch_decoder::scan ( &buffer [ 0 ], buffer.size ( ) - 1, scanned ), fudge::exception );
+    TEST_THROWS_EXCEPTION( batch_decoder::scan ( &buffer [ 0 ], offsets [ 99 ] + 4, scanned ), fudge::exception );
+    TEST_EQUALS_INT( scanned.size ( ), 0 );
+
+    TEST_EQUALS_INT( batch_decoder::scan ( 0, 0, scanned ), 0 );
+    TEST_THROWS_EXCEPTION( batch_decoder::scan ( 0, 8, scanned ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( DecodeInOrder )
+    using fudge::batch_decoder;
+    using fudge::envelope;
+
+    std::vector<fudge_byte> buffer;
+    std::vector<size_t> offsets;
+    createBatch ( 5000, buffer, offsets );
+
+    // Every pool size must give the same result, and a pool can be reused
+    const size_t threadcounts [ ] = { 1, 2, 3, 8, 0 };
+    for ( size_t index ( 0 ); index < sizeof ( threadcounts ) / sizeof ( size_t ); ++index )
+    {
+        batch_decoder decoder ( threadcounts [ index ] );
+        TEST_EQUALS_TRUE( decoder.numthreads ( ) >= 1 );
+
+        for ( int repeat ( 0 ); repeat < 3; ++repeat )
+        {
+            std::vector<envelope> envelopes ( 1 );
+            TEST_EQUALS_INT( decoder.decode ( &buffer [ 0 ], buffer.size ( ), envelopes ), 5000 );
+            TEST_EQUALS_INT( envelopes.size ( ), 5001 );
+            TEST_EQUALS_TRUE( ! envelopes [ 0 ].raw ( ) );
+
+            bool inorder ( true );
+            for ( size_t frame ( 0 ); frame < 5000; ++frame )
+                inorder = inorder && isEnvelope ( envelopes [ frame + 1 ], frame );
+            TEST_EQUALS_TRUE( inorder );
+        }
+    }
+
+    // Fewer frames than threads
+    batch_decoder decoder ( 4 );
+    std::vector<envelope> envelopes;
+    TEST_EQUALS_INT( decoder.decode ( &buffer [ 0 ], offsets [ 2 ], envelopes ), 2 );
+    TEST_EQUALS_TRUE( isEnvelope ( envelopes [ 1 ], 1 ) );
+    TEST_EQUALS_INT( decoder.decode ( &buffer [ 0 ], 0, envelopes ), 0 );
+    TEST_EQUALS_INT( envelopes.size ( ), 2 );
+END_TEST
+
+DEFINE_TEST( DecodeFailures )
+    using fudge::batch_decoder;
+    using fudge::envelope;
+
+    std::vector<fudge_byte> buffer;
+    std::vector<size_t> offsets;
+    createBatch ( 1000, buffer, offsets );
+
+    // Truncated buffers are rejected before anything is decoded
+    batch_decoder decoder ( 4 );
+    std::vector<envelope> envelopes;
+    TEST_THROWS_EXCEPTION( decoder.decode ( &buffer [ 0 ], buffer.size ( ) - 1, envelopes ), fudge::exception );
+    TEST_EQUALS_INT( envelopes.size ( ), 0 );
+
+    // Corrupt a field prefix in the middle of the batch so that its width
+    // can't be determined; the decoder must stop, throw and remain usable
+    std::vector<fudge_byte> corrupt ( buffer );
+    corrupt [ offsets [ 600 ] + 8 ] = static_cast<fudge_byte> ( 0x80 );
+    corrupt [ offsets [ 600 ] + 9 ] = static_cast<fudge_byte> ( 200 );
+    TEST_THROWS_EXCEPTION( decoder.decode ( &corrupt [ 0 ], corrupt.size ( ), envelopes ), fudge::exception );
+    TEST_EQUALS_INT( envelopes.size ( ), 0 );
+
+    TEST_EQUALS_INT( decoder.decode ( &buffer [ 0 ], buffer.size ( ), envelopes ), 1000 );
+    TEST_EQUALS_TRUE( isEnvelope ( envelopes [ 999 ], 999 ) );
+
+    // Exceptions of other types, thrown while a worker decodes, reach the
+    // caller with their own type
+    TEST_EQUALS_INT( FudgeRegistry_registerType ( FUDGE_TYPE_REJECTED,
+                                                  FUDGE_TYPE_PAYLOAD_BYTES,
+                                                  decodeRejected,
+                                                  FudgeCodec_encodeFieldByteArray,
+                                                  coerceRejected ), FUDGE_OK );
+    fudge::message message;
+    const fudge_byte payload [ ] = { 1, 2, 3, 4 };
+    fudge::exception::throwOnError ( FudgeMsg_addFieldOpaque ( message.raw ( ), FUDGE_TYPE_REJECTED, 0, 0, payload, sizeof ( payload ) ) );
+    std::vector<fudge_byte> bad;
+    fudge::codec ( ).encode ( fudge::envelope ( 0, 0, 0, message ), bad );
+    std::vector<fudge_byte> mixed ( buffer );
+    mixed.insert ( mixed.begin ( ) + offsets [ 600 ], bad.begin ( ), bad.end ( ) );
+
+    envelopes.clear ( );
+    TEST_THROWS_EXCEPTION( decoder.decode ( &mixed [ 0 ], mixed.size ( ), envelopes ), rejected );
+    TEST_EQUALS_INT( envelopes.size ( ), 0 );
+    TEST_EQUALS_INT( decoder.decode ( &buffer [ 0 ], buffer.size ( ), envelopes ), 1000 );
+END_TEST
+
+DEFINE_TEST_SUITE( BatchDecoder )
+    REGISTER_TEST( Scan )
+    REGISTER_TEST( DecodeInOrder )
+    REGISTER_TEST( DecodeFailures )
+END_TEST_SUITE
+
+namespace
+{
+    void createBatch ( size_t count, std::vector<fudge_byte> & buffer, std::vector<size_t> & offsets )
+    {
+        std::vector<fudge::envelope> envelopes;
+        for ( size_t index ( 0 ); index < count; ++index )
+        {
+            // Vary the payload size so the envelopes don't share a length
+            fudge::message message;
+            message.addField ( static_cast<fudge_i32> ( index ), fudge::string ( "index" ) );
+            message.addField ( std::vector<fudge_i16> ( index % 50, 1 ), fudge::string ( "padding" ) );
+            envelopes.push_back ( fudge::envelope ( 0, 0, static_cast<fudge_i16> ( index % 1000 ), message ) );
+        }
+
+        fudge::codec ( ).encodeBatch ( envelopes, buffer, offsets );
+    }
+
+    bool isEnvelope ( const fudge::envelope & envelope, size_t index )
+    {
+        if ( ! envelope.raw ( ) || envelope.taxonomy ( ) != static_cast<fudge_i16> ( index % 1000 ) )
+            return false;
+
+        fudge::message payload ( envelope.payload ( ) );
+        return payload.size ( ) == 2 &&
+               payload.getField ( fudge::string ( "index" ) ).getAsInt32 ( ) == static_cast<fudge_i32> ( index ) &&
+               payload.getField ( fudge::string ( "padding" ) ).numelements ( ) == index % 50;
+    }
+    FudgeStatus decodeRejected ( const fudge_byte *, const fudge_i32, FudgeFieldData * )
+    {
+        throw rejected ( );
+    }
+
+    FudgeStatus coerceRejected ( const FudgeField *, const fudge_type_id, FudgeFieldData *, fudge_i32 * )
+    {
+        return FUDGE_INVALID_TYPE_COERCION;
+    }
+}
+
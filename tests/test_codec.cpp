@@ -32,6 +32,7 @@ namespace
 
     void loadFile ( const std::string & filename, fudge_byte * & bytes, fudge_i32 & numbytes );
     fudge::message loadFudgeMessage ( const std::string & filename );
+    bool viewMatches ( const fudge::message_view & view, const fudge::message & message );
 
     // Possibly move this in to string.hpp? Too slow for non-test use?
     std::ostream & operator<< ( std::ostream & stream, const fudge::string & string )
@@ -798,6 +799,610 @@ DEFINE_TEST( EncodeDeepTree )
     delete [] reference;
 END_TEST
 
+DEFINE_TEST( EncodeInPlace )
+    using fudge::codec;
+    using fudge::envelope;
+
+    // Every reference file should encode identically through the in-place
+    // encoders; the unknown types file can only be encoded by Fudge-C
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+
+    codec codec1;
+    std::vector<fudge_byte> buffer;
+    for ( size_t index ( 0 ); index < sizeof ( filenames ) / sizeof ( std::string ); ++index )
+    {
+        fudge_byte * reference;
+        fudge_i32 referencesize;
+        loadFile ( filenames [ index ], reference, referencesize );
+        envelope envelope1 ( codec1.decode ( reference, referencesize ) );
+
+        // Too small a buffer should report the size required without writing
+        std::vector<fudge_byte> target ( referencesize + 1, 0 );
+        fudge_i32 numbytes ( 0 );
+        TEST_EQUALS_TRUE( ! codec1.encode ( envelope1, &target [ 0 ], referencesize - 1, numbytes ) );
+        TEST_EQUALS_INT( numbytes, referencesize );
+        TEST_EQUALS_TRUE( target == std::vector<fudge_byte> ( referencesize + 1, 0 ) );
+
+        // A large enough buffer is written to and the size returned
+        numbytes = 0;
+        TEST_EQUALS_TRUE( codec1.encode ( envelope1, &target [ 0 ], referencesize + 1, numbytes ) );
+        TEST_EQUALS_MEMORY( &target [ 0 ], numbytes, reference, referencesize );
+
+        // The growable buffer is appended to, so encode twice
+        buffer.clear ( );
+        TEST_EQUALS_INT( codec1.encode ( envelope1, buffer ), referencesize );
+        TEST_EQUALS_INT( codec1.encode ( envelope1, buffer ), referencesize );
+        TEST_EQUALS_MEMORY( &buffer [ 0 ], referencesize, reference, referencesize );
+        TEST_EQUALS_MEMORY( &buffer [ referencesize ], buffer.size ( ) - referencesize, reference, referencesize );
+
+        delete [] reference;
+    }
+
+    // Null envelopes cannot be encoded
+    fudge_i32 numbytes;
+    TEST_THROWS_EXCEPTION( codec1.encode ( envelope ( ), &buffer [ 0 ], buffer.size ( ), numbytes ), fudge::exception );
+    TEST_THROWS_EXCEPTION( codec1.encode ( envelope ( ), buffer ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( EncodeWide )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::message;
+    using fudge::string;
+
+    // Wide submessages within a wide message overflow the encoder's local
+    // field storage part way through the tree; the native encoding must
+    // still match Fudge-C's
+    message message1;
+    for ( fudge_i32 outer ( 0 ); outer < 100; ++outer )
+    {
+        if ( outer % 10 )
+        {
+            message1.addField ( outer, message::noname, static_cast<fudge_i16> ( outer ) );
+            continue;
+        }
+
+        message submessage;
+        for ( fudge_i32 inner ( 0 ); inner < 40; ++inner )
+            submessage.addField ( outer * 100 + inner, string ( "inner" ) );
+        message1.addField ( submessage, string ( "sub" ) );
+    }
+
+    codec codec1;
+    envelope envelope1 ( 0, 0, 0, message1 );
+    fudge_byte * reference;
+    fudge_i32 referencesize;
+    codec1.encode ( envelope1, reference, referencesize );
+
+    std::vector<fudge_byte> buffer;
+    TEST_EQUALS_INT( codec1.encode ( envelope1, buffer ), referencesize );
+    TEST_EQUALS_MEMORY( &buffer [ 0 ], buffer.size ( ), reference, referencesize );
+    TEST_EQUALS_INT( codec1.encodedSize ( envelope1 ), referencesize );
+    free ( reference );
+END_TEST
+
+DEFINE_TEST( EncodedSize )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::message;
+    using fudge::string;
+
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+
+    // The sizes of the decoded reference files must match the files
+    codec codec1;
+    for ( size_t index ( 0 ); index < sizeof ( filenames ) / sizeof ( std::string ); ++index )
+    {
+        fudge_byte * reference;
+        fudge_i32 referencesize;
+        loadFile ( filenames [ index ], reference, referencesize );
+        envelope envelope1 ( codec1.decode ( reference, referencesize ) );
+        delete [] reference;
+
+        TEST_EQUALS_INT( codec1.encodedSize ( envelope1 ), referencesize );
+
+        message message1 ( envelope1.payload ( ) );
+        TEST_EQUALS_INT( message1.encodedSize ( ), referencesize - 8 );
+        TEST_EQUALS_INT( message1.encodedSize ( ), referencesize - 8 );
+    }
+
+    // Build a message up, checking the size is recalculated as it grows
+    message message1, submessage;
+    submessage.addField ( string ( "Submessage text" ), string ( "text" ) );
+    message1.addField ( static_cast<fudge_i32> ( 123456 ), message::noname, 1 );
+    message1.addField ( submessage, string ( "sub" ) );
+
+    std::vector<fudge_byte> buffer;
+    envelope envelope1 ( 0, 0, 0, message1 );
+    TEST_EQUALS_INT( codec1.encode ( envelope1, buffer ), message1.encodedSize ( ) + 8 );
+
+    for ( int count ( 0 ); count < 16; ++count )
+        message1.addField ( submessage );
+
+    buffer.clear ( );
+    TEST_EQUALS_INT( codec1.encode ( envelope1, buffer ), message1.encodedSize ( ) + 8 );
+    TEST_EQUALS_INT( codec1.encodedSize ( envelope1 ), message1.encodedSize ( ) + 8 );
+    TEST_EQUALS_TRUE( message1.encodedSize ( ) > 255 );
+
+    message message2 ( message1 );
+    TEST_EQUALS_INT( message2.encodedSize ( ), message1.encodedSize ( ) );
+
+    // Growing a submessage after it was added changes the size, though the
+    // parent's own field count does not
+    message parent, child;
+    child.addField ( static_cast<fudge_i32> ( 1 ), message::noname, 1 );
+    parent.addField ( child, message::noname, 1 );
+    const fudge_i32 before ( parent.encodedSize ( ) );
+    for ( fudge_i16 ordinal ( 2 ); ordinal < 10; ++ordinal )
+        child.addField ( static_cast<fudge_i32> ( ordinal ), message::noname, ordinal );
+
+    envelope envelope2 ( 0, 0, 0, parent );
+    buffer.clear ( );
+    TEST_EQUALS_INT( codec1.encode ( envelope2, buffer ), parent.encodedSize ( ) + 8 );
+    TEST_EQUALS_INT( codec1.encodedSize ( envelope2 ), parent.encodedSize ( ) + 8 );
+    TEST_EQUALS_TRUE( parent.encodedSize ( ) > before );
+
+    TEST_THROWS_EXCEPTION( codec1.encodedSize ( envelope ( ) ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( ViewAllFiles )
+    using fudge::codec;
+    using fudge::message;
+    using fudge::message_view;
+
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+
+    // Views of the reference files must present the same fields as the
+    // decoded messages
+    codec codec1;
+    for ( size_t index ( 0 ); index < sizeof ( filenames ) / sizeof ( std::string ); ++index )
+    {
+        fudge_byte * reference;
+        fudge_i32 referencesize;
+        loadFile ( filenames [ index ], reference, referencesize );
+
+        message_view view ( codec1.view ( reference, referencesize ) );
+        TEST_EQUALS_INT( view.numbytes ( ), referencesize - 8 );
+        TEST_EQUALS_TRUE( view.bytes ( ) == reference + 8 );
+        TEST_EQUALS_TRUE( viewMatches ( view, codec1.decode ( reference, referencesize ).payload ( ) ) );
+
+        delete [] reference;
+    }
+END_TEST
+
+DEFINE_TEST( ViewAccessors )
+    using fudge::codec;
+    using fudge::field_view;
+    using fudge::message_view;
+    using fudge::string;
+
+    fudge_byte * reference;
+    fudge_i32 referencesize;
+    loadFile ( AllNames_Filename, reference, referencesize );
+
+    codec codec1;
+    message_view view ( codec1.view ( reference, referencesize ) );
+    TEST_EQUALS_INT( view.size ( ), 21 );
+
+    // Lookup by name and index
+    field_view field1 ( view.getField ( string ( "String" ) ) );
+    TEST_EQUALS_TRUE( field1.nameBytes ( ) == "String" );
+    TEST_EQUALS_TRUE( field1.getStringBytes ( ) == "Kirk Wylie" );
+    TEST_EQUALS( field1.getString ( ), string ( "Kirk Wylie" ) );
+    TEST_EQUALS( field1.getAsString ( ), string ( "Kirk Wylie" ) );
+    TEST_EQUALS_TRUE( field1.getStringBytes ( ).data ( ) > reference && field1.getStringBytes ( ).data ( ) < reference + referencesize );
+
+    TEST_EQUALS_INT( view.getFieldAt ( 6 ).getInt32 ( ), 32767 + 5 );
+    TEST_EQUALS_INT( view.getFieldAt ( 6 ).getAsInt64 ( ), 32767 + 5 );
+    TEST_EQUALS_INT( view.getField ( string ( "long" ) ).getInt64 ( ), 2147483647ll + 5ll );
+    TEST_EQUALS_FLOAT( view.getField ( string ( "double" ) ).getAsFloat32 ( ), 0.27362f, 0.00001f );
+
+    // Missing fields and mismatched types
+    TEST_EQUALS_TRUE( ! view.getField ( field1, string ( "missing" ) ) );
+    TEST_EQUALS_TRUE( ! view.getField ( field1, 1 ) );
+    TEST_THROWS_EXCEPTION( view.getField ( string ( "missing" ) ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view.getField ( 1 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view.getFieldAt ( 21 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view.getFieldAt ( 0 ).getInt32 ( ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view.getFieldAt ( 0 ).numelements ( ), fudge::exception );
+
+    // Truncated bytes are only detected once the affected field is reached
+    TEST_THROWS_EXCEPTION( codec1.view ( reference, 7 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( codec1.view ( reference, referencesize - 1 ), fudge::exception );
+    message_view truncated ( reference + 8, referencesize - 9 );
+    TEST_EQUALS_INT( truncated.getFieldAt ( 0 ).getBoolean ( ), true );
+    TEST_THROWS_EXCEPTION( truncated.size ( ), fudge::exception );
+
+    // Empty views have no fields
+    TEST_EQUALS_INT( message_view ( ).size ( ), 0 );
+    TEST_EQUALS_TRUE( ! message_view ( ).getField ( field1, 1 ) );
+
+    delete [] reference;
+END_TEST
+
+DEFINE_TEST( ViewMalformedWidths )
+    using fudge::codec;
+    using fudge::message_view;
+
+    // An int (ordinal 1) with a one byte payload, followed by a short with
+    // a four byte payload; both must be rejected rather than read past
+    const fudge_byte shortInt [ ] = { 0, 0, 0, 0, 0, 0, 0, 14, 48, 4, 0, 1, 1, 127 };
+    const fudge_byte longShort [ ] = { 0, 0, 0, 0, 0, 0, 0, 15, 32, 3, 4, 0, 0, 0, 1 };
+
+    codec codec1;
+    message_view view1 ( codec1.view ( shortInt, sizeof ( shortInt ) ) );
+    TEST_THROWS_EXCEPTION( view1.size ( ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view1.getField ( 1 ).getInt32 ( ), fudge::exception );
+    TEST_THROWS_EXCEPTION( view1.getFieldAt ( 0 ), fudge::exception );
+    FudgeStatus status ( FUDGE_OK );
+    try
+    {
+        view1.getField ( 1 );
+    }
+    catch ( fudge::exception & exception )
+    {
+        status = exception.status ( );
+    }
+    TEST_EQUALS_INT( status, FUDGE_UNKNOWN_FIELD_WIDTH );
+
+    message_view view2 ( codec1.view ( longShort, sizeof ( longShort ) ) );
+    TEST_THROWS_EXCEPTION( view2.getFieldAt ( 0 ).getInt16 ( ), fudge::exception );
+
+    // Validation reports the same frames for the same reason
+    TEST_EQUALS_INT( codec1.validate ( shortInt, sizeof ( shortInt ) ).status ( ), FUDGE_UNKNOWN_FIELD_WIDTH );
+    TEST_EQUALS_INT( codec1.validate ( shortInt, sizeof ( shortInt ) ).offset ( ), 8 );
+    TEST_EQUALS_INT( codec1.validate ( longShort, sizeof ( longShort ) ).status ( ), FUDGE_UNKNOWN_FIELD_WIDTH );
+    TEST_EQUALS_INT( codec1.validate ( longShort, sizeof ( longShort ) ).offset ( ), 8 );
+END_TEST
+
+DEFINE_TEST( DecodeSelected )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::field_selector;
+    using fudge::message;
+    using fudge::string;
+
+    codec codec1;
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+
+    // Selected fields keep their original order
+    loadFile ( AllNames_Filename, bytes, numbytes );
+    field_selector selector1;
+    selector1.add ( string ( "String" ) ).add ( string ( "int" ) ).add ( string ( "missing" ) ).add ( 1 );
+    message message1 ( codec1.decode ( bytes, numbytes, selector1 ).payload ( ) );
+    TEST_EQUALS_INT( message1.size ( ), 2 );
+    TEST_EQUALS( message1.getFieldAt ( 0 ).name ( ).get ( ), string ( "int" ) );
+    TEST_EQUALS_INT( message1.getFieldAt ( 0 ).getInt32 ( ), 32767 + 5 );
+    TEST_EQUALS( message1.getFieldAt ( 1 ).getString ( ), string ( "Kirk Wylie" ) );
+
+    // An empty selector gives an empty message
+    TEST_EQUALS_INT( codec1.decode ( bytes, numbytes, field_selector ( ) ).payload ( ).size ( ), 0 );
+    TEST_THROWS_EXCEPTION( codec1.decode ( bytes, numbytes - 1, selector1 ), fudge::exception );
+    delete [] bytes;
+
+    // Selection by ordinal
+    loadFile ( AllOrdinals_Filename, bytes, numbytes );
+    field_selector selector2;
+    selector2.add ( 3 ).add ( string ( "3" ) );
+    message1 = codec1.decode ( bytes, numbytes, selector2 ).payload ( );
+    TEST_EQUALS_INT( message1.size ( ), 1 );
+    TEST_EQUALS_INT( message1.getField ( 3 ).getByte ( ), 5 );
+    delete [] bytes;
+
+    // Nested selections only include the selected submessage fields
+    loadFile ( SubMsg_Filename, bytes, numbytes );
+    field_selector selector3;
+    selector3.select ( string ( "sub1" ) ).add ( 827 );
+    selector3.add ( string ( "sub2" ) );
+    message1 = codec1.decode ( bytes, numbytes, selector3 ).payload ( );
+    TEST_EQUALS_INT( message1.size ( ), 2 );
+    message message2 ( message1.getField ( string ( "sub1" ) ).getMessage ( ) );
+    TEST_EQUALS_INT( message2.size ( ), 1 );
+    TEST_EQUALS( message2.getField ( 827 ).getString ( ), string ( "Blibble" ) );
+    TEST_EQUALS_INT( message ( message1.getField ( string ( "sub2" ) ).getMessage ( ) ).size ( ), 2 );
+
+    // The most recent of add and select applies
+    selector3.add ( string ( "sub1" ) );
+    message1 = codec1.decode ( bytes, numbytes, selector3 ).payload ( );
+    TEST_EQUALS_INT( message ( message1.getField ( string ( "sub1" ) ).getMessage ( ) ).size ( ), 2 );
+    delete [] bytes;
+
+    // User types are still decoded by Fudge-C
+    loadFile ( Unknown_Filename, bytes, numbytes );
+    field_selector selector4;
+    selector4.add ( string ( "unknown" ) );
+    message1 = codec1.decode ( bytes, numbytes, selector4 ).payload ( );
+    TEST_EQUALS_INT( message1.size ( ), 1 );
+    TEST_EQUALS_INT( message1.getFieldAt ( 0 ).type ( ), 200 );
+    TEST_EQUALS_INT( message1.getFieldAt ( 0 ).numbytes ( ), 10 );
+    delete [] bytes;
+
+    // Projecting a large submessage down shrinks the width of its length;
+    // the envelope header is preserved
+    message source, submessage;
+    for ( int count ( 0 ); count < 64; ++count )
+        submessage.addField ( static_cast<fudge_i32> ( count ), message::noname, static_cast<fudge_i16> ( count ) );
+    source.addField ( submessage, string ( "sub" ), 1 );
+    source.addField ( string ( "trailer" ), string ( "trailer" ) );
+
+    std::vector<fudge_byte> encoded;
+    codec1.encode ( envelope ( 1, 2, 3, source ), encoded );
+    TEST_EQUALS_TRUE( submessage.encodedSize ( ) > 255 );
+
+    field_selector selector5;
+    selector5.select ( 1 ).add ( 10 ).add ( 63 );
+    selector5.add ( string ( "trailer" ) );
+    envelope envelope1 ( codec1.decode ( &encoded [ 0 ], encoded.size ( ), selector5 ) );
+    TEST_EQUALS_INT( envelope1.directives ( ), 1 );
+    TEST_EQUALS_INT( envelope1.schemaversion ( ), 2 );
+    TEST_EQUALS_INT( envelope1.taxonomy ( ), 3 );
+
+    message1 = envelope1.payload ( );
+    TEST_EQUALS_INT( message1.size ( ), 2 );
+    message2 = message1.getField ( string ( "sub" ) ).getMessage ( );
+    TEST_EQUALS_INT( message2.size ( ), 2 );
+    TEST_EQUALS_INT( message2.getField ( 10 ).getAsInt32 ( ), 10 );
+    TEST_EQUALS_INT( message2.getField ( 63 ).getAsInt32 ( ), 63 );
+    TEST_EQUALS( message1.getField ( string ( "trailer" ) ).getString ( ), string ( "trailer" ) );
+END_TEST
+
+DEFINE_TEST( Validate )
+    using fudge::codec;
+    using fudge::validation;
+
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+
+    // All of the reference files are valid, but not when truncated
+    codec codec1;
+    for ( size_t index ( 0 ); index < sizeof ( filenames ) / sizeof ( std::string ); ++index )
+    {
+        fudge_byte * bytes;
+        fudge_i32 numbytes;
+        loadFile ( filenames [ index ], bytes, numbytes );
+
+        TEST_EQUALS_TRUE( codec1.validate ( bytes, numbytes ).valid ( ) );
+
+        validation result ( codec1.validate ( bytes, numbytes - 1 ) );
+        TEST_EQUALS_INT( result.status ( ), FUDGE_OUT_OF_BYTES );
+        TEST_EQUALS_INT( result.offset ( ), 4 );
+
+        // Shrink the envelope size so the last field is cut short
+        bytes [ 7 ] -= 1;
+        result = codec1.validate ( bytes, numbytes );
+        TEST_EQUALS_INT( result.status ( ), FUDGE_OUT_OF_BYTES );
+        TEST_EQUALS_TRUE( result.offset ( ) >= 8 && result.offset ( ) < numbytes );
+
+        delete [] bytes;
+    }
+
+    // Nesting is limited
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+    loadFile ( Deeper_Filename, bytes, numbytes );
+    TEST_EQUALS_INT( codec1.validate ( bytes, numbytes, 1 ).status ( ), FUDGE_OUT_OF_MEMORY );
+    delete [] bytes;
+    loadFile ( SubMsg_Filename, bytes, numbytes );
+    TEST_EQUALS_TRUE( codec1.validate ( bytes, numbytes, 1 ).valid ( ) );
+    TEST_EQUALS_INT( codec1.validate ( bytes, numbytes, 0 ).status ( ), FUDGE_OUT_OF_MEMORY );
+    TEST_EQUALS_INT( codec1.validate ( bytes, numbytes, 0 ).offset ( ), 8 );
+    delete [] bytes;
+
+    // Header problems
+    TEST_EQUALS_INT( codec1.validate ( 0, 0 ).status ( ), FUDGE_NULL_POINTER );
+    const fudge_byte tooShort [ ] = { 0, 0, 0, 0, 0, 0, 0, 7 };
+    TEST_EQUALS_INT( codec1.validate ( tooShort, 7 ).status ( ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_INT( codec1.validate ( tooShort, 8 ).status ( ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_INT( codec1.validate ( tooShort, 8 ).offset ( ), 4 );
+
+    // A fixed width user type has no known width, and an int must be four
+    // bytes wide
+    const fudge_byte goodWidths [ ] = { 0, 0, 0, 0, 0, 0, 0, 14, -128, 4, 0, 0, 0, 1 };
+    TEST_EQUALS_TRUE( codec1.validate ( goodWidths, 14 ).valid ( ) );
+    const fudge_byte unknownWidth [ ] = { 0, 0, 0, 0, 0, 0, 0, 16, -128, 4, 0, 0, 0, 1, -128, -56 };
+    TEST_EQUALS_INT( codec1.validate ( unknownWidth, 16 ).status ( ), FUDGE_UNKNOWN_FIELD_WIDTH );
+    TEST_EQUALS_INT( codec1.validate ( unknownWidth, 16 ).offset ( ), 14 );
+    const fudge_byte shortInt [ ] = { 0, 0, 0, 0, 0, 0, 0, 13, 32, 4, 2, 0, 0 };
+    TEST_EQUALS_INT( codec1.validate ( shortInt, 13 ).status ( ), FUDGE_UNKNOWN_FIELD_WIDTH );
+    TEST_EQUALS_INT( codec1.validate ( shortInt, 13 ).offset ( ), 8 );
+
+    // A submessage field cannot extend beyond its parent, even if there are
+    // enough bytes in the envelope
+    const fudge_byte overrun [ ] = { 0, 0, 0, 0, 0, 0, 0, 26, 32, 15, 6, -128, 2, 1, 32, 15, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    TEST_EQUALS_INT( codec1.validate ( overrun, 26 ).status ( ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_INT( codec1.validate ( overrun, 26 ).offset ( ), 14 );
+END_TEST
+
+DEFINE_TEST( PeekHeader )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::envelope_header;
+    using fudge::message;
+
+    message message1;
+    message1.addField ( static_cast<fudge_i32> ( 1234567 ), message::noname, 1 );
+
+    codec codec1;
+    std::vector<fudge_byte> buffer;
+    codec1.encode ( envelope ( 3, 4, 12345, message1 ), buffer );
+
+    // Only the header needs to be present
+    const envelope_header header ( codec1.peekHeader ( &buffer [ 0 ], 8 ) );
+    TEST_EQUALS_INT( header.directives ( ), 3 );
+    TEST_EQUALS_INT( header.schemaversion ( ), 4 );
+    TEST_EQUALS_INT( header.taxonomy ( ), 12345 );
+    TEST_EQUALS_INT( header.size ( ), buffer.size ( ) );
+
+    // The header matches the decoded envelope
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+    loadFile ( AllNames_Filename, bytes, numbytes );
+    envelope envelope1 ( codec1.decode ( bytes, numbytes ) );
+    TEST_EQUALS_INT( codec1.peekHeader ( bytes, numbytes ).directives ( ), envelope1.directives ( ) );
+    TEST_EQUALS_INT( codec1.peekHeader ( bytes, numbytes ).schemaversion ( ), envelope1.schemaversion ( ) );
+    TEST_EQUALS_INT( codec1.peekHeader ( bytes, numbytes ).taxonomy ( ), envelope1.taxonomy ( ) );
+    TEST_EQUALS_INT( codec1.peekHeader ( bytes, numbytes ).size ( ), numbytes );
+    delete [] bytes;
+
+    TEST_THROWS_EXCEPTION( codec1.peekHeader ( &buffer [ 0 ], 7 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( codec1.peekHeader ( 0, 8 ), fudge::exception );
+    buffer [ 7 ] = 7;
+    TEST_THROWS_EXCEPTION( codec1.peekHeader ( &buffer [ 0 ], 8 ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( TryDecode )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::envelope_header;
+    using fudge::message;
+
+    message message1;
+    message1.addField ( static_cast<fudge_i32> ( 1234567 ), message::noname, 1 );
+
+    codec codec1;
+    std::vector<fudge_byte> buffer;
+    codec1.encode ( envelope ( 3, 4, 12345, message1 ), buffer );
+
+    envelope envelope1;
+    TEST_EQUALS_INT( codec1.tryDecode ( envelope1, &buffer [ 0 ], buffer.size ( ) ), FUDGE_OK );
+    TEST_EQUALS_INT( envelope1.taxonomy ( ), 12345 );
+    TEST_EQUALS_INT( envelope1.payload ( ).getField ( static_cast<fudge_i16> ( 1 ) ).getAsInt32 ( ), 1234567 );
+
+    envelope_header header;
+    TEST_EQUALS_INT( codec1.tryPeekHeader ( header, &buffer [ 0 ], 8 ), FUDGE_OK );
+    TEST_EQUALS_INT( header.size ( ), buffer.size ( ) );
+
+    fudge::message_view view;
+    TEST_EQUALS_INT( codec1.tryView ( view, &buffer [ 0 ], buffer.size ( ) ), FUDGE_OK );
+    TEST_EQUALS_INT( view.size ( ), 1 );
+
+    // Failures are reported without changing the targets
+    const FudgeMsgEnvelope raw ( envelope1.raw ( ) );
+    TEST_EQUALS_INT( codec1.tryDecode ( envelope1, &buffer [ 0 ], 7 ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_TRUE( envelope1.raw ( ) == raw );
+    TEST_EQUALS_INT( codec1.tryPeekHeader ( header, 0, 8 ), FUDGE_NULL_POINTER );
+    TEST_EQUALS_INT( codec1.tryPeekHeader ( header, &buffer [ 0 ], 7 ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_INT( codec1.tryView ( view, &buffer [ 0 ], buffer.size ( ) - 1 ), FUDGE_OUT_OF_BYTES );
+    TEST_EQUALS_INT( header.size ( ), buffer.size ( ) );
+    TEST_EQUALS_INT( view.size ( ), 1 );
+END_TEST
+
+DEFINE_TEST( EncodeBatch )
+    using fudge::codec;
+    using fudge::envelope;
+
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+    const size_t numfiles ( sizeof ( filenames ) / sizeof ( std::string ) );
+
+    // Batch up every reference file twice, including the unknown types file
+    // that only Fudge-C can encode
+    codec codec1;
+    std::vector<envelope> envelopes;
+    std::vector<std::vector<fudge_byte> > references;
+    for ( size_t index ( 0 ); index < numfiles * 2; ++index )
+    {
+        fudge_byte * reference;
+        fudge_i32 referencesize;
+        loadFile ( filenames [ index % numfiles ], reference, referencesize );
+        envelopes.push_back ( codec1.decode ( reference, referencesize ) );
+        references.push_back ( std::vector<fudge_byte> ( reference, reference + referencesize ) );
+        delete [] reference;
+    }
+
+    // The batch is appended to the buffer and offsets
+    std::vector<fudge_byte> buffer ( 3, 0 );
+    std::vector<size_t> offsets ( 1, 0 );
+    const size_t numbytes ( codec1.encodeBatch ( envelopes, buffer, offsets ) );
+    TEST_EQUALS_INT( numbytes, buffer.size ( ) - 3 );
+    TEST_EQUALS_INT( offsets.size ( ), envelopes.size ( ) + 1 );
+
+    for ( size_t index ( 0 ); index < envelopes.size ( ); ++index )
+    {
+        const size_t offset ( offsets [ index + 1 ] );
+        const size_t size ( ( index + 2 < offsets.size ( ) ? offsets [ index + 2 ] : buffer.size ( ) ) - offset );
+        TEST_EQUALS_MEMORY( &buffer [ offset ], size, &references [ index ] [ 0 ], references [ index ].size ( ) );
+        TEST_EQUALS_INT( codec1.decode ( &buffer [ offset ], size ).payload ( ).size ( ), envelopes [ index ].payload ( ).size ( ) );
+    }
+
+    // Empty batches add nothing
+    TEST_EQUALS_INT( codec1.encodeBatch ( std::vector<envelope> ( ), buffer, offsets ), 0 );
+    TEST_EQUALS_INT( offsets.size ( ), envelopes.size ( ) + 1 );
+    TEST_THROWS_EXCEPTION( codec1.encodeBatch ( 0, 1, buffer, offsets ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( EncodeGather )
+    using fudge::codec;
+    using fudge::envelope;
+    using fudge::gather_list;
+    using fudge::message;
+    using fudge::string;
+
+    const std::string filenames [ ] = { AllNames_Filename, FixedWidth_Filename, AllOrdinals_Filename, SubMsg_Filename,
+                                        Unknown_Filename, VariableWidth_Filename, DateTimes_Filename, Deeper_Filename };
+
+    // Whatever the threshold, the segments must hold the reference bytes
+    codec codec1;
+    gather_list list;
+    for ( size_t index ( 0 ); index < sizeof ( filenames ) / sizeof ( std::string ); ++index )
+    {
+        fudge_byte * reference;
+        fudge_i32 referencesize;
+        loadFile ( filenames [ index ], reference, referencesize );
+        envelope envelope1 ( codec1.decode ( reference, referencesize ) );
+
+        const size_t thresholds [ ] = { 0, 1, 16, codec::DefaultGatherThreshold };
+        for ( size_t threshold ( 0 ); threshold < sizeof ( thresholds ) / sizeof ( size_t ); ++threshold )
+        {
+            list.clear ( );
+            TEST_EQUALS_INT( codec1.encode ( envelope1, list, thresholds [ threshold ] ), referencesize );
+            TEST_EQUALS_INT( list.numbytes ( ), referencesize );
+
+            std::vector<fudge_byte> flattened;
+            list.flatten ( flattened );
+            TEST_EQUALS_MEMORY( &flattened [ 0 ], flattened.size ( ), reference, referencesize );
+        }
+        delete [] reference;
+    }
+
+    // Large byte arrays and strings are referenced, not copied
+    message message1, submessage;
+    const std::vector<fudge_byte> bytes ( 20000, 7 );
+    submessage.addField ( bytes, string ( "bytes" ) );
+    submessage.addField ( static_cast<fudge_i32> ( 1 ), string ( "small" ) );
+    message1.addField ( submessage, string ( "sub" ) );
+    message1.addField ( string ( std::string ( 5000, 'x' ).c_str ( ) ), string ( "text" ) );
+    message1.addField ( static_cast<fudge_i32> ( 2 ), string ( "trailer" ) );
+
+    envelope envelope1 ( 0, 0, 0, message1 );
+    std::vector<fudge_byte> expected;
+    codec1.encode ( envelope1, expected );
+
+    list.clear ( );
+    TEST_EQUALS_INT( codec1.encode ( envelope1, list ), expected.size ( ) );
+    TEST_EQUALS_INT( list.count ( ), 5 );
+    const fudge::field bytesfield ( message ( message1.getField ( string ( "sub" ) ).getMessage ( ) ).getField ( string ( "bytes" ) ) );
+    TEST_EQUALS_TRUE( list.segments ( ) [ 1 ].iov_base == bytesfield.bytes ( ) );
+    TEST_EQUALS_INT( list.segments ( ) [ 1 ].iov_len, 20000 );
+    TEST_EQUALS_INT( list.segments ( ) [ 3 ].iov_len, 5000 );
+
+    std::vector<fudge_byte> flattened;
+    list.flatten ( flattened );
+    TEST_EQUALS_VECTOR( flattened, expected );
+
+    // Lists append, so several envelopes can be written at once
+    TEST_EQUALS_INT( codec1.encode ( envelope1, list ), expected.size ( ) );
+    TEST_EQUALS_INT( list.numbytes ( ), expected.size ( ) * 2 );
+    TEST_EQUALS_INT( list.count ( ), 9 );
+    list.clear ( );
+    TEST_EQUALS_INT( list.count ( ), 0 );
+    TEST_EQUALS_TRUE( ! list.segments ( ) );
+END_TEST
+
 DEFINE_TEST_SUITE( Codec )
     // Interop decode test files
     REGISTER_TEST( DecodeAllNames )
@@ -822,6 +1427,18 @@ DEFINE_TEST_SUITE( Codec )
 
     // Other encode tests
     REGISTER_TEST( EncodeDeepTree );
+    REGISTER_TEST( EncodeInPlace )
+    REGISTER_TEST( EncodeWide )
+    REGISTER_TEST( EncodedSize )
+    REGISTER_TEST( ViewAllFiles )
+    REGISTER_TEST( ViewAccessors )
+    REGISTER_TEST( ViewMalformedWidths )
+    REGISTER_TEST( DecodeSelected )
+    REGISTER_TEST( Validate )
+    REGISTER_TEST( PeekHeader )
+    REGISTER_TEST( TryDecode )
+    REGISTER_TEST( EncodeBatch )
+    REGISTER_TEST( EncodeGather )
 END_TEST_SUITE
 
 namespace
@@ -883,5 +1500,93 @@ namespace
         delete [] bytes;
         return decoded.payload ( );
     }
+
+    template<class Type> bool arraysMatch ( const fudge::field_view & view, const fudge::field & field )
+    {
+        std::vector<Type> viewarray, fieldarray;
+        view.getArray ( viewarray );
+        field.getArray ( fieldarray );
+        return viewarray == fieldarray;
+    }
+
+    // Coerces both fields to strings with Fudge-C, which sees arrays in host
+    // order; the results (or failures) must be the same
+    bool coercionsMatch ( const fudge::field_view & view, const fudge::field & field )
+    {
+        fudge::string viewstring, fieldstring;
+        FudgeStatus viewstatus ( FUDGE_OK ), fieldstatus ( FUDGE_OK );
+        try
+        {
+            viewstring = view.getAsString ( );
+        }
+        catch ( const fudge::exception & exception )
+        {
+            viewstatus = exception.status ( );
+        }
+        try
+        {
+            fieldstring = field.getAsString ( );
+        }
+        catch ( const fudge::exception & exception )
+        {
+            fieldstatus = exception.status ( );
+        }
+        return viewstatus == fieldstatus && ( viewstatus != FUDGE_OK || viewstring == fieldstring );
+    }
+
+    bool viewMatches ( const fudge::message_view & view, const fudge::message & message )
+    {
+        std::vector<fudge::field_view> viewfields;
+        std::vector<fudge::field> fields;
+        view.getFields ( viewfields );
+        message.getFields ( fields );
+        if ( viewfields.size ( ) != fields.size ( ) || view.size ( ) != message.size ( ) )
+            return false;
+
+        for ( size_t index ( 0 ); index < fields.size ( ); ++index )
+        {
+            const fudge::field_view & left ( viewfields [ index ] );
+            const fudge::field & right ( fields [ index ] );
+
+            if ( left.type ( ) != right.type ( ) || left.hasName ( ) != right.name ( ) || static_cast<bool> ( left.ordinal ( ) ) != static_cast<bool> ( right.ordinal ( ) ) )
+                return false;
+            if ( left.ordinal ( ) && left.ordinal ( ).get ( ) != right.ordinal ( ).get ( ) )
+                return false;
+            if ( left.hasName ( ) && ! ( left.name ( ).get ( ) == right.name ( ).get ( ) ) )
+                return false;
+
+            bool matches;
+            switch ( right.type ( ) )
+            {
+                case FUDGE_TYPE_INDICATOR:      matches = true; break;
+                case FUDGE_TYPE_BOOLEAN:        matches = left.getBoolean ( ) == right.getBoolean ( ); break;
+                case FUDGE_TYPE_BYTE:           matches = left.getByte ( ) == right.getByte ( ); break;
+                case FUDGE_TYPE_SHORT:          matches = left.getInt16 ( ) == right.getInt16 ( ); break;
+                case FUDGE_TYPE_INT:            matches = left.getInt32 ( ) == right.getInt32 ( ); break;
+                case FUDGE_TYPE_LONG:           matches = left.getInt64 ( ) == right.getInt64 ( ); break;
+                case FUDGE_TYPE_FLOAT:          matches = left.getFloat32 ( ) == right.getFloat32 ( ); break;
+                case FUDGE_TYPE_DOUBLE:         matches = left.getFloat64 ( ) == right.getFloat64 ( ); break;
+                case FUDGE_TYPE_STRING:         matches = left.getString ( ) == right.getString ( ); break;
+                case FUDGE_TYPE_DATE:           matches = left.getDate ( ) == right.getDate ( ); break;
+                case FUDGE_TYPE_TIME:           matches = left.getTime ( ) == right.getTime ( ); break;
+                case FUDGE_TYPE_DATETIME:       matches = static_cast<fudge::date> ( left.getDateTime ( ) ) == right.getDateTime ( ) &&
+                                                          static_cast<fudge::time> ( left.getDateTime ( ) ) == right.getDateTime ( ); break;
+                case FUDGE_TYPE_BYTE_ARRAY:     matches = arraysMatch<fudge_byte> ( left, right ); break;
+                case FUDGE_TYPE_SHORT_ARRAY:    matches = arraysMatch<fudge_i16> ( left, right ); break;
+                case FUDGE_TYPE_INT_ARRAY:      matches = arraysMatch<fudge_i32> ( left, right ); break;
+                case FUDGE_TYPE_LONG_ARRAY:     matches = arraysMatch<fudge_i64> ( left, right ); break;
+                case FUDGE_TYPE_FLOAT_ARRAY:    matches = arraysMatch<fudge_f32> ( left, right ); break;
+                case FUDGE_TYPE_DOUBLE_ARRAY:   matches = arraysMatch<fudge_f64> ( left, right ); break;
+                case FUDGE_TYPE_FUDGE_MSG:      matches = viewMatches ( left.getMessage ( ), fudge::message ( right.getMessage ( ) ) ); break;
+                default:                        matches = left.numbytes ( ) == right.numbytes ( ) &&
+                                                          ! memcmp ( left.bytes ( ), right.bytes ( ), left.numbytes ( ) ); break;
+            }
+            if ( ! matches )
+                return false;
+            if ( right.type ( ) != FUDGE_TYPE_FUDGE_MSG && ! coercionsMatch ( left, right ) )
+                return false;
+        }
+        return true;
+    }
 }
 
@@ -0,0 +1,264 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "encodehelper.hpp"
+#include "fudge-cpp/layout.hpp"
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+namespace
+{
+    struct quote
+    {
+        fudge_i64 id;
+        fudge_f64 bid;
+        fudge_f64 ask;
+        bool firm;
+        fudge::string symbol;
+        fudge::datetime stamp;
+        std::vector<fudge_i32> sizes;
+    };
+
+    struct quote_fields
+    {
+        FUDGE_CPP_LAYOUT_FIELD( quote, fudge_i64, id, 1 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, fudge_f64, bid, 2 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, fudge_f64, ask, 3 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, bool, firm, 4 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, fudge::string, symbol, 5 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, fudge::datetime, stamp, 6 );
+        FUDGE_CPP_LAYOUT_FIELD( quote, std::vector<fudge_i32>, sizes, 7 );
+    };
+
+    typedef fudge::layout<quote_fields::id,
+                          quote_fields::bid,
+                          quote_fields::ask,
+                          quote_fields::firm,
+                          quote_fields::symbol,
+                          quote_fields::stamp,
+                          quote_fields::sizes> quote_layout;
+
+    // The prices alone, listed as an entry of a larger layout
+    typedef fudge::layout<quote_fields::bid, quote_fields::ask> price_layout;
+    typedef fudge::layout<quote_fields::id, price_layout> nested_layout;
+
+    quote createQuote ( );
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+    // Work for one thread in the concurrent encode test: encodes quotes with
+    // a builder and in to a message of its own, and compares them with the
+    // expected bytes
+    struct encoder
+    {
+        const std::vector<fudge_byte> * expected;
+        size_t iterations;
+        size_t failures;
+    };
+
+    void * encoderMain ( void * arg );
+#endif
+}
+
+DEFINE_TEST( EncodeAndDecode )
+    using fudge::message;
+    using fudge::string;
+
+    const quote source ( createQuote ( ) );
+    message encoded;
+    quote_layout::encode ( source, encoded );
+    TEST_EQUALS_INT( encoded.size ( ), 7 );
+
+    // The fields are named after the members, in the order listed
+    TEST_EQUALS_TRUE( *encoded.getFieldAt ( 0 ).name ( ) == string ( "id" ) );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 0 ).ordinal ( ), 1 );
+    TEST_EQUALS_INT( encoded.getFieldAt ( 0 ).getAsInt64 ( ), 9876543210LL );
+    TEST_EQUALS_TRUE( *encoded.getFieldAt ( 4 ).name ( ) == string ( "symbol" ) );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 6 ).ordinal ( ), 7 );
+
+    quote target;
+    quote_layout::decode ( encoded, target );
+    TEST_EQUALS_INT( target.id, source.id );
+    TEST_EQUALS_FLOAT( target.bid, source.bid, 0.0 );
+    TEST_EQUALS_FLOAT( target.ask, source.ask, 0.0 );
+    TEST_EQUALS_TRUE( target.firm );
+    TEST_EQUALS_TRUE( target.symbol == source.symbol );
+    TEST_EQUALS_TRUE( static_cast<const fudge::date &> ( target.stamp ) == source.stamp );
+    TEST_EQUALS_TRUE( static_cast<const fudge::time &> ( target.stamp ) == source.stamp );
+    TEST_EQUALS_VECTOR( target.sizes, source.sizes );
+
+    // Encoding through a builder produces the same bytes
+    fudge::message_builder builder;
+    quote_layout::encode ( source, builder );
+    std::vector<fudge_byte> bytes;
+    builder.encode ( bytes );
+    const std::vector<fudge_byte> expected ( encodeMessage ( encoded ) );
+    TEST_EQUALS_MEMORY( &( bytes [ 0 ] ), bytes.size ( ), &( expected [ 0 ] ), expected.size ( ) );
+END_TEST
+
+DEFINE_TEST( DecodeByOrdinal )
+    using fudge::message;
+    using fudge::string;
+
+    // Fields are matched on ordinal alone: names are ignored, as are fields
+    // with unknown or no ordinals, and absent members are left untouched
+    message source;
+    source.addField ( static_cast<fudge_f64> ( 1.5 ), string ( "ask" ), 2 );
+    source.addField ( static_cast<fudge_i32> ( 17 ), string ( "id" ), 99 );
+    source.addField ( static_cast<fudge_i32> ( 18 ), string ( "id" ) );
+    source.addField ( static_cast<fudge_i32> ( 19 ), message::noname, 1 );
+
+    quote target ( createQuote ( ) );
+    quote_layout::decode ( source, target );
+    TEST_EQUALS_INT( target.id, 19 );
+    TEST_EQUALS_FLOAT( target.bid, 1.5, 0.0 );
+    TEST_EQUALS_FLOAT( target.ask, 101.25, 0.0 );
+    TEST_EQUALS_TRUE( target.symbol == string ( "FUDG" ) );
+
+    // Fields of the wrong type throw
+    message wrong;
+    wrong.addField ( string ( "text" ), message::noname, 6 );
+    TEST_THROWS_EXCEPTION( quote_layout::decode ( wrong, target ), fudge::exception );
+END_TEST
+
+DEFINE_TEST( NestedLayouts )
+    using fudge::message;
+
+    const quote source ( createQuote ( ) );
+    message encoded;
+    nested_layout::encode ( source, encoded );
+    TEST_EQUALS_INT( encoded.size ( ), 3 );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 2 ).ordinal ( ), 3 );
+
+    quote target;
+    target.id = 0;
+    target.bid = target.ask = 0.0;
+    nested_layout::decode ( encoded, target );
+    TEST_EQUALS_INT( target.id, source.id );
+    TEST_EQUALS_FLOAT( target.bid, source.bid, 0.0 );
+    TEST_EQUALS_FLOAT( target.ask, source.ask, 0.0 );
+END_TEST
+
+DEFINE_TEST( FixedSize )
+    // Fixed width members count their header, name and value; the
+    // others count nothing
+    TEST_EQUALS_INT( quote_fields::id::FixedSize, 5 + 2 + 8 );
+    TEST_EQUALS_INT( quote_fields::firm::FixedSize, 5 + 4 + 1 );
+    TEST_EQUALS_INT( quote_fields::symbol::FixedSize, 0 );
+    TEST_EQUALS_INT( quote_fields::stamp::FixedSize, 5 + 5 + 12 );
+    TEST_EQUALS_INT( price_layout::FixedSize, 16 + 16 );
+    TEST_EQUALS_INT( nested_layout::FixedSize, 15 + 32 );
+    TEST_EQUALS_INT( quote_layout::FixedSize, 15 + 32 + 10 + 22 );
+
+    // Which bounds the fixed width part of the encoding
+    quote source ( createQuote ( ) );
+    fudge::message_builder builder;
+    price_layout::encode ( source, builder );
+    TEST_EQUALS_INT( builder.encodedSize ( ), price_layout::FixedSize );
+    builder.reset ( );
+    nested_layout::encode ( source, builder );
+    TEST_EQUALS_TRUE( builder.encodedSize ( ) <= nested_layout::FixedSize );
+END_TEST
+
+DEFINE_TEST( SharedNames )
+    using fudge::field_key;
+    using fudge::string;
+
+    // Entries name their fields with the interned copy of the name
+    TEST_EQUALS_TRUE( quote_fields::id::name ( ).get ( ).raw ( ) == field_key::intern ( string ( "id" ) ).raw ( ) );
+    TEST_EQUALS_TRUE( quote_fields::id::key ( ) == field_key ( "id", 1 ) );
+    TEST_EQUALS_TRUE( &( quote_fields::symbol::name ( ) ) == &( field_key ( "symbol" ).name ( ) ) );
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+    // So builders and messages on many threads can encode with the same
+    // layout at once
+    fudge::message_builder builder;
+    quote_layout::encode ( createQuote ( ), builder );
+    std::vector<fudge_byte> expected;
+    builder.encode ( expected );
+
+    static const size_t NumThreads = 8;
+    encoder encoders [ NumThreads ];
+    pthread_t threads [ NumThreads ];
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        encoders [ index ].expected = &expected;
+        encoders [ index ].iterations = 5000;
+        encoders [ index ].failures = 0;
+        TEST_EQUALS_INT( pthread_create ( &( threads [ index ] ), 0, &encoderMain, &( encoders [ index ] ) ), 0 );
+    }
+
+    size_t failures ( 0 );
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        pthread_join ( threads [ index ], 0 );
+        failures += encoders [ index ].failures;
+    }
+    TEST_EQUALS_INT( failures, 0 );
+    TEST_EQUALS_TRUE( quote_fields::symbol::name ( ).get ( ) == string ( "symbol" ) );
+#endif
+END_TEST
+
+DEFINE_TEST_SUITE( Layout )
+    REGISTER_TEST( EncodeAndDecode )
+    REGISTER_TEST( DecodeByOrdinal )
+    REGISTER_TEST( NestedLayouts )
+    REGISTER_TEST( FixedSize )
+    REGISTER_TEST( SharedNames )
+END_TEST_SUITE
+
+namespace
+{
+    quote createQuote ( )
+    {
+        quote value;
+        value.id = 9876543210LL;
+        value.bid = 100.75;
+        value.ask = 101.25;
+        value.firm = true;
+        value.symbol = fudge::string ( "FUDG" );
+        value.stamp = fudge::datetime ( 2011, 3, 4, 45015, 0, FUDGE_DATETIME_PRECISION_SECOND );
+        value.sizes.push_back ( 100 );
+        value.sizes.push_back ( 250000 );
+        return value;
+    }
+#ifdef FUDGE_HAVE_PTHREAD_H
+    void * encoderMain ( void * arg )
+    {
+        encoder & user ( *static_cast<encoder *> ( arg ) );
+        const quote source ( createQuote ( ) );
+        fudge::message_builder builder;
+        std::vector<fudge_byte> bytes;
+        for ( size_t iteration ( 0 ); iteration < user.iterations; ++iteration )
+        {
+            builder.reset ( );
+            bytes.clear ( );
+            quote_layout::encode ( source, builder );
+            builder.encode ( bytes );
+            if ( bytes != *user.expected )
+                ++user.failures;
+
+            fudge::message encoded;
+            quote_layout::encode ( source, encoded );
+            if ( encodeMessage ( encoded ) != *user.expected )
+                ++user.failures;
+        }
+        return 0;
+    }
+#endif
+}
+
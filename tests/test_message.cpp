@@ -14,8 +14,50 @@
  * limitations under the License.
  */
 #include "simpletest.hpp"
+#include "fudge-cpp/envelope.hpp"
 #include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/fieldindex.hpp"
 #include "fudge-cpp/message.hpp"
+#include <iterator>
+#include <sstream>
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // Sums the integer fields it's given, for testing forEachField
+    struct summer
+    {
+        summer ( ) : count ( 0 ), total ( 0 ) { }
+
+        void operator() ( const fudge::field & field )
+        {
+            ++count;
+            total += field.getAsInt64 ( );
+        }
+
+        size_t count;
+        fudge_i64 total;
+    };
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+    // Work for one thread in the concurrent key test: makes, copies and
+    // looks up keys for names shared with the other threads, and adds
+    // fields with them to a message of its own
+    struct keyuser
+    {
+        const fudge::message * source;
+        FudgeString price;
+        FudgeString size;
+        size_t iterations;
+        size_t failures;
+    };
+
+    void * keyUserMain ( void * arg );
+#endif
+}
 
 DEFINE_TEST( FieldFunctions )
     using fudge::date;
@@ -434,9 +476,591 @@ DEFINE_TEST( FieldCoercion )
     TEST_THROWS_NOTHING( stringval = fields [ 12 ].getAsString ( ) );   TEST_EQUALS_TRUE( stringval == string ( "This is a string" ) );
 END_TEST
 
+DEFINE_TEST( FieldBuffers )
+    using fudge::exception;
+    using fudge::field;
+    using fudge::field_buffer;
+    using fudge::message;
+    using fudge::string;
+
+    message message1;
+
+    // Fill a buffer in place and hand it to the message
+    field_buffer doubles ( 6 * sizeof ( fudge_f64 ) );
+    TEST_EQUALS_INT( doubles.count<fudge_f64> ( ), 6 );
+    for ( size_t index ( 0 ); index < doubles.count<fudge_f64> ( ); ++index )
+        doubles.elements<fudge_f64> ( ) [ index ] = index * 1.5;
+    const fudge_byte * storage ( doubles.data ( ) );
+
+    TEST_THROWS_NOTHING( message1.addFieldBuffer ( FUDGE_TYPE_DOUBLE_ARRAY, doubles, string ( "Doubles" ) ) );
+    TEST_EQUALS_TRUE( doubles.empty ( ) );
+    TEST_EQUALS_TRUE( doubles.data ( ) == 0 );
+
+    field_buffer bytes ( 4 );
+    for ( size_t index ( 0 ); index < bytes.size ( ); ++index )
+        bytes.data ( ) [ index ] = static_cast<fudge_byte> ( 0xf0 + index );
+    TEST_THROWS_NOTHING( message1.addFieldBuffer ( FUDGE_TYPE_BYTE_ARRAY_4, bytes, message::noname, 4 ) );
+
+    field_buffer empty;
+    TEST_THROWS_NOTHING( message1.addFieldBuffer ( FUDGE_TYPE_BYTE_ARRAY, empty, string ( "Empty" ) ) );
+    TEST_EQUALS_INT( message1.size ( ), 3 );
+
+    // The field refers to the buffer's storage rather than to a copy of it
+    field doublesfield ( message1.getField ( string ( "Doubles" ) ) );
+    TEST_EQUALS_INT( doublesfield.type ( ), FUDGE_TYPE_DOUBLE_ARRAY );
+    TEST_EQUALS_INT( doublesfield.numbytes ( ), 6 * sizeof ( fudge_f64 ) );
+    TEST_EQUALS_TRUE( doublesfield.bytes ( ) == storage );
+
+    std::vector<fudge_f64> doublesarray;
+    TEST_EQUALS_INT( doublesfield.getArray ( doublesarray ), 6 );
+    for ( size_t index ( 0 ); index < doublesarray.size ( ); ++index )
+        TEST_EQUALS_FLOAT( doublesarray [ index ], index * 1.5, 0.0001 );
+
+    static const fudge_byte expectedBytes [ 4 ] = { 0xf0, 0xf1, 0xf2, 0xf3 };
+    field bytesfield ( message1.getField ( static_cast<fudge_i16> ( 4 ) ) );
+    TEST_EQUALS_INT( bytesfield.type ( ), FUDGE_TYPE_BYTE_ARRAY_4 );
+    TEST_EQUALS_MEMORY( bytesfield.bytes ( ), bytesfield.numbytes ( ), expectedBytes, sizeof ( expectedBytes ) );
+    TEST_EQUALS_INT( message1.getField ( string ( "Empty" ) ).numbytes ( ), 0 );
+
+    // Only types held as a block of bytes are allowed, and sizes must match
+    // the type; a rejected buffer keeps its storage
+    field_buffer invalid ( 8 );
+    TEST_THROWS_EXCEPTION( message1.addFieldBuffer ( FUDGE_TYPE_DOUBLE, invalid ), exception );
+    TEST_THROWS_EXCEPTION( message1.addFieldBuffer ( FUDGE_TYPE_STRING, invalid ), exception );
+    TEST_THROWS_EXCEPTION( message1.addFieldBuffer ( FUDGE_TYPE_BYTE_ARRAY_4, invalid ), exception );
+    invalid.allocate ( 6 );
+    TEST_THROWS_EXCEPTION( message1.addFieldBuffer ( FUDGE_TYPE_INT_ARRAY, invalid ), exception );
+    TEST_EQUALS_INT( invalid.size ( ), 6 );
+    TEST_EQUALS_INT( message1.size ( ), 3 );
+
+    // User types are opaque, so any size is accepted
+    TEST_THROWS_NOTHING( message1.addFieldBuffer ( 200, invalid, string ( "User" ) ) );
+    TEST_EQUALS_TRUE( invalid.empty ( ) );
+    TEST_EQUALS_INT( message1.getField ( string ( "User" ) ).numbytes ( ), 6 );
+END_TEST
+
+DEFINE_TEST( FieldViews )
+    using fudge::array_view;
+    using fudge::exception;
+    using fudge::field;
+    using fudge::message;
+    using fudge::slice;
+    using fudge::string;
+
+    static const fudge_i32 rawIntsArray [ 5 ] = { 1, -1, 65536, -2147483647, 2147483647 };
+    static const fudge_f64 rawDoublesArray [ 3 ] = { 0.5, -1024.25, 1e100 };
+    static const fudge_byte rawBytesArray [ 8 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+
+    message message1;
+    message1.addField ( std::vector<fudge_i32> ( rawIntsArray, rawIntsArray + 5 ), string ( "Ints" ) );
+    message1.addField ( std::vector<fudge_f64> ( rawDoublesArray, rawDoublesArray + 3 ), string ( "Doubles" ) );
+    message1.addField ( std::vector<fudge_f64> ( ), string ( "Empty" ) );
+    message1.addField8ByteArray ( rawBytesArray, string ( "Bytes" ) );
+    message1.addField ( string ( "A string value" ), string ( "String" ) );
+
+    // Views refer to the field data held by the message
+    field ints ( message1.getField ( string ( "Ints" ) ) );
+    array_view<fudge_i32> intsview;
+    TEST_THROWS_NOTHING( intsview = ints.arrayView<fudge_i32> ( ) );
+    TEST_EQUALS_INT( intsview.size ( ), 5 );
+    TEST_EQUALS_TRUE( reinterpret_cast<const fudge_byte *> ( intsview.data ( ) ) == ints.bytes ( ) );
+    TEST_EQUALS_MEMORY( intsview.data ( ), sizeof ( rawIntsArray ), rawIntsArray, sizeof ( rawIntsArray ) );
+    TEST_EQUALS_INT( intsview [ 2 ], 65536 );
+    TEST_EQUALS_INT( intsview.end ( ) - intsview.begin ( ), 5 );
+
+    array_view<fudge_f64> doublesview ( message1.getField ( string ( "Doubles" ) ).arrayView<fudge_f64> ( ) );
+    TEST_EQUALS_INT( doublesview.size ( ), 3 );
+    TEST_EQUALS_FLOAT( doublesview [ 1 ], -1024.25, 0.0001 );
+    TEST_EQUALS_TRUE( message1.getField ( string ( "Empty" ) ).arrayView<fudge_f64> ( ).empty ( ) );
+
+    // Any byte array can be viewed as bytes
+    array_view<fudge_byte> bytesview ( message1.getField ( string ( "Bytes" ) ).arrayView<fudge_byte> ( ) );
+    TEST_EQUALS_MEMORY( bytesview.data ( ), bytesview.size ( ), rawBytesArray, sizeof ( rawBytesArray ) );
+
+    slice stringview ( message1.getField ( string ( "String" ) ).stringView ( ) );
+    TEST_EQUALS_TRUE( stringview == "A string value" );
+
+    // The element type must match the array type
+    TEST_THROWS_EXCEPTION( ints.arrayView<fudge_i64> ( ), exception );
+    TEST_THROWS_EXCEPTION( ints.arrayView<fudge_byte> ( ), exception );
+    TEST_THROWS_EXCEPTION( ints.stringView ( ), exception );
+    TEST_THROWS_EXCEPTION( message1.getField ( string ( "String" ) ).arrayView<fudge_byte> ( ), exception );
+END_TEST
+
+DEFINE_TEST( FieldKeys )
+    using fudge::exception;
+    using fudge::field;
+    using fudge::field_key;
+    using fudge::message;
+    using fudge::string;
+
+    // Keys for the same name share one interned string
+    const field_key price ( "price" ), size ( string ( "size" ) ), bid ( "bid", 2 ), ordinal ( static_cast<fudge_i16> ( 7 ) );
+    const field_key price2 ( string ( "price" ) );
+    TEST_EQUALS_TRUE( price.name ( ).get ( ).raw ( ) == price2.name ( ).get ( ).raw ( ) );
+    TEST_EQUALS_TRUE( price.hash ( ) == price2.hash ( ) );
+    TEST_EQUALS_TRUE( price == price2 );
+    TEST_EQUALS_TRUE( price != size );
+    TEST_EQUALS_TRUE( price != field_key ( "price", 1 ) );
+    TEST_EQUALS_TRUE( field_key::intern ( string ( "size" ) ).raw ( ) == size.name ( ).get ( ).raw ( ) );
+    TEST_EQUALS_TRUE( ! ordinal.name ( ) );
+    TEST_EQUALS_INT( ordinal.hash ( ), 0 );
+    TEST_THROWS_EXCEPTION( field_key ( static_cast<const char *> ( 0 ) ), exception );
+
+    // Keys work with any type of value
+    message message1;
+    message1.addField ( static_cast<fudge_f64> ( 101.5 ), price );
+    message1.addField ( static_cast<fudge_i32> ( 1000 ), size );
+    message1.addField ( string ( "Best" ), bid );
+    message1.addField ( std::vector<fudge_i16> ( 3, 1 ), ordinal );
+    message1.addField ( static_cast<fudge_f64> ( 99.0 ), string ( "other" ) );
+    TEST_EQUALS_INT( message1.size ( ), 5 );
+
+    TEST_EQUALS_FLOAT( message1.getField ( price ).getFloat64 ( ), 101.5, 0.0001 );
+    TEST_EQUALS_INT( message1.getField ( size ).getAsInt32 ( ), 1000 );
+    TEST_EQUALS_TRUE( message1.getField ( bid ).getString ( ) == string ( "Best" ) );
+    TEST_EQUALS_INT( message1.getField ( ordinal ).numelements ( ), 3 );
+
+    // Fields added without a key are found by comparing their names
+    field target;
+    TEST_EQUALS_TRUE( message1.getField ( target, field_key ( "other" ) ) );
+    TEST_EQUALS_FLOAT( target.getFloat64 ( ), 99.0, 0.0001 );
+    TEST_EQUALS_TRUE( message1.getField ( target, string ( "price" ) ) );
+    TEST_EQUALS_FLOAT( target.getFloat64 ( ), 101.5, 0.0001 );
+
+    TEST_EQUALS_TRUE( ! message1.getField ( target, field_key ( "missing" ) ) );
+    TEST_EQUALS_TRUE( ! message1.getField ( target, field_key ( static_cast<fudge_i16> ( 8 ) ) ) );
+    TEST_THROWS_EXCEPTION( message1.getField ( field_key ( "missing" ) ), exception );
+
+    // Larger messages are searched by Fudge-C
+    message message2;
+    for ( int index ( 0 ); index < 40; ++index )
+        message2.addField ( static_cast<fudge_i32> ( index ), size );
+    message2.addField ( static_cast<fudge_f64> ( 1.25 ), price );
+    TEST_EQUALS_FLOAT( message2.getField ( price ).getFloat64 ( ), 1.25, 0.0001 );
+    TEST_EQUALS_TRUE( ! message2.getField ( target, field_key ( "missing" ) ) );
+END_TEST
+
+DEFINE_TEST( FieldKeysThreaded )
+#ifdef FUDGE_HAVE_PTHREAD_H
+    using fudge::field_key;
+    using fudge::message;
+    using fudge::string;
+
+    const field_key price ( "price" );
+    message message1;
+    message1.addField ( static_cast<fudge_f64> ( 101.5 ), price );
+    message1.addField ( static_cast<fudge_i32> ( 1000 ), field_key ( "size" ) );
+
+    static const size_t NumThreads = 8;
+    keyuser users [ NumThreads ];
+    pthread_t threads [ NumThreads ];
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        users [ index ].source = &message1;
+        users [ index ].price = price.rawName ( );
+        users [ index ].size = field_key ( "size" ).rawName ( );
+        users [ index ].iterations = 20000;
+        users [ index ].failures = 0;
+        TEST_EQUALS_INT( pthread_create ( &( threads [ index ] ), 0, &keyUserMain, &( users [ index ] ) ), 0 );
+    }
+
+    size_t failures ( 0 );
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        pthread_join ( threads [ index ], 0 );
+        failures += users [ index ].failures;
+    }
+    TEST_EQUALS_INT( failures, 0 );
+
+    // The interned names are untouched
+    TEST_EQUALS_TRUE( field_key ( "price" ).rawName ( ) == price.rawName ( ) );
+    TEST_EQUALS_TRUE( price.name ( ).get ( ) == string ( "price" ) );
+    TEST_EQUALS_FLOAT( message1.getField ( price ).getFloat64 ( ), 101.5, 0.0001 );
+#endif
+END_TEST
+
+DEFINE_TEST( FieldIndex )
+    using fudge::exception;
+    using fudge::field;
+    using fudge::field_index;
+    using fudge::field_key;
+    using fudge::message;
+    using fudge::string;
+
+    // A wide message, with every name and ordinal used twice
+    message message1;
+    for ( int pass ( 0 ); pass < 2; ++pass )
+    {
+        for ( int index ( 0 ); index < 1000; ++index )
+        {
+            std::ostringstream name;
+            name << "field" << index;
+            message1.addField ( static_cast<fudge_i32> ( pass * 1000 + index ), string ( name.str ( ) ), static_cast<fudge_i16> ( index ) );
+        }
+    }
+    message1.addField ( static_cast<fudge_i32> ( -1 ), string ( "unnumbered" ) );
+    message1.addField ( static_cast<fudge_i32> ( -2 ), message::noname, static_cast<fudge_i16> ( -5 ) );
+
+    // The first field with a name or ordinal is found
+    field target;
+    TEST_EQUALS_INT( message1.getField ( string ( "field0" ) ).getAsInt32 ( ), 0 );
+    TEST_EQUALS_INT( message1.getField ( string ( "field999" ) ).getAsInt32 ( ), 999 );
+    TEST_EQUALS_INT( message1.getField ( static_cast<fudge_i16> ( 512 ) ).getAsInt32 ( ), 512 );
+    TEST_EQUALS_INT( message1.getField ( static_cast<fudge_i16> ( -5 ) ).getAsInt32 ( ), -2 );
+    TEST_EQUALS_INT( message1.getField ( field_key ( "field321" ) ).getAsInt32 ( ), 321 );
+    TEST_EQUALS_INT( message1.getField ( field_key ( "unnumbered" ) ).getAsInt32 ( ), -1 );
+    TEST_EQUALS_TRUE( ! message1.getField ( target, string ( "field1000" ) ) );
+    TEST_EQUALS_TRUE( ! message1.getField ( target, static_cast<fudge_i16> ( 1000 ) ) );
+    TEST_EQUALS_TRUE( ! message1.getField ( target, field_key ( "missing" ) ) );
+    TEST_THROWS_EXCEPTION( message1.getField ( string ( "missing" ) ), exception );
+
+    // An index finds the same fields
+    field_index index ( message1 );
+    TEST_EQUALS_TRUE( index.valid ( ) );
+    TEST_EQUALS_INT( index.size ( ), 2002 );
+    TEST_EQUALS_TRUE( index.find ( target, string ( "field7" ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), 7 );
+    TEST_EQUALS_TRUE( index.find ( target, string ( "field999" ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), 999 );
+    TEST_EQUALS_TRUE( index.find ( target, static_cast<fudge_i16> ( -5 ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), -2 );
+    TEST_EQUALS_TRUE( index.find ( target, field_key ( "unnumbered" ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), -1 );
+    TEST_EQUALS_TRUE( ! index.find ( target, string ( "field1000" ) ) );
+
+    // The message itself sees fields added later without any index
+    message1.addField ( static_cast<fudge_i32> ( 5000 ), string ( "late" ), static_cast<fudge_i16> ( 5000 ) );
+    TEST_EQUALS_INT( message1.getField ( string ( "late" ) ).getAsInt32 ( ), 5000 );
+    TEST_EQUALS_INT( message1.getField ( static_cast<fudge_i16> ( 5000 ) ).getAsInt32 ( ), 5000 );
+    TEST_EQUALS_INT( message1.getField ( field_key ( "late" ) ).getAsInt32 ( ), 5000 );
+
+    // The separate index reports when it's out of date
+    TEST_EQUALS_TRUE( ! index.valid ( ) );
+    TEST_THROWS_NOTHING( index.refresh ( ) );
+    TEST_EQUALS_INT( index.size ( ), 2003 );
+
+    message1.addField ( static_cast<fudge_i32> ( 6000 ), string ( "later" ) );
+    TEST_EQUALS_TRUE( ! index.valid ( ) );
+    TEST_THROWS_EXCEPTION( index.find ( target, string ( "later" ) ), exception );
+    TEST_THROWS_NOTHING( index.refresh ( ) );
+    TEST_EQUALS_TRUE( index.valid ( ) );
+    TEST_EQUALS_TRUE( index.find ( target, field_key ( "later" ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), 6000 );
+    TEST_EQUALS_TRUE( index.find ( target, field_key ( "ignored", 44 ) ) );
+    TEST_EQUALS_INT( target.getAsInt32 ( ), 44 );
+
+    // Empty messages index nothing
+    field_index empty ( ( message ( ) ) );
+    TEST_EQUALS_INT( empty.size ( ), 0 );
+    TEST_EQUALS_TRUE( ! empty.find ( target, string ( "field0" ) ) );
+    TEST_EQUALS_TRUE( ! empty.find ( target, static_cast<fudge_i16> ( 0 ) ) );
+END_TEST
+
+DEFINE_TEST( FieldIteration )
+    using fudge::field;
+    using fudge::message;
+    using fudge::string;
+
+    message message1;
+    TEST_EQUALS_TRUE( message1.begin ( ) == message1.end ( ) );
+    TEST_EQUALS_INT( message1.forEachField ( summer ( ) ).count, 0 );
+
+    for ( fudge_i32 index ( 0 ); index < 10; ++index )
+        message1.addField ( index * 3, message::noname, static_cast<fudge_i16> ( index ) );
+
+    // Iterators walk the fields in order
+    fudge_i16 expected ( 0 );
+    for ( message::const_iterator it ( message1.begin ( ) ); it != message1.end ( ); ++it, ++expected )
+    {
+        TEST_EQUALS_INT( it->ordinal ( ).get ( ), expected );
+        TEST_EQUALS_INT( ( *it ).getAsInt32 ( ), expected * 3 );
+    }
+    TEST_EQUALS_INT( expected, 10 );
+
+    summer small ( message1.forEachField ( summer ( ) ) );
+    TEST_EQUALS_INT( small.count, 10 );
+    TEST_EQUALS_INT( small.total, 135 );
+
+    // Added fields are seen by later passes, and iterators taken before
+    // they were added remain usable
+    message::const_iterator tenth ( message1.begin ( ) );
+    std::advance ( tenth, 9 );
+    const message::const_iterator oldend ( message1.end ( ) );
+    message1.addField ( static_cast<fudge_i32> ( 1000 ), string ( "last" ) );
+    TEST_EQUALS_INT( std::distance ( message1.begin ( ), message1.end ( ) ), 11 );
+    TEST_EQUALS_INT( tenth->getAsInt32 ( ), 27 );
+    TEST_EQUALS_TRUE( ++tenth == oldend );
+    TEST_EQUALS_TRUE( tenth->name ( ).get ( ) == string ( "last" ) );
+    TEST_EQUALS_TRUE( ++tenth == message1.end ( ) );
+
+    // Wider messages than forEachField visits locally
+    for ( fudge_i32 index ( 0 ); index < 100; ++index )
+        message1.addField ( index );
+    summer wide ( message1.forEachField ( summer ( ) ) );
+    TEST_EQUALS_INT( wide.count, 111 );
+    TEST_EQUALS_INT( wide.total, 135 + 1000 + 4950 );
+
+    std::vector<field> fields;
+    message1.getFields ( fields );
+    TEST_EQUALS_INT( fields.size ( ), 111 );
+    size_t position ( 0 );
+    for ( message::const_iterator it ( message1.begin ( ) ); it != message1.end ( ); ++it, ++position )
+        TEST_EQUALS_INT( it->getAsInt64 ( ), fields [ position ].getAsInt64 ( ) );
+    TEST_EQUALS_INT( position, 111 );
+
+    // Copies of an iterator share its snapshot, which outlives the original
+    message::const_iterator copy;
+    {
+        message::const_iterator original ( message1.begin ( ) );
+        std::advance ( original, 10 );
+        copy = original;
+    }
+    TEST_EQUALS_TRUE( copy->name ( ).get ( ) == string ( "last" ) );
+    TEST_EQUALS_INT( std::distance ( copy, message1.end ( ) ), 101 );
+
+    // Copies see the same fields
+    message message2 ( message1 );
+    TEST_EQUALS_INT( std::distance ( message2.begin ( ), message2.end ( ) ), 111 );
+    message2 = message ( );
+    TEST_EQUALS_TRUE( message2.begin ( ) == message2.end ( ) );
+END_TEST
+
+DEFINE_TEST( SwapAndMove )
+    using fudge::envelope;
+    using fudge::message;
+    using fudge::string;
+
+    message message1, message2;
+    message1.addField ( static_cast<fudge_i32> ( 1 ), string ( "one" ) );
+    for ( fudge_i32 index ( 0 ); index < 40; ++index )
+        message2.addField ( index, string ( "two" ) );
+    TEST_EQUALS_INT( message2.getField ( string ( "two" ) ).getAsInt32 ( ), 0 );
+
+    const FudgeMsg raw1 ( message1.raw ( ) ), raw2 ( message2.raw ( ) );
+    TEST_THROWS_NOTHING( swap ( message1, message2 ) );
+    TEST_EQUALS_TRUE( message1.raw ( ) == raw2 );
+    TEST_EQUALS_TRUE( message2.raw ( ) == raw1 );
+    TEST_EQUALS_INT( message1.size ( ), 40 );
+    TEST_EQUALS_INT( std::distance ( message1.begin ( ), message1.end ( ) ), 40 );
+    TEST_EQUALS_INT( message2.getField ( string ( "one" ) ).getAsInt32 ( ), 1 );
+
+    envelope envelope1 ( 0, 0, 1, message1 ), envelope2;
+    const FudgeMsgEnvelope rawenvelope ( envelope1.raw ( ) );
+    TEST_THROWS_NOTHING( envelope2.swap ( envelope1 ) );
+    TEST_EQUALS_TRUE( envelope2.raw ( ) == rawenvelope );
+    TEST_EQUALS_TRUE( envelope1.raw ( ) == 0 );
+    TEST_EQUALS_INT( envelope2.taxonomy ( ), 1 );
+
+#ifdef FUDGE_CPP_HAS_MOVE
+    // Moved from handles can be destroyed or assigned to
+    message moved ( std::move ( message1 ) );
+    TEST_EQUALS_TRUE( moved.raw ( ) == raw2 );
+    TEST_EQUALS_TRUE( message1.raw ( ) == 0 );
+    TEST_EQUALS_INT( moved.getField ( string ( "two" ) ).getAsInt32 ( ), 0 );
+
+    TEST_THROWS_NOTHING( message1 = std::move ( moved ) );
+    TEST_EQUALS_TRUE( message1.raw ( ) == raw2 );
+    TEST_THROWS_NOTHING( moved = message2 );
+    TEST_EQUALS_TRUE( moved.raw ( ) == raw1 );
+
+    envelope movedenvelope ( std::move ( envelope2 ) );
+    TEST_EQUALS_TRUE( movedenvelope.raw ( ) == rawenvelope );
+    TEST_EQUALS_TRUE( envelope2.raw ( ) == 0 );
+    TEST_THROWS_NOTHING( envelope2 = std::move ( movedenvelope ) );
+    TEST_EQUALS_TRUE( envelope2.raw ( ) == rawenvelope );
+#endif
+END_TEST
+
+DEFINE_TEST( TryGet )
+    using fudge::field;
+    using fudge::field_key;
+    using fudge::message;
+    using fudge::string;
+
+    message message1;
+    message1.addField ( static_cast<fudge_i32> ( 100000 ), string ( "int" ), 1 );
+    message1.addField ( string ( "text" ), string ( "string" ) );
+    message1.addField ( std::vector<fudge_f64> ( 3, 0.5 ), message::noname, 3 );
+
+    // Lookups report missing fields as a status
+    field field1;
+    TEST_EQUALS_INT( message1.tryGetFieldAt ( field1, 0 ), FUDGE_OK );
+    TEST_EQUALS_INT( field1.type ( ), FUDGE_TYPE_INT );
+    TEST_EQUALS_INT( message1.tryGetFieldAt ( field1, 3 ), FUDGE_INVALID_INDEX );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, string ( "string" ) ), FUDGE_OK );
+    TEST_EQUALS_INT( field1.type ( ), FUDGE_TYPE_STRING );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, string ( "missing" ) ), FUDGE_INVALID_NAME );
+    TEST_EQUALS_INT( field1.type ( ), FUDGE_TYPE_STRING );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, static_cast<fudge_i16> ( 3 ) ), FUDGE_OK );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, static_cast<fudge_i16> ( 4 ) ), FUDGE_INVALID_ORDINAL );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, field_key ( "int" ) ), FUDGE_OK );
+    TEST_EQUALS_INT( message1.tryGetField ( field1, field_key ( "other" ) ), FUDGE_INVALID_NAME );
+
+    // Accessors report the wrong type, leaving the target alone
+    TEST_EQUALS_INT( message1.tryGetField ( field1, string ( "int" ) ), FUDGE_OK );
+    fudge_i32 i32 ( -1 );
+    fudge_i16 i16 ( -1 );
+    fudge_f64 f64 ( -1.0 );
+    TEST_EQUALS_INT( field1.tryGetInt32 ( i32 ), FUDGE_OK );
+    TEST_EQUALS_INT( i32, 100000 );
+    TEST_EQUALS_INT( field1.tryGetInt16 ( i16 ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_INT( i16, -1 );
+    TEST_EQUALS_INT( field1.tryGetFloat64 ( f64 ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_INT( field1.tryGetAsFloat64 ( f64 ), FUDGE_OK );
+    TEST_EQUALS_FLOAT( f64, 100000.0, 0.0 );
+    TEST_EQUALS_INT( field1.tryGetAsInt16 ( i16 ), FUDGE_INVALID_TYPE_COERCION );
+    TEST_EQUALS_INT( i16, -1 );
+
+    string text ( "unchanged" );
+    TEST_EQUALS_INT( field1.tryGetString ( text ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_INT( field1.tryGetAsString ( text ), FUDGE_INVALID_TYPE_COERCION );
+    TEST_EQUALS_TRUE( text == string ( "unchanged" ) );
+
+    fudge::date date1;
+    FudgeMsg submessage ( 0 );
+    std::vector<fudge_f64> doubles;
+    TEST_EQUALS_INT( field1.tryGetDate ( date1 ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_INT( field1.tryGetMessage ( submessage ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_TRUE( submessage == 0 );
+    TEST_EQUALS_INT( field1.tryGetArray ( doubles ), FUDGE_INVALID_TYPE_ACCESSOR );
+
+    TEST_EQUALS_INT( message1.tryGetField ( field1, string ( "string" ) ), FUDGE_OK );
+    TEST_EQUALS_INT( field1.tryGetString ( text ), FUDGE_OK );
+    TEST_EQUALS_TRUE( text == string ( "text" ) );
+    text = string ( );
+    TEST_EQUALS_INT( field1.tryGetAsString ( text ), FUDGE_OK );
+    TEST_EQUALS_TRUE( text == string ( "text" ) );
+    TEST_EQUALS_INT( field1.tryGetAsInt32 ( i32 ), FUDGE_INVALID_TYPE_COERCION );
+    TEST_EQUALS_INT( i32, 100000 );
+
+    TEST_EQUALS_INT( message1.tryGetField ( field1, static_cast<fudge_i16> ( 3 ) ), FUDGE_OK );
+    TEST_EQUALS_INT( field1.tryGetArray ( doubles ), FUDGE_OK );
+    TEST_EQUALS_INT( doubles.size ( ), 3 );
+    TEST_EQUALS_FLOAT( doubles [ 2 ], 0.5, 0.0 );
+END_TEST
+
+DEFINE_TEST( TypedAccessors )
+    using fudge::field;
+    using fudge::field_traits;
+    using fudge::message;
+    using fudge::string;
+
+    // Types map to their Fudge types at compile time
+    TEST_EQUALS_INT( field_traits<bool>::id, FUDGE_TYPE_BOOLEAN );
+    TEST_EQUALS_INT( field_traits<fudge_i64>::id, FUDGE_TYPE_LONG );
+    TEST_EQUALS_INT( field_traits<string>::id, FUDGE_TYPE_STRING );
+    TEST_EQUALS_INT( field_traits<fudge::datetime>::id, FUDGE_TYPE_DATETIME );
+    TEST_EQUALS_INT( field_traits<message>::id, FUDGE_TYPE_FUDGE_MSG );
+    TEST_EQUALS_INT( field_traits< std::vector<fudge_i32> >::id, FUDGE_TYPE_INT_ARRAY );
+    TEST_EQUALS_INT( field_traits< std::vector<fudge_f64> >::id, FUDGE_TYPE_DOUBLE_ARRAY );
+
+    message submessage;
+    submessage.addField<bool> ( true, string ( "flag" ) );
+
+    message message1;
+    message1.addField<fudge_f64> ( 2.5, string ( "double" ) );
+    message1.addField<fudge_i16> ( -300, string ( "short" ), 2 );
+    message1.addField<string> ( string ( "text" ), string ( "string" ) );
+    message1.addField< std::vector<fudge_i32> > ( std::vector<fudge_i32> ( 4, 7 ), string ( "array" ) );
+    message1.addField<message> ( submessage, string ( "message" ) );
+    TEST_EQUALS_INT( message1.size ( ), 5 );
+
+    // Exact accessors only read fields of the same type
+    field field1 ( message1.getField ( string ( "double" ) ) );
+    TEST_EQUALS_INT( field1.type ( ), FUDGE_TYPE_DOUBLE );
+    TEST_EQUALS_FLOAT( field1.get<fudge_f64> ( ), 2.5, 0.0 );
+    TEST_EQUALS_FLOAT( field1.get<fudge_f64> ( ), field1.getFloat64 ( ), 0.0 );
+    TEST_THROWS_EXCEPTION( field1.get<fudge_f32> ( ), fudge::exception );
+    TEST_THROWS_EXCEPTION( field1.get<string> ( ), fudge::exception );
+
+    fudge_f32 f32 ( -1.0f );
+    TEST_EQUALS_INT( field1.tryGet<fudge_f32> ( f32 ), FUDGE_INVALID_TYPE_ACCESSOR );
+    TEST_EQUALS_FLOAT( f32, -1.0f, 0.0f );
+    TEST_EQUALS_INT( field1.tryGetAs<fudge_f32> ( f32 ), FUDGE_OK );
+    TEST_EQUALS_FLOAT( f32, 2.5f, 0.0f );
+    TEST_EQUALS_FLOAT( field1.getAs<fudge_f32> ( ), 2.5f, 0.0f );
+
+    // Coercion matches the named getAs methods
+    field1 = message1.getField ( static_cast<fudge_i16> ( 2 ) );
+    TEST_EQUALS_INT( field1.get<fudge_i16> ( ), -300 );
+    TEST_EQUALS_INT( field1.getAs<fudge_i64> ( ), -300 );
+    TEST_EQUALS_FLOAT( field1.getAs<fudge_f64> ( ), -300.0, 0.0 );
+    TEST_EQUALS_INT( field1.getAs<bool> ( ), field1.getAsBoolean ( ) );
+    TEST_THROWS_EXCEPTION( field1.getAs<fudge_byte> ( ), fudge::exception );
+    fudge_byte byte ( 1 );
+    TEST_EQUALS_INT( field1.tryGetAs<fudge_byte> ( byte ), FUDGE_INVALID_TYPE_COERCION );
+    TEST_EQUALS_INT( byte, 1 );
+    TEST_THROWS_EXCEPTION( field1.getAs<fudge::date> ( ), fudge::exception );
+
+    field1 = message1.getField ( string ( "string" ) );
+    TEST_EQUALS_TRUE( field1.get<string> ( ) == string ( "text" ) );
+    TEST_EQUALS_TRUE( field1.getAs<string> ( ) == string ( "text" ) );
+
+    // Arrays are only read as the same element type
+    field1 = message1.getField ( string ( "array" ) );
+    const std::vector<fudge_i32> ints ( field1.getArray<fudge_i32> ( ) );
+    TEST_EQUALS_VECTOR( ints, std::vector<fudge_i32> ( 4, 7 ) );
+    TEST_EQUALS_VECTOR( field1.get< std::vector<fudge_i32> > ( ), ints );
+    TEST_THROWS_EXCEPTION( field1.getArray<fudge_i64> ( ), fudge::exception );
+    std::vector<fudge_i16> shorts;
+    TEST_EQUALS_INT( field1.tryGetAs< std::vector<fudge_i16> > ( shorts ), FUDGE_INVALID_TYPE_COERCION );
+    TEST_EQUALS_INT( shorts.size ( ), 0 );
+
+    field1 = message1.getField ( string ( "message" ) );
+    message message2 ( field1.get<message> ( ) );
+    TEST_EQUALS_INT( message2.size ( ), 1 );
+    TEST_EQUALS_TRUE( message2.getField ( string ( "flag" ) ).get<bool> ( ) );
+    TEST_THROWS_EXCEPTION( field1.getAs<fudge_i32> ( ), fudge::exception );
+END_TEST
+
 DEFINE_TEST_SUITE( Message )
     REGISTER_TEST( FieldFunctions )
     REGISTER_TEST( IntegerFieldDowncasting )
     REGISTER_TEST( FieldCoercion )
+    REGISTER_TEST( FieldBuffers )
+    REGISTER_TEST( FieldViews )
+    REGISTER_TEST( FieldKeys )
+    REGISTER_TEST( FieldKeysThreaded )
+    REGISTER_TEST( FieldIndex )
+    REGISTER_TEST( FieldIteration )
+    REGISTER_TEST( SwapAndMove )
+    REGISTER_TEST( TryGet )
+    REGISTER_TEST( TypedAccessors )
 END_TEST_SUITE
 
+namespace
+{
+#ifdef FUDGE_HAVE_PTHREAD_H
+    void * keyUserMain ( void * arg )
+    {
+        keyuser & user ( *static_cast<keyuser *> ( arg ) );
+        const fudge_byte size [ ] = { 's', 'i', 'z', 'e' };
+        for ( size_t iteration ( 0 ); iteration < user.iterations; ++iteration )
+        {
+            const fudge::field_key price ( "price" ), bid ( "bid", static_cast<fudge_i16> ( iteration % 8 ) );
+            const fudge::field_key copy ( price );
+            fudge::field_key assigned ( bid );
+            assigned = copy;
+
+            fudge::message added;
+            added.addField ( static_cast<fudge_f64> ( 101.5 ), price );
+            added.addField ( static_cast<fudge_i32> ( 1000 ), copy );
+
+            fudge::field target;
+            if ( price.rawName ( ) != user.price ||
+                 added.getFieldAt ( 1 ).name ( ).get ( ).raw ( ) == user.price ||
+                 ! added.getField ( target, price ) ||
+                 target.getFloat64 ( ) != 101.5 ||
+                 ! ( assigned == price ) ||
+                 fudge::field_key::intern ( size, sizeof ( size ) ).raw ( ) != user.size ||
+                 ! user.source->getField ( target, copy ) ||
+                 target.getFloat64 ( ) != 101.5 ||
+                 user.source->getField ( target, bid ) )
+                ++user.failures;
+        }
+        return 0;
+    }
+#endif
+}
+
@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "encodehelper.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/messagebuilder.hpp"
+
+namespace
+{
+    // Adds the same fields, of every kind, to either a message or a builder
+    template<class Target> void addFields ( Target & target, fudge_i32 sequence );
+}
+
+DEFINE_TEST( EncodesLikeMessage )
+    using fudge::message;
+    using fudge::message_builder;
+    using fudge::string;
+
+    message source;
+    message_builder builder;
+    addFields ( source, 123456 );
+    addFields ( builder, 123456 );
+    TEST_EQUALS_INT( builder.size ( ), source.size ( ) );
+    TEST_EQUALS_INT( builder.encodedSize ( ), source.encodedSize ( ) );
+
+    // The builder encodes to exactly the bytes the message does
+    const std::vector<fudge_byte> expected ( encodeMessage ( source ) );
+    std::vector<fudge_byte> encoded ( 3, 0 );
+    TEST_EQUALS_INT( builder.encode ( encoded ), expected.size ( ) );
+    TEST_EQUALS_MEMORY( &( encoded [ 3 ] ), encoded.size ( ) - 3, &( expected [ 0 ] ), expected.size ( ) );
+
+    fudge_byte buffer [ 1024 ];
+    fudge_i32 numbytes;
+    TEST_EQUALS_TRUE( ! builder.encode ( buffer, 8, numbytes ) );
+    TEST_EQUALS_INT( numbytes, expected.size ( ) );
+    TEST_EQUALS_TRUE( builder.encode ( buffer, sizeof ( buffer ), numbytes, 1, 2, 3 ) );
+    TEST_EQUALS_INT( numbytes, expected.size ( ) );
+    TEST_EQUALS_MEMORY( buffer + 4, numbytes - 4, &( expected [ 4 ] ), expected.size ( ) - 4 );
+    const fudge::envelope_header header ( fudge::codec ( ).peekHeader ( buffer, numbytes ) );
+    TEST_EQUALS_INT( header.directives ( ), 1 );
+    TEST_EQUALS_INT( header.schemaversion ( ), 2 );
+    TEST_EQUALS_INT( header.taxonomy ( ), 3 );
+
+    // Integers are shrunk to their smallest type
+    const fudge::message_view view ( builder.view ( ) );
+    TEST_EQUALS_INT( view.size ( ), source.size ( ) );
+    TEST_EQUALS_INT( view.getField ( string ( "small" ) ).type ( ), FUDGE_TYPE_BYTE );
+    TEST_EQUALS_INT( view.getField ( string ( "sequence" ) ).type ( ), FUDGE_TYPE_INT );
+    TEST_EQUALS_INT( view.getField ( string ( "sequence" ) ).getAsInt32 ( ), 123456 );
+
+    // Building decodes a message of its own
+    const message built ( builder.build ( ) );
+    TEST_EQUALS_INT( built.size ( ), source.size ( ) );
+    TEST_EQUALS_INT( built.getField ( string ( "sequence" ) ).getAsInt32 ( ), 123456 );
+    TEST_EQUALS_TRUE( built.getField ( static_cast<fudge_i16> ( 5 ) ).getString ( ) == string ( "Builder" ) );
+END_TEST
+
+DEFINE_TEST( ResetAndReserve )
+    using fudge::message_builder;
+
+    message_builder builder ( 10 );
+    TEST_EQUALS_TRUE( builder.empty ( ) );
+    TEST_EQUALS_INT( builder.encodedSize ( ), 0 );
+    TEST_EQUALS_TRUE( builder.capacity ( ) >= 10 * message_builder::EstimatedFieldSize );
+    builder.reserve ( 10, 4096 );
+    TEST_EQUALS_TRUE( builder.capacity ( ) >= 4096 );
+
+    // Once a message has been built, another of the same shape reuses the
+    // same storage
+    addFields ( builder, 1 );
+    const size_t capacity ( builder.capacity ( ) );
+    const fudge_byte * storage ( builder.view ( ).bytes ( ) );
+    const std::vector<fudge_byte> first ( encodeMessage ( builder.build ( ) ) );
+
+    for ( fudge_i32 sequence ( 2 ); sequence < 10; ++sequence )
+    {
+        builder.reset ( );
+        TEST_EQUALS_INT( builder.size ( ), 0 );
+        TEST_EQUALS_INT( builder.view ( ).size ( ), 0 );
+
+        addFields ( builder, sequence );
+        TEST_EQUALS_INT( builder.capacity ( ), capacity );
+        TEST_EQUALS_TRUE( builder.view ( ).bytes ( ) == storage );
+        TEST_EQUALS_INT( builder.view ( ).getField ( fudge::string ( "sequence" ) ).getAsInt32 ( ), sequence );
+    }
+
+    builder.reset ( );
+    addFields ( builder, 1 );
+    std::vector<fudge_byte> again;
+    builder.encode ( again );
+    TEST_EQUALS_VECTOR( again, first );
+END_TEST
+
+DEFINE_TEST( Submessages )
+    using fudge::message;
+    using fudge::message_builder;
+    using fudge::string;
+
+    message_builder inner;
+    inner.addField ( 1.5, string ( "price" ) );
+    inner.addField ( static_cast<fudge_i64> ( 1 ) << 40, fudge::field_key ( "size" ) );
+
+    message_builder outer;
+    outer.addField ( inner, string ( "quote" ), 1 );
+    outer.addField ( inner.build ( ), string ( "copy" ) );
+    outer.addField ( outer, string ( "self" ) );
+    TEST_EQUALS_INT( outer.size ( ), 3 );
+
+    const fudge::message_view view ( outer.view ( ) );
+    TEST_EQUALS_INT( view.getFieldAt ( 0 ).getMessage ( ).getFieldAt ( 0 ).getFloat64 ( ), 1 );
+    TEST_EQUALS_TRUE( view.getFieldAt ( 0 ).getMessage ( ).getField ( string ( "size" ) ).getAsInt64 ( ) == static_cast<fudge_i64> ( 1 ) << 40 );
+    TEST_EQUALS_INT( view.getFieldAt ( 1 ).getMessage ( ).size ( ), 2 );
+    TEST_EQUALS_INT( view.getFieldAt ( 2 ).getMessage ( ).size ( ), 2 );
+    TEST_EQUALS_INT( view.getFieldAt ( 2 ).getMessage ( ).getFieldAt ( 1 ).getMessage ( ).size ( ), 2 );
+
+    // Bad fields are rejected without changing the builder
+    const std::string longname ( 256, 'x' );
+    const fudge_byte bytes [ 8 ] = { 0 };
+    TEST_THROWS_EXCEPTION( outer.addField ( true, string ( longname ) ), fudge::exception );
+    TEST_THROWS_EXCEPTION( outer.addField ( FUDGE_TYPE_BYTE_ARRAY_4, bytes, 8 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( outer.addField ( FUDGE_TYPE_INT_ARRAY, bytes, 8 ), fudge::exception );
+    TEST_EQUALS_INT( outer.size ( ), 3 );
+    TEST_THROWS_NOTHING( outer.addField ( FUDGE_TYPE_BYTE_ARRAY_8, bytes, 8 ) );
+    TEST_EQUALS_INT( outer.view ( ).getFieldAt ( 3 ).type ( ), FUDGE_TYPE_BYTE_ARRAY_8 );
+END_TEST
+
+DEFINE_TEST_SUITE( MessageBuilder )
+    REGISTER_TEST( EncodesLikeMessage )
+    REGISTER_TEST( ResetAndReserve )
+    REGISTER_TEST( Submessages )
+END_TEST_SUITE
+
+namespace
+{
+    template<class Target> void addFields ( Target & target, fudge_i32 sequence )
+    {
+        using fudge::message;
+        using fudge::string;
+
+        message submessage;
+        submessage.addField ( 2.5, string ( "bid" ) );
+        submessage.addField ( static_cast<fudge_i16> ( 300 ) );
+
+        target.addField ( string ( "indicator" ) );
+        target.addField ( true, message::noname, 1 );
+        target.addField ( static_cast<fudge_byte> ( -3 ), string ( "byte" ) );
+        target.addField ( static_cast<fudge_i16> ( 12 ), string ( "small" ) );
+        target.addField ( sequence, string ( "sequence" ), 2 );
+        target.addField ( static_cast<fudge_i64> ( 1 ) << 33, string ( "large" ) );
+        target.addField ( 1.25f, string ( "float" ) );
+        target.addField ( 3.75, string ( "double" ), 3 );
+        target.addField ( string ( "Builder" ), message::noname, 5 );
+        target.addField ( submessage, string ( "sub" ) );
+        target.addField ( std::vector<fudge_byte> ( 300, 7 ), string ( "bytes" ) );
+        target.addField ( std::vector<fudge_i16> ( 3, -2 ), string ( "shorts" ) );
+        target.addField ( std::vector<fudge_i32> ( 4, 70000 ), string ( "ints" ) );
+        target.addField ( std::vector<fudge_i64> ( 2, -1 ), string ( "longs" ) );
+        target.addField ( std::vector<fudge_f32> ( 5, 0.5f ), string ( "floats" ) );
+        target.addField ( std::vector<fudge_f64> ( 6, 0.25 ), string ( "doubles" ) );
+        target.addField ( fudge::date ( 2010, 3, 21 ), string ( "date" ) );
+        target.addField ( fudge::time ( 3600, 500, FUDGE_DATETIME_PRECISION_NANOSECOND, 4 ), string ( "time" ) );
+        target.addField ( fudge::datetime ( 2011, 12, 1, 60, 0, FUDGE_DATETIME_PRECISION_SECOND ), string ( "datetime" ) );
+    }
+}
+
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "encodehelper.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/messagetemplate.hpp"
+
+namespace
+{
+    const fudge::field_key Ticker ( "ticker", 1 ),
+                           Sequence ( "sequence", 2 ),
+                           Bid ( "bid", 3 ),
+                           Size ( "size", 4 ),
+                           Stamp ( "stamp", 5 );
+
+    fudge::message createQuote ( fudge_i64 sequence, fudge_f64 bid, fudge_i32 size, const fudge::datetime & stamp );
+}
+
+DEFINE_TEST( PatchSlots )
+    using fudge::datetime;
+    using fudge::message_template;
+
+    const datetime first ( 2011, 3, 4, 100, 0, FUDGE_DATETIME_PRECISION_SECOND ),
+                   second ( 2011, 3, 5, 45015, 500, FUDGE_DATETIME_PRECISION_NANOSECOND );
+
+    // The prototype's small integers are stored as bytes, but the slots hold
+    // any value of their type
+    message_template quote ( createQuote ( 1, 99.5, 10, first ), 0, 0, 7 );
+    const size_t sequence ( quote.addSlot ( fudge::field_key ( "sequence" ), FUDGE_TYPE_LONG ) );
+    const size_t bid ( quote.addSlot ( fudge::field_key ( static_cast<fudge_i16> ( 3 ) ), FUDGE_TYPE_DOUBLE ) );
+    const size_t size ( quote.addSlot ( Size, FUDGE_TYPE_INT ) );
+    const size_t stamp ( quote.addSlot ( Stamp, FUDGE_TYPE_DATETIME ) );
+    TEST_EQUALS_INT( quote.slots ( ), 4 );
+    TEST_EQUALS_INT( quote.slotType ( size ), FUDGE_TYPE_INT );
+    TEST_EQUALS_INT( quote.addSlot ( Sequence, FUDGE_TYPE_LONG ), sequence );
+
+    quote.set ( sequence, static_cast<fudge_i64> ( 1234567890123LL ) );
+    quote.set ( bid, 101.25 );
+    quote.set ( size, static_cast<fudge_i32> ( 250000 ) );
+    quote.set ( stamp, second );
+
+    // The patched envelope decodes to the new values
+    const fudge::envelope decoded ( fudge::codec ( ).decode ( quote.bytes ( ), quote.numbytes ( ) ) );
+    TEST_EQUALS_INT( decoded.taxonomy ( ), 7 );
+    const fudge::message payload ( decoded.payload ( ) );
+    TEST_EQUALS_INT( payload.size ( ), 5 );
+    TEST_EQUALS_TRUE( payload.getField ( Ticker ).getString ( ) == fudge::string ( "INSTRUMENT" ) );
+    TEST_EQUALS_INT( payload.getField ( Sequence ).getInt64 ( ), 1234567890123LL );
+    TEST_EQUALS_FLOAT( payload.getField ( Bid ).getFloat64 ( ), 101.25, 0.0 );
+    TEST_EQUALS_INT( payload.getField ( Size ).getInt32 ( ), 250000 );
+    const datetime patched ( payload.getField ( Stamp ).getDateTime ( ) );
+    TEST_EQUALS_TRUE( static_cast<const fudge::date &> ( patched ) == second );
+    TEST_EQUALS_TRUE( static_cast<const fudge::time &> ( patched ) == second );
+
+    // And matches the encoding of a message holding those values at the
+    // same widths
+    const std::vector<fudge_byte> expected ( encodeMessage ( createQuote ( 1234567890123LL, 101.25, 250000, second ), 7 ) );
+    TEST_EQUALS_MEMORY( quote.bytes ( ), quote.numbytes ( ), &( expected [ 0 ] ), expected.size ( ) );
+
+    // Copies are patched independently
+    message_template copy ( quote );
+    copy.set ( size, static_cast<fudge_i32> ( 1 ) );
+    TEST_EQUALS_INT( fudge::codec ( ).decode ( copy.bytes ( ), copy.numbytes ( ) ).payload ( ).getField ( Size ).getInt32 ( ), 1 );
+    TEST_EQUALS_INT( fudge::codec ( ).decode ( quote.bytes ( ), quote.numbytes ( ) ).payload ( ).getField ( Size ).getInt32 ( ), 250000 );
+END_TEST
+
+DEFINE_TEST( SlotErrors )
+    using fudge::field_key;
+    using fudge::message_template;
+
+    message_template quote ( createQuote ( 5000000000LL, 99.5, 10, fudge::datetime ( ) ) );
+
+    // Missing fields, unsupported types and values that don't fit
+    TEST_THROWS_EXCEPTION( quote.addSlot ( field_key ( "missing" ), FUDGE_TYPE_INT ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( field_key ( static_cast<fudge_i16> ( 9 ) ), FUDGE_TYPE_INT ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( Bid, FUDGE_TYPE_FLOAT ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( Ticker, FUDGE_TYPE_INT ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( Sequence, FUDGE_TYPE_INT ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( Size, FUDGE_TYPE_DATETIME ), fudge::exception );
+    TEST_EQUALS_INT( quote.slots ( ), 0 );
+
+    // Slots are only set with values of their own type
+    const size_t size ( quote.addSlot ( Size, FUDGE_TYPE_INT ) );
+    TEST_THROWS_EXCEPTION( quote.addSlot ( Size, FUDGE_TYPE_LONG ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.set ( size, static_cast<fudge_i64> ( 1 ) ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.set ( size, 1.0 ), fudge::exception );
+    TEST_THROWS_EXCEPTION( quote.set ( size + 1, static_cast<fudge_i32> ( 1 ) ), fudge::exception );
+    TEST_THROWS_NOTHING( quote.set ( size, static_cast<fudge_i32> ( -1 ) ) );
+
+    message_template empty;
+    TEST_EQUALS_INT( empty.numbytes ( ), 0 );
+    TEST_THROWS_EXCEPTION( empty.addSlot ( Size, FUDGE_TYPE_INT ), fudge::exception );
+END_TEST
+
+DEFINE_TEST_SUITE( MessageTemplate )
+    REGISTER_TEST( PatchSlots )
+    REGISTER_TEST( SlotErrors )
+END_TEST_SUITE
+
+namespace
+{
+    fudge::message createQuote ( fudge_i64 sequence, fudge_f64 bid, fudge_i32 size, const fudge::datetime & stamp )
+    {
+        fudge::message quote;
+        quote.addField ( fudge::string ( "INSTRUMENT" ), Ticker );
+        quote.addField ( sequence, Sequence );
+        quote.addField ( bid, Bid );
+        quote.addField ( size, Size );
+        quote.addField ( stamp, Stamp );
+        return quote;
+    }
+}
+
@@ -17,6 +17,27 @@
 #include "fudge-cpp/optional.hpp"
 #include "fudge-cpp/string.hpp"
 #include <stdexcept>
+#ifdef FUDGE_CPP_HAS_MOVE
+#include <type_traits>
+#endif
+
+namespace
+{
+    // Counts the instances alive, to check optional constructs and
+    // destroys its value exactly once
+    struct counted
+    {
+        static int instances;
+
+        counted ( int value = 0 ) : value ( value ) { ++instances; }
+        counted ( const counted & source ) : value ( source.value ) { ++instances; }
+        ~counted ( ) { --instances; }
+
+        int value;
+    };
+
+    int counted::instances ( 0 );
+}
 
 DEFINE_TEST( Null )
     using fudge::optional;
@@ -124,9 +145,63 @@ DEFINE_TEST( Object )
     TEST_THROWS_EXCEPTION( string3.get ( ), std::runtime_error );
 END_TEST
 
+DEFINE_TEST( Lifetime )
+    using fudge::optional;
+
+    TEST_EQUALS_INT( counted::instances, 0 );
+    {
+        optional<counted> value1 ( counted ( 1 ) ), value2;
+        TEST_EQUALS_INT( counted::instances, 1 );
+
+        // Copies hold their own value
+        optional<counted> value3 ( value1 );
+        TEST_EQUALS_INT( counted::instances, 2 );
+        value3.get ( ).value = 3;
+        TEST_EQUALS_INT( value1.get ( ).value, 1 );
+
+        TEST_THROWS_NOTHING( value2 = value3 );
+        TEST_EQUALS_INT( counted::instances, 3 );
+        TEST_EQUALS_INT( value2.get ( ).value, 3 );
+
+        TEST_THROWS_NOTHING( value2 = value1 );
+        TEST_EQUALS_INT( counted::instances, 3 );
+        TEST_EQUALS_INT( value2.get ( ).value, 1 );
+
+        TEST_THROWS_NOTHING( value1 = optional<counted> ( ) );
+        TEST_EQUALS_INT( counted::instances, 2 );
+        TEST_EQUALS_TRUE( ! value1 );
+    }
+    TEST_EQUALS_INT( counted::instances, 0 );
+END_TEST
+
+DEFINE_TEST( Trivial )
+    using fudge::optional;
+
+    // Optionals of built in types copy their bytes, set or not
+    optional<fudge_i16> set ( 7 ), unset;
+    optional<fudge_i16> copyset ( set ), copyunset ( unset );
+    TEST_EQUALS_INT( copyset.get ( ), 7 );
+    TEST_EQUALS_TRUE( ! copyunset );
+    copyset = unset;
+    copyunset = set;
+    TEST_EQUALS_TRUE( ! copyset );
+    TEST_EQUALS_INT( copyunset.get ( ), 7 );
+
+    optional<const char *> pointer ( "text" );
+    TEST_EQUALS_TRUE( optional<const char *> ( pointer ).get ( ) == pointer.get ( ) );
+
+#ifdef FUDGE_CPP_HAS_MOVE
+    static_assert ( std::is_trivially_copyable<optional<fudge_i16> >::value, "optional<fudge_i16> must be trivially copyable" );
+    static_assert ( std::is_trivially_copyable<optional<double> >::value, "optional<double> must be trivially copyable" );
+    static_assert ( ! std::is_trivially_copyable<optional<counted> >::value, "optional<counted> must copy its value" );
+#endif
+END_TEST
+
 DEFINE_TEST_SUITE( Optional )
     REGISTER_TEST( Null )
     REGISTER_TEST( Primitive )
     REGISTER_TEST( Object )
+    REGISTER_TEST( Lifetime )
+    REGISTER_TEST( Trivial )
 END_TEST_SUITE
 
@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "encodehelper.hpp"
+#include "fudge-cpp/exception.hpp"
+
+// Generated from quotes.fsd by scripts/fudgeschema.py
+#include "quotes.hpp"
+
+namespace
+{
+    test::quotes::Quote createQuote ( );
+
+    // Decodes the message, returning the status of the exception thrown
+    FudgeStatus decodeStatus ( const fudge::message & source );
+}
+
+DEFINE_TEST( RoundTrip )
+    using fudge::message;
+    using fudge::string;
+    using test::quotes::Quote;
+
+    const Quote source ( createQuote ( ) );
+    message encoded;
+    source.encode ( encoded );
+    TEST_EQUALS_INT( encoded.size ( ), 16 );
+
+    // Fields carry both the schema names and ordinals, counting on from the
+    // last one given; absent optional fields are left out
+    TEST_EQUALS_TRUE( *encoded.getFieldAt ( 0 ).name ( ) == string ( "id" ) );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 0 ).ordinal ( ), 1 );
+    TEST_EQUALS_TRUE( *encoded.getFieldAt ( 4 ).name ( ) == string ( "flags" ) );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 4 ).ordinal ( ), 6 );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 13 ).ordinal ( ), 20 );
+    TEST_EQUALS_INT( *encoded.getFieldAt ( 15 ).ordinal ( ), -1 );
+
+    Quote target;
+    target.decode ( encoded );
+    TEST_EQUALS_INT( target.id, source.id );
+    TEST_EQUALS_TRUE( target.symbol == source.symbol );
+    TEST_EQUALS_FLOAT( target.bid, source.bid, 0.0 );
+    TEST_EQUALS_TRUE( ! target.ask );
+    TEST_EQUALS_TRUE( target.firm );
+    TEST_EQUALS_INT( target.flags, source.flags );
+    TEST_EQUALS_INT( target.lot, source.lot );
+    TEST_EQUALS_INT( target.size, source.size );
+    TEST_EQUALS_FLOAT( target.spread, source.spread, 0.0 );
+    TEST_EQUALS_TRUE( target.traded == source.traded );
+    TEST_EQUALS_TRUE( target.received == source.received );
+    TEST_EQUALS_TRUE( static_cast<const fudge::date &> ( target.stamp ) == source.stamp );
+    TEST_EQUALS_TRUE( static_cast<const fudge::time &> ( target.stamp ) == source.stamp );
+    TEST_EQUALS_VECTOR( target.fills, source.fills );
+    TEST_EQUALS_VECTOR( target.levels, source.levels );
+    TEST_EQUALS_TRUE( target.venue.code == source.venue.code );
+    TEST_EQUALS_TRUE( ! target.venue.name );
+    TEST_EQUALS_TRUE( target.backup );
+    TEST_EQUALS_TRUE( target.backup.get ( ).code == source.backup.get ( ).code );
+    TEST_EQUALS_TRUE( *target.backup.get ( ).name == *source.backup.get ( ).name );
+    TEST_EQUALS_INT( *target.sequence, -42 );
+
+    // Decoding again clears the optional fields that are no longer present
+    Quote reduced ( source );
+    reduced.backup = fudge::optional<test::quotes::Venue> ( );
+    reduced.sequence = fudge::optional<fudge_i32> ( );
+    message smaller;
+    reduced.encode ( smaller );
+    target.decode ( smaller );
+    TEST_EQUALS_TRUE( ! target.backup );
+    TEST_EQUALS_TRUE( ! target.sequence );
+
+    // Encoding through a builder produces the same bytes
+    fudge::message_builder builder;
+    source.encode ( builder );
+    std::vector<fudge_byte> bytes;
+    builder.encode ( bytes );
+    const std::vector<fudge_byte> expected ( encodeMessage ( encoded ) );
+    TEST_EQUALS_MEMORY( &( bytes [ 0 ] ), bytes.size ( ), &( expected [ 0 ] ), expected.size ( ) );
+
+    target = Quote ( );
+    target.decode ( builder.build ( ) );
+    TEST_EQUALS_INT( target.id, source.id );
+    TEST_EQUALS_INT( *target.sequence, -42 );
+END_TEST
+
+DEFINE_TEST( DuplicateOrdinals )
+    using fudge::message;
+    using fudge::string;
+    using test::quotes::Quote;
+
+    // Fields are matched on ordinal alone, so where one appears twice the
+    // last field wins, whatever it is called
+    message encoded;
+    createQuote ( ).encode ( encoded );
+    encoded.addField ( static_cast<fudge_i64> ( 7 ), string ( "other" ), 1 );
+    encoded.addField ( string ( "SECOND" ), message::noname, 2 );
+
+    Quote target;
+    target.decode ( encoded );
+    TEST_EQUALS_INT( target.id, 7 );
+    TEST_EQUALS_TRUE( target.symbol == string ( "SECOND" ) );
+    TEST_EQUALS_INT( target.size, 250000 );
+
+    // Unknown ordinals and fields without one are skipped
+    encoded.addField ( static_cast<fudge_i32> ( 1 ), string ( "size" ) );
+    encoded.addField ( static_cast<fudge_i32> ( 2 ), message::noname, 99 );
+    TEST_THROWS_NOTHING( target.decode ( encoded ) );
+    TEST_EQUALS_INT( target.size, 250000 );
+END_TEST
+
+DEFINE_TEST( MissingRequiredFields )
+    using fudge::message;
+    using fudge::string;
+
+    message source;
+    createQuote ( ).encode ( source );
+    TEST_EQUALS_INT( decodeStatus ( source ), FUDGE_OK );
+
+    // Each required field is needed; optional ones are not
+    message venue;
+    venue.addField ( string ( "XLON" ), string ( "code" ), 1 );
+    TEST_THROWS_NOTHING( test::quotes::Venue ( ).decode ( venue ) );
+    message unnamed;
+    unnamed.addField ( string ( "Backup venue" ), string ( "name" ), 2 );
+    TEST_THROWS_EXCEPTION( test::quotes::Venue ( ).decode ( unnamed ), fudge::exception );
+
+    message partial;
+    partial.addField ( static_cast<fudge_i64> ( 1 ), string ( "id" ), 1 );
+    partial.addField ( string ( "FUDG" ), string ( "symbol" ), 2 );
+    TEST_EQUALS_INT( decodeStatus ( partial ), FUDGE_INVALID_ORDINAL );
+
+    // Including those of submessages
+    message nested;
+    createQuote ( ).encode ( nested );
+    nested.addField ( unnamed, string ( "venue" ), 20 );
+    TEST_EQUALS_INT( decodeStatus ( nested ), FUDGE_INVALID_ORDINAL );
+
+    // Fields of the wrong type throw
+    message wrong;
+    createQuote ( ).encode ( wrong );
+    wrong.addField ( string ( "text" ), message::noname, 1 );
+    TEST_THROWS_EXCEPTION( test::quotes::Quote ( ).decode ( wrong ), fudge::exception );
+END_TEST
+
+DEFINE_TEST_SUITE( Schema )
+    REGISTER_TEST( RoundTrip )
+    REGISTER_TEST( DuplicateOrdinals )
+    REGISTER_TEST( MissingRequiredFields )
+END_TEST_SUITE
+
+namespace
+{
+    test::quotes::Quote createQuote ( )
+    {
+        test::quotes::Quote value;
+        value.id = 9876543210LL;
+        value.symbol = fudge::string ( "FUDG" );
+        value.bid = 101.25;
+        value.firm = true;
+        value.flags = 0x5a;
+        value.lot = 100;
+        value.size = 250000;
+        value.spread = 0.5f;
+        value.traded = fudge::date ( 2011, 3, 4 );
+        value.received = fudge::time ( 45015, 500, FUDGE_DATETIME_PRECISION_MICROSECOND );
+        value.stamp = fudge::datetime ( 2011, 3, 4, 45015, 0, FUDGE_DATETIME_PRECISION_SECOND );
+        value.fills.push_back ( 100 );
+        value.fills.push_back ( 250000 );
+        value.levels.push_back ( 101.25 );
+        value.levels.push_back ( 101.5 );
+        value.venue.code = fudge::string ( "XLON" );
+
+        test::quotes::Venue backup;
+        backup.code = fudge::string ( "XPAR" );
+        backup.name = fudge::string ( "Backup venue" );
+        value.backup = backup;
+        value.sequence = -42;
+        return value;
+    }
+
+    FudgeStatus decodeStatus ( const fudge::message & source )
+    {
+        try
+        {
+            test::quotes::Quote ( ).decode ( source );
+        }
+        catch ( const fudge::exception & exception )
+        {
+            return exception.status ( );
+        }
+        return FUDGE_OK;
+    }
+}
+
@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "fudge-cpp/codec.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/sharedmessage.hpp"
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // A message with a scalar, a string, an array and a submessage
+    fudge::message createMessage ( );
+
+    // Returns true if the view holds the fields createMessage adds
+    bool viewMatches ( const fudge::message_view & view );
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+    // Work for one reader thread in the stress test
+    struct reader
+    {
+        const fudge::shared_message * source;
+        size_t iterations;
+        size_t failures;
+    };
+
+    void * readerMain ( void * arg );
+#endif
+}
+
+DEFINE_TEST( Freeze )
+    using fudge::message;
+    using fudge::shared_message;
+    using fudge::string;
+
+    // Empty messages
+    shared_message empty;
+    TEST_EQUALS_INT( empty.view ( ).size ( ), 0 );
+    TEST_EQUALS_INT( empty.numbytes ( ), 0 );
+    TEST_EQUALS_INT( empty.useCount ( ), 0 );
+    TEST_EQUALS_INT( empty.thaw ( ).size ( ), 0 );
+
+    shared_message emptymessage ( ( message ( ) ) );
+    TEST_EQUALS_INT( emptymessage.view ( ).size ( ), 0 );
+    TEST_EQUALS_INT( emptymessage.numbytes ( ), 8 );
+
+    // The frozen message no longer depends on the source
+    message source ( createMessage ( ) );
+    shared_message frozen ( source );
+    source.addField ( static_cast<fudge_i32> ( 99 ), string ( "late" ) );
+    TEST_EQUALS_INT( frozen.view ( ).size ( ), 4 );
+    TEST_EQUALS_TRUE( viewMatches ( frozen.view ( ) ) );
+
+    // Thawing gives a mutable copy
+    message thawed ( frozen.thaw ( ) );
+    TEST_EQUALS_INT( thawed.size ( ), 4 );
+    TEST_EQUALS_TRUE( thawed.getField ( string ( "name" ) ).getString ( ) == string ( "Frozen" ) );
+    thawed.addField ( static_cast<fudge_i32> ( 1 ) );
+    TEST_EQUALS_INT( frozen.view ( ).size ( ), 4 );
+
+    // The bytes are a complete envelope
+    fudge::envelope decoded ( fudge::codec ( ).decode ( frozen.bytes ( ), frozen.numbytes ( ) ) );
+    TEST_EQUALS_INT( decoded.payload ( ).size ( ), 4 );
+END_TEST
+
+DEFINE_TEST( Sharing )
+    using fudge::shared_message;
+
+    shared_message original ( createMessage ( ) );
+    TEST_EQUALS_INT( original.useCount ( ), 1 );
+    {
+        shared_message copy1 ( original ), copy2;
+        TEST_EQUALS_INT( original.useCount ( ), 2 );
+        TEST_EQUALS_TRUE( copy1.bytes ( ) == original.bytes ( ) );
+
+        copy2 = copy1;
+        TEST_EQUALS_INT( original.useCount ( ), 3 );
+        copy2 = copy2;
+        TEST_EQUALS_INT( original.useCount ( ), 3 );
+
+        shared_message other ( createMessage ( ) );
+        swap ( copy2, other );
+        TEST_EQUALS_INT( original.useCount ( ), 3 );
+        TEST_EQUALS_INT( copy2.useCount ( ), 1 );
+        TEST_EQUALS_TRUE( viewMatches ( other.view ( ) ) );
+
+        copy1 = shared_message ( );
+        TEST_EQUALS_INT( original.useCount ( ), 2 );
+        TEST_EQUALS_INT( copy1.useCount ( ), 0 );
+    }
+    TEST_EQUALS_INT( original.useCount ( ), 1 );
+    TEST_EQUALS_TRUE( viewMatches ( original.view ( ) ) );
+END_TEST
+
+DEFINE_TEST( ConcurrentReaders )
+#ifdef FUDGE_HAVE_PTHREAD_H
+    using fudge::shared_message;
+
+    // Every thread copies and reads the same message as fast as it can
+    const shared_message shared ( createMessage ( ) );
+    static const size_t NumThreads = 8;
+    reader readers [ NumThreads ];
+    pthread_t threads [ NumThreads ];
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        readers [ index ].source = &shared;
+        readers [ index ].iterations = 20000;
+        readers [ index ].failures = 0;
+        TEST_EQUALS_INT( pthread_create ( &( threads [ index ] ), 0, &readerMain, &( readers [ index ] ) ), 0 );
+    }
+
+    size_t failures ( 0 );
+    for ( size_t index ( 0 ); index < NumThreads; ++index )
+    {
+        pthread_join ( threads [ index ], 0 );
+        failures += readers [ index ].failures;
+    }
+
+    TEST_EQUALS_INT( failures, 0 );
+    TEST_EQUALS_INT( shared.useCount ( ), 1 );
+    TEST_EQUALS_TRUE( viewMatches ( shared.view ( ) ) );
+#endif
+END_TEST
+
+DEFINE_TEST_SUITE( SharedMessage )
+    REGISTER_TEST( Freeze )
+    REGISTER_TEST( Sharing )
+    REGISTER_TEST( ConcurrentReaders )
+END_TEST_SUITE
+
+namespace
+{
+    fudge::message createMessage ( )
+    {
+        using fudge::message;
+        using fudge::string;
+
+        message submessage;
+        submessage.addField ( static_cast<fudge_f64> ( 2.5 ), string ( "price" ) );
+
+        message source;
+        source.addField ( static_cast<fudge_i32> ( 123456 ), message::noname, 1 );
+        source.addField ( string ( "Frozen" ), string ( "name" ) );
+        source.addField ( std::vector<fudge_i32> ( 64, 7 ), string ( "array" ) );
+        source.addField ( submessage, string ( "sub" ) );
+        return source;
+    }
+
+    bool viewMatches ( const fudge::message_view & view )
+    {
+        using fudge::field_view;
+
+        try
+        {
+            std::vector<fudge_i32> array;
+            const field_view arrayfield ( view.getFieldAt ( 2 ) );
+            arrayfield.getArray ( array );
+
+            return view.size ( ) == 4 &&
+                   view.getField ( static_cast<fudge_i16> ( 1 ) ).getAsInt32 ( ) == 123456 &&
+                   view.getFieldAt ( 1 ).getStringBytes ( ) == "Frozen" &&
+                   array.size ( ) == 64 && array [ 0 ] == 7 && array [ 63 ] == 7 &&
+                   view.getFieldAt ( 3 ).getMessage ( ).getFieldAt ( 0 ).getFloat64 ( ) == 2.5;
+        }
+        catch ( const fudge::exception & )
+        {
+            return false;
+        }
+    }
+
+#ifdef FUDGE_HAVE_PTHREAD_H
+    void * readerMain ( void * arg )
+    {
+        reader & self ( *static_cast<reader *> ( arg ) );
+        fudge::shared_message held;
+        for ( size_t iteration ( 0 ); iteration < self.iterations; ++iteration )
+        {
+            // Take and drop references while reading through them
+            fudge::shared_message local ( *self.source );
+            held = local;
+            if ( ! viewMatches ( held.view ( ) ) )
+                ++self.failures;
+        }
+        return 0;
+    }
+#endif
+}
+
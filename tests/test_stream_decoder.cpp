@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2010 - 2010, Vrai Stacey.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *     
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "simpletest.hpp"
+#include "fudge-cpp/exception.hpp"
+#include "fudge-cpp/streamdecoder.hpp"
+#include <stdlib.h>
+
+namespace
+{
+    // Builds a stream of three envelopes, each with a distinct taxonomy and
+    // a payload that identifies it.
+    void createStream ( std::vector<fudge_byte> & stream, std::vector<size_t> & sizes );
+
+    // Returns true if the envelope is the one createStream built at index
+    bool isEnvelope ( const fudge::envelope & envelope, fudge_i16 index );
+}
+
+DEFINE_TEST( SingleChunk )
+    using fudge::envelope;
+    using fudge::stream_decoder;
+
+    std::vector<fudge_byte> stream;
+    std::vector<size_t> sizes;
+    createStream ( stream, sizes );
+
+    // Push the entire stream in one go; all three envelopes should be
+    // available immediately
+    stream_decoder decoder;
+    TEST_THROWS_NOTHING( decoder.push ( &stream [ 0 ], stream.size ( ) ) );
+    TEST_EQUALS_INT( decoder.pending ( ), stream.size ( ) );
+
+    envelope envelope1;
+    for ( fudge_i16 index ( 0 ); index < 3; ++index )
+    {
+        TEST_EQUALS_TRUE( decoder.next ( envelope1 ) );
+        TEST_EQUALS_TRUE( isEnvelope ( envelope1, index ) );
+    }
+
+    TEST_EQUALS_TRUE( ! decoder.next ( envelope1 ) );
+    TEST_EQUALS_INT( decoder.pending ( ), 0 );
+END_TEST
+
+DEFINE_TEST( ByteAtATime )
+    using fudge::envelope;
+    using fudge::stream_decoder;
+
+    std::vector<fudge_byte> stream;
+    std::vector<size_t> sizes;
+    createStream ( stream, sizes );
+
+    // Feed the stream a byte at a time, with each byte held in a temporary
+    // that is overwritten once the decoder has been drained; envelopes
+    // should appear as soon as their last byte arrives
+    stream_decoder decoder;
+    envelope envelope1;
+    fudge_i16 decoded ( 0 );
+    size_t boundary ( sizes [ 0 ] );
+    for ( size_t offset ( 0 ); offset < stream.size ( ); ++offset )
+    {
+        fudge_byte byte ( stream [ offset ] );
+        decoder.push ( &byte, 1 );
+
+        if ( offset + 1 == boundary )
+        {
+            TEST_EQUALS_TRUE( decoder.next ( envelope1 ) );
+            TEST_EQUALS_TRUE( isEnvelope ( envelope1, decoded ) );
+            TEST_EQUALS_INT( decoder.pending ( ), 0 );
+            if ( ++decoded < 3 )
+                boundary += sizes [ decoded ];
+        }
+        else
+            TEST_EQUALS_TRUE( ! decoder.next ( envelope1 ) );
+        byte = 0;
+    }
+    TEST_EQUALS_INT( decoded, 3 );
+END_TEST
+
+DEFINE_TEST( UnevenChunks )
+    using fudge::envelope;
+    using fudge::stream_decoder;
+
+    std::vector<fudge_byte> stream;
+    std::vector<size_t> sizes;
+    createStream ( stream, sizes );
+
+    // Split the stream part way through the first header, then across the
+    // boundary between the second and third envelopes
+    const size_t splits [ ] = { 5, sizes [ 0 ] + sizes [ 1 ] + 3, stream.size ( ) };
+
+    stream_decoder decoder;
+    envelope envelope1;
+    fudge_i16 decoded ( 0 );
+    size_t start ( 0 );
+    for ( size_t index ( 0 ); index < 3; ++index )
+    {
+        decoder.push ( &stream [ start ], splits [ index ] - start );
+        while ( decoder.next ( envelope1 ) )
+            TEST_EQUALS_TRUE( isEnvelope ( envelope1, decoded++ ) );
+        start = splits [ index ];
+    }
+    TEST_EQUALS_INT( decoded, 3 );
+    TEST_EQUALS_INT( decoder.pending ( ), 0 );
+
+    // A chunk pushed before the previous one was drained must not lose the
+    // undecoded envelopes
+    decoder.push ( &stream [ 0 ], sizes [ 0 ] + 1 );
+    decoder.push ( &stream [ sizes [ 0 ] + 1 ], stream.size ( ) - sizes [ 0 ] - 1 );
+    for ( decoded = 0; decoder.next ( envelope1 ); ++decoded )
+        TEST_EQUALS_TRUE( isEnvelope ( envelope1, decoded ) );
+    TEST_EQUALS_INT( decoded, 3 );
+
+    // Reset discards partial envelopes
+    decoder.push ( &stream [ 0 ], 10 );
+    TEST_EQUALS_TRUE( ! decoder.next ( envelope1 ) );
+    TEST_EQUALS_INT( decoder.pending ( ), 10 );
+    decoder.reset ( );
+    TEST_EQUALS_INT( decoder.pending ( ), 0 );
+    decoder.push ( &stream [ 0 ], stream.size ( ) );
+    TEST_EQUALS_TRUE( decoder.next ( envelope1 ) );
+    TEST_EQUALS_TRUE( isEnvelope ( envelope1, 0 ) );
+END_TEST
+
+DEFINE_TEST( InvalidStreams )
+    using fudge::envelope;
+    using fudge::exception;
+    using fudge::stream_decoder;
+
+    stream_decoder decoder;
+    envelope envelope1;
+    TEST_THROWS_EXCEPTION( decoder.push ( 0, 10 ), exception );
+    TEST_THROWS_NOTHING( decoder.push ( 0, 0 ) );
+    TEST_EQUALS_TRUE( ! decoder.next ( envelope1 ) );
+
+    // A header claiming to be smaller than itself can never be satisfied
+    const fudge_byte truncated [ ] = { 0, 0, 0, 0, 0, 0, 0, 4 };
+    decoder.push ( truncated, sizeof ( truncated ) );
+    TEST_THROWS_EXCEPTION( decoder.next ( envelope1 ), exception );
+
+    // One claiming to be huge just waits for more bytes, holding only those
+    // that have arrived
+    const fudge_byte huge [ ] = { 0, 0, 0, 0, 0x7f, -1, -1, -1, 1, 2, 3 };
+    decoder.reset ( );
+    for ( size_t index ( 0 ); index < sizeof ( huge ); ++index )
+    {
+        decoder.push ( huge + index, 1 );
+        TEST_EQUALS_TRUE( ! decoder.next ( envelope1 ) );
+    }
+    TEST_EQUALS_INT( decoder.pending ( ), sizeof ( huge ) );
+END_TEST
+
+DEFINE_TEST_SUITE( StreamDecoder )
+    REGISTER_TEST( SingleChunk )
+    REGISTER_TEST( ByteAtATime )
+    REGISTER_TEST( UnevenChunks )
+    REGISTER_TEST( InvalidStreams )
+END_TEST_SUITE
+
+namespace
+{
+    void createStream ( std::vector<fudge_byte> & stream, std::vector<size_t> & sizes )
+    {
+        fudge::codec codec;
+        for ( fudge_i16 index ( 0 ); index < 3; ++index )
+        {
+            // Vary the payload size so the envelopes don't share a length
+            fudge::message message;
+            message.addField ( static_cast<fudge_i32> ( index ), fudge::string ( "index" ) );
+            message.addField ( std::vector<fudge_i32> ( 100 * index, index ), fudge::string ( "padding" ) );
+
+            fudge_byte * bytes;
+            fudge_i32 numbytes;
+            codec.encode ( fudge::envelope ( 0, 0, index, message ), bytes, numbytes );
+            stream.insert ( stream.end ( ), bytes, bytes + numbytes );
+            sizes.push_back ( numbytes );
+            free ( bytes );
+        }
+    }
+
+    bool isEnvelope ( const fudge::envelope & envelope, fudge_i16 index )
+    {
+        if ( envelope.taxonomy ( ) != index )
+            return false;
+
+        fudge::message payload ( envelope.payload ( ) );
+        return payload.size ( ) == 2 &&
+               payload.getField ( fudge::string ( "index" ) ).getAsInt32 ( ) == index &&
+               payload.getField ( fudge::string ( "padding" ) ).numelements ( ) == static_cast<size_t> ( 100 * index );
+    }
+}
+
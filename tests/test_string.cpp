@@ -182,11 +182,63 @@ DEFINE_TEST( Comparison )
     TEST_EQUALS_TRUE( utf16Truncated != utf16String );
 END_TEST
 
+DEFINE_TEST( SwapAndMove )
+    using fudge::string;
+
+    string string1 ( "First" ), string2 ( "Second" ), empty;
+    const FudgeString raw1 ( string1.raw ( ) );
+
+    // Swapping exchanges the references without copying the strings
+    TEST_THROWS_NOTHING( swap ( string1, string2 ) );
+    TEST_EQUALS_TRUE( string2.raw ( ) == raw1 );
+    TEST_EQUALS_TRUE( string1 == string ( "Second" ) );
+    TEST_THROWS_NOTHING( string2.swap ( empty ) );
+    TEST_EQUALS_TRUE( empty.raw ( ) == raw1 );
+    TEST_EQUALS_TRUE( string2.raw ( ) == 0 );
+
+#ifdef FUDGE_CPP_HAS_MOVE
+    string moved ( std::move ( empty ) );
+    TEST_EQUALS_TRUE( moved.raw ( ) == raw1 );
+    TEST_EQUALS_TRUE( empty.raw ( ) == 0 );
+
+    TEST_THROWS_NOTHING( empty = std::move ( moved ) );
+    TEST_EQUALS_TRUE( empty.raw ( ) == raw1 );
+    TEST_EQUALS_TRUE( empty == string ( "First" ) );
+#endif
+END_TEST
+
+DEFINE_TEST( TryCreate )
+    using fudge::string;
+
+    static const fudge_byte utf8 [ ] = { 'a', 'b', 'c' };
+
+    string string1 ( "unchanged" );
+    TEST_EQUALS_INT( string::tryCreate ( string1, utf8, sizeof ( utf8 ), string::UTF8 ), FUDGE_OK );
+    TEST_EQUALS_TRUE( string1 == string ( "abc" ) );
+
+    TEST_EQUALS_INT( string::tryCreate ( string1, utf8, sizeof ( utf8 ), static_cast<string::UnicodeType> ( 99 ) ), FUDGE_STRING_UNKNOWN_UNICODE_TYPE );
+    TEST_EQUALS_INT( string::tryCreate ( string1, 0, 4, string::UTF16 ), FUDGE_NULL_POINTER );
+    TEST_EQUALS_TRUE( string1 == string ( "abc" ) );
+
+    fudge_byte * bytes ( 0 );
+    size_t numbytes ( 0 );
+    TEST_EQUALS_INT( string1.tryConvertToUTF16 ( bytes, numbytes ), FUDGE_OK );
+    TEST_EQUALS_INT( numbytes, 6 );
+    free ( bytes );
+
+    char * ascii ( 0 );
+    TEST_EQUALS_INT( string1.tryConvertToASCIIZ ( ascii ), FUDGE_OK );
+    TEST_EQUALS_TRUE( std::string ( ascii ) == "abc" );
+    free ( ascii );
+END_TEST
+
 DEFINE_TEST_SUITE( String )
     REGISTER_TEST( CreateFromASCII )
     REGISTER_TEST( CreateFromUTF8 )
     REGISTER_TEST( CreateFromUTF16 )
     REGISTER_TEST( CreateFromUTF32 )
     REGISTER_TEST( Comparison )
+    REGISTER_TEST( SwapAndMove )
+    REGISTER_TEST( TryCreate )
 END_TEST_SUITE
 